@@ -14,6 +14,7 @@
 #include <AMReX_DistributionMapping.H>
 #include <AMReX_FabSet.H>
 #include <AMReX_StateData.H>
+#include <AMReX_CArena.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_Print.H>
 
@@ -86,6 +87,8 @@ namespace
     int  insitu_on_restart;
     int  checkpoint_on_restart;
     bool checkpoint_files_output;
+    bool checkpoint_delta;
+    Long spill_old_data_threshold;
     bool precreateDirectories;
     bool prereadFAHeaders;
     VisMF::Header::Version plot_headerversion(VisMF::Header::Version_v1);
@@ -122,6 +125,8 @@ Amr::Initialize ()
     insitu_on_restart        = 0;
     checkpoint_on_restart    = 0;
     checkpoint_files_output  = true;
+    checkpoint_delta         = false;
+    spill_old_data_threshold = 0;
     compute_new_dt_on_regrid = 0;
     precreateDirectories     = true;
     prereadFAHeaders         = true;
@@ -258,6 +263,12 @@ Amr::InitAmr ()
     //
     pp.queryAdd("regrid_on_restart",regrid_on_restart);
     pp.queryAdd("use_efficient_regrid",use_efficient_regrid);
+    {
+        bool spill_old_data = StateData::SpillOldData();
+        pp.queryAdd("spill_old_data", spill_old_data);
+        StateData::SetSpillOldData(spill_old_data);
+        pp.queryAdd("spill_old_data_threshold", spill_old_data_threshold);
+    }
     pp.queryAdd("plotfile_on_restart",plotfile_on_restart);
     pp.queryAdd("insitu_on_restart",insitu_on_restart);
     pp.queryAdd("checkpoint_on_restart",checkpoint_on_restart);
@@ -740,6 +751,8 @@ Amr::deleteDeriveSmallPlotVar (const std::string& name)
 
 Amr::~Amr ()
 {
+    finishCheckPoint();
+
     levelbld->variableCleanUp();
 
     Amr::Finalize();
@@ -1710,6 +1723,8 @@ Amr::checkPoint ()
     BL_PROFILE_REGION_START("Amr::checkPoint()");
     BL_PROFILE("Amr::checkPoint()");
 
+    finishCheckPoint();
+
     VisMF::SetNOutFiles(checkpoint_nfiles);
     //
     // In checkpoint files always write out FABs in NATIVE format.
@@ -1736,8 +1751,9 @@ Amr::checkPoint ()
   amrex::StreamRetry sretry(ckfile, abort_on_stream_retry_failure,
                              stream_max_tries);
 
-  // For AsyncOut, we need to turn off stream retry and write to ckfile directly.
-  const std::string ckfileTemp = (AsyncOut::UseAsyncOut()) ? ckfile : (ckfile + ".temp");
+  // For AsyncOut, stream retry is turned off and ckfileTemp is renamed
+  // by finishCheckPoint once the background writes are done.
+  const std::string ckfileTemp = ckfile + ".temp";
 
   while(sretry.TryFileOutput()) {
 
@@ -1772,6 +1788,13 @@ Amr::checkPoint ()
 
     HeaderFile.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
 
+    //
+    // For AsyncOut the header is built in memory and written by the background thread.
+    //
+    std::ostringstream HeaderStream;
+    std::ostream& HeaderOS = (AsyncOut::UseAsyncOut()) ? static_cast<std::ostream&>(HeaderStream)
+                                                       : static_cast<std::ostream&>(HeaderFile);
+
     int old_prec = 0;
 
     if (ParallelDescriptor::IOProcessor())
@@ -1779,72 +1802,88 @@ Amr::checkPoint ()
         //
         // Only the IOProcessor() writes to the header file.
         //
-        HeaderFile.open(HeaderFileName.c_str(), std::ios::out | std::ios::trunc |
-                                                std::ios::binary);
+        if ( ! AsyncOut::UseAsyncOut()) {
+            HeaderFile.open(HeaderFileName.c_str(), std::ios::out | std::ios::trunc |
+                                                    std::ios::binary);
 
-        if ( ! HeaderFile.good()) {
-            amrex::FileOpenFailed(HeaderFileName);
+            if ( ! HeaderFile.good()) {
+                amrex::FileOpenFailed(HeaderFileName);
+            }
         }
 
-        old_prec = HeaderFile.precision(17);
+        old_prec = HeaderOS.precision(17);
 
-        HeaderFile << CheckPointVersion << '\n'
-                   << AMREX_SPACEDIM       << '\n'
-                   << cumtime           << '\n'
-                   << max_level         << '\n'
-                   << finest_level      << '\n';
+        HeaderOS << CheckPointVersion << '\n'
+                 << AMREX_SPACEDIM       << '\n'
+                 << cumtime           << '\n'
+                 << max_level         << '\n'
+                 << finest_level      << '\n';
         //
         // Write out problem domain.
         //
-        for (int i(0); i <= max_level; ++i) { HeaderFile << Geom(i)        << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i < max_level; ++i)  { HeaderFile << ref_ratio[i]   << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i <= max_level; ++i) { HeaderFile << dt_level[i]    << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i <= max_level; ++i) { HeaderFile << dt_min[i]      << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i <= max_level; ++i) { HeaderFile << n_cycle[i]     << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i <= max_level; ++i) { HeaderFile << level_steps[i] << ' '; }
-        HeaderFile << '\n';
-        for (int i(0); i <= max_level; ++i) { HeaderFile << level_count[i] << ' '; }
-        HeaderFile << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << Geom(i)        << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i < max_level; ++i)  { HeaderOS << ref_ratio[i]   << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << dt_level[i]    << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << dt_min[i]      << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << n_cycle[i]     << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << level_steps[i] << ' '; }
+        HeaderOS << '\n';
+        for (int i(0); i <= max_level; ++i) { HeaderOS << level_count[i] << ' '; }
+        HeaderOS << '\n';
     }
 
     for (int i = 0; i <= finest_level; ++i) {
-        amr_level[i]->checkPointPre(ckfileTemp, HeaderFile);
+        amr_level[i]->checkPointPre(ckfileTemp, HeaderOS);
+    }
+
+    if (checkpoint_delta) {
+        StateData::SetDeltaCheckPoint(ckfileTemp, ckfile);
     }
 
     for (int i = 0; i <= finest_level; ++i) {
-        amr_level[i]->checkPoint(ckfileTemp, HeaderFile);
+        amr_level[i]->checkPoint(ckfileTemp, HeaderOS);
     }
 
+    StateData::SetDeltaCheckPoint(std::string(), std::string());
+
     for (int i = 0; i <= finest_level; ++i) {
-        amr_level[i]->checkPointPost(ckfileTemp, HeaderFile);
+        amr_level[i]->checkPointPost(ckfileTemp, HeaderOS);
     }
 
     if (ParallelDescriptor::IOProcessor()) {
         const Vector<std::string> &FAHeaderNames = StateData::FabArrayHeaderNames();
         if(FAHeaderNames.size() > 0) {
             std::string FAHeaderFilesName = ckfileTemp + "/FabArrayHeaders.txt";
-            std::ofstream FAHeaderFile(FAHeaderFilesName.c_str(),
-                                       std::ios::out | std::ios::trunc |
-                                       std::ios::binary);
-            if ( ! FAHeaderFile.good()) {
-                amrex::FileOpenFailed(FAHeaderFilesName);
-            }
+            auto writeFAHeaders = [FAHeaderFilesName, FAHeaderNames] ()
+            {
+                std::ofstream FAHeaderFile(FAHeaderFilesName.c_str(),
+                                           std::ios::out | std::ios::trunc |
+                                           std::ios::binary);
+                if ( ! FAHeaderFile.good()) {
+                    amrex::FileOpenFailed(FAHeaderFilesName);
+                }
 
-            for(int i(0); i < FAHeaderNames.size(); ++i) {
-                FAHeaderFile << FAHeaderNames[i] << '\n';
+                for(int i(0); i < FAHeaderNames.size(); ++i) {
+                    FAHeaderFile << FAHeaderNames[i] << '\n';
+                }
+            };
+            if (AsyncOut::UseAsyncOut()) {
+                AsyncOut::Submit(std::move(writeFAHeaders));
+            } else {
+                writeFAHeaders();
             }
         }
     }
 
     if(ParallelDescriptor::IOProcessor()) {
-        HeaderFile.precision(old_prec);
+        HeaderOS.precision(old_prec);
 
-        if( ! HeaderFile.good()) {
+        if( ! HeaderOS.good()) {
             amrex::Error("Amr::checkpoint() failed");
         }
     }
@@ -1862,6 +1901,18 @@ Amr::checkPoint ()
     }
 
     if (AsyncOut::UseAsyncOut()) {
+        if (ParallelDescriptor::IOProcessor()) {
+            AsyncOut::Submit([HeaderFileName, header = HeaderStream.str()] ()
+            {
+                std::ofstream ofs(HeaderFileName.c_str(), std::ios::out | std::ios::trunc |
+                                                          std::ios::binary);
+                if ( ! ofs.good()) {
+                    amrex::FileOpenFailed(HeaderFileName);
+                }
+                ofs << header;
+            });
+        }
+        pending_checkpoint = ckfile;
         break;
     } else {
         ParallelDescriptor::Barrier("Amr::checkPoint::end");
@@ -1883,6 +1934,27 @@ Amr::checkPoint ()
   BL_PROFILE_REGION_STOP("Amr::checkPoint()");
 }
 
+void
+Amr::finishCheckPoint ()
+{
+    if (pending_checkpoint.empty()) {
+        return;
+    }
+
+    BL_PROFILE("Amr::finishCheckPoint()");
+
+    AsyncOut::Finish();
+
+    ParallelDescriptor::Barrier("Amr::finishCheckPoint");
+    if (ParallelDescriptor::IOProcessor()) {
+        const std::string ckfileTemp = pending_checkpoint + ".temp";
+        std::rename(ckfileTemp.c_str(), pending_checkpoint.c_str());
+    }
+    ParallelDescriptor::Barrier("Renaming temporary checkPoint file.");
+
+    pending_checkpoint.clear();
+}
+
 void
 Amr::RegridOnly (Real time, bool do_io)
 {
@@ -2072,6 +2144,22 @@ Amr::timeStep (int  level,
 
     amr_level[level]->post_timestep(iteration);
 
+    // The old time data of this level are not needed until its next time
+    // step.  They are paged out only if the spill arena of this process
+    // holds more than spill_old_data_threshold bytes.
+    bool spill = StateData::SpillOldData();
+    if (spill && spill_old_data_threshold > 0)
+    {
+        auto* arena = dynamic_cast<CArena*>(The_Spill_Arena());
+        spill = arena && Long(arena->heap_space_used()) > spill_old_data_threshold;
+    }
+    if (spill)
+    {
+        for (int k = 0; k < amr_level[level]->numStates(); ++k) {
+            amr_level[level]->get_state_data(k).spillOldData();
+        }
+    }
+
     // Set this back to negative so we know whether we are in fact in this routine
     which_level_being_advanced = -1;
 }
@@ -3179,6 +3267,7 @@ Amr::initPltAndChk ()
     ParmParse pp("amr");
 
     pp.queryAdd("checkpoint_files_output", checkpoint_files_output);
+    pp.queryAdd("checkpoint_delta", checkpoint_delta);
     pp.queryAdd("plot_files_output", plot_files_output);
 
     pp.queryAdd("plot_nfiles", plot_nfiles);
@@ -26,6 +26,9 @@ static constexpr int MFOLDDATA = 1;
 
 Vector<std::string> StateData::fabArrayHeaderNames;
 std::map<std::string, Vector<char> > *StateData::faHeaderMap;
+bool StateData::spill_old_data = false;
+std::string StateData::delta_dir;
+std::string StateData::delta_final_dir;
 
 
 StateData::StateData ()
@@ -57,7 +60,9 @@ StateData::StateData (StateData&& rhs) noexcept
       old_time(rhs.old_time),
       new_data(std::move(rhs.new_data)),
       old_data(std::move(rhs.old_data)),
-      arena(rhs.arena)
+      arena(rhs.arena),
+      new_delta(std::move(rhs.new_delta)),
+      old_delta(std::move(rhs.old_delta))
 {
 }
 
@@ -98,7 +103,7 @@ StateData::define (const Box&             p_domain,
     BL_PROFILE("StateData::define()");
     domain = p_domain;
     desc = &d;
-    arena = nullptr;
+    arena = spill_old_data ? The_Spill_Arena() : nullptr;
     grids = grds;
     dmap = dm;
     m_factory.reset(factory.clone());
@@ -182,7 +187,7 @@ StateData::restart (std::istream&          is,
                     const std::string&     chkfile)
 {
     desc = &d;
-    arena = nullptr;
+    arena = spill_old_data ? The_Spill_Arena() : nullptr;
     domain = p_domain;
     grids = grds;
     dmap = dm;
@@ -282,7 +287,7 @@ StateData::restart (const StateDescriptor& d,
                     const StateData& rhs)
 {
     desc = &d;
-    arena = nullptr;
+    arena = spill_old_data ? The_Spill_Arena() : nullptr;
     domain = rhs.domain;
     grids = rhs.grids;
     old_time.start = rhs.old_time.start;
@@ -399,6 +404,14 @@ StateData::swapTimeLevels (Real dt)
     std::swap(old_data, new_data);
 }
 
+void
+StateData::spillOldData ()
+{
+    if (old_data) {
+        old_data->spill();
+    }
+}
+
 void
 StateData::replaceOldData (MultiFab&& mf)
 {
@@ -821,9 +834,16 @@ StateData::checkPoint (const std::string& name,
 
     if (desc->store_in_checkpoint())
     {
+        // Delta checkpoints are written synchronously, they need the hashes now.
+        bool use_delta = ! delta_dir.empty()
+            && fullpathname.compare(0, delta_dir.size(), delta_dir) == 0;
+
         BL_ASSERT(new_data);
         std::string mf_fullpath_new(fullpathname + NewSuffix);
-        if (AsyncOut::UseAsyncOut()) {
+        if (use_delta) {
+            VisMF::WriteDelta(*new_data, mf_fullpath_new, new_delta,
+                              delta_final_dir + mf_fullpath_new.substr(delta_dir.size()), how);
+        } else if (AsyncOut::UseAsyncOut()) {
             VisMF::AsyncWrite(*new_data,mf_fullpath_new);
         } else {
             VisMF::Write(*new_data,mf_fullpath_new,how);
@@ -833,7 +853,10 @@ StateData::checkPoint (const std::string& name,
         {
             BL_ASSERT(old_data);
             std::string mf_fullpath_old(fullpathname + OldSuffix);
-            if (AsyncOut::UseAsyncOut()) {
+            if (use_delta) {
+                VisMF::WriteDelta(*old_data, mf_fullpath_old, old_delta,
+                                  delta_final_dir + mf_fullpath_old.substr(delta_dir.size()), how);
+            } else if (AsyncOut::UseAsyncOut()) {
                 VisMF::AsyncWrite(*old_data,mf_fullpath_old);
             } else {
                 VisMF::Write(*old_data,mf_fullpath_old,how);
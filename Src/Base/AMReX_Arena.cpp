@@ -22,6 +22,13 @@
 #define AMREX_MUNLOCK(x,y) munlock(x,y)
 #endif
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 namespace amrex {
 
 namespace {
@@ -33,6 +40,7 @@ namespace {
     Arena* the_managed_arena = nullptr;
     Arena* the_pinned_arena = nullptr;
     Arena* the_cpu_arena = nullptr;
+    Arena* the_spill_arena = nullptr;
 
     Long the_arena_init_size = 0L;
     Long the_device_arena_init_size = 1024*1024*8;
@@ -49,12 +57,219 @@ namespace {
     bool the_arena_is_managed = true;
 #endif
     bool abort_on_out_of_gpu_memory = false;
+    bool the_arena_thread_cache = false;
+    bool the_arena_segregated_fit = false;
+    std::string the_arena_huge_pages("none");
+    std::string the_arena_numa("none");
+    std::string the_cpu_arena_huge_pages("none");
+    std::string the_cpu_arena_numa("none");
+    std::string the_spill_arena_dir;
+
+#if defined(__linux__)
+    constexpr std::size_t huge_page_size = 2*1024*1024;
+    constexpr int numa_maxnode = 1024;
+    // From linux/mempolicy.h
+    constexpr int numa_mpol_preferred = 1;
+    constexpr int numa_mpol_interleave = 3;
+    constexpr int numa_mpol_f_mems_allowed = 1 << 2;
+
+    bool use_host_mmap (ArenaInfo const& info) noexcept
+    {
+        return info.huge_pages != HugePages::None || info.numa_policy != NumaPolicy::None;
+    }
+
+    std::size_t host_mmap_size (ArenaInfo const& info, std::size_t nbytes) noexcept
+    {
+        return (info.huge_pages != HugePages::None) ? aligned_size(huge_page_size, nbytes) : nbytes;
+    }
+
+    void set_numa_policy (void* p, std::size_t nbytes, NumaPolicy policy)
+    {
+        unsigned long nodemask[numa_maxnode/(8*sizeof(unsigned long))] = {};
+        int mode;
+        if (policy == NumaPolicy::Local) {
+            unsigned int cpu, node;
+            if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) { return; }
+            nodemask[node/(8*sizeof(unsigned long))] |= 1UL << (node%(8*sizeof(unsigned long)));
+            mode = numa_mpol_preferred;
+        } else {
+            if (syscall(SYS_get_mempolicy, nullptr, nodemask, numa_maxnode, nullptr,
+                        numa_mpol_f_mems_allowed) != 0) { return; }
+            mode = numa_mpol_interleave;
+        }
+        // Failure (e.g., no NUMA support in the kernel) leaves the default first-touch policy.
+        syscall(SYS_mbind, p, nbytes, mode, nodemask, numa_maxnode+1, 0);
+    }
+
+    // Map host memory with the huge page and NUMA policies of info.  The
+    // policies have to be set before the pages are touched.
+    void* allocate_host_mmap (ArenaInfo const& info, std::size_t nbytes)
+    {
+        const std::size_t n = host_mmap_size(info, nbytes);
+        void* p = MAP_FAILED;
+        if (info.huge_pages == HugePages::Explicit) {
+            p = mmap(nullptr, n, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+        if (p == MAP_FAILED && info.huge_pages != HugePages::None) {
+            // Align to the huge page size so that the whole range can use huge pages.
+            void* q = mmap(nullptr, n+huge_page_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (q == MAP_FAILED) { return nullptr; }
+            char* lo = static_cast<char*>(q);
+            char* a = reinterpret_cast<char*>(aligned_size(huge_page_size,
+                                                           reinterpret_cast<std::size_t>(lo)));
+            if (a > lo) { munmap(lo, a-lo); }
+            if (a+n < lo+n+huge_page_size) { munmap(a+n, (lo+n+huge_page_size)-(a+n)); }
+            p = a;
+#ifdef MADV_HUGEPAGE
+            madvise(p, n, MADV_HUGEPAGE);
+#endif
+        }
+        if (p == MAP_FAILED) {
+            p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) { return nullptr; }
+        }
+        if (info.numa_policy != NumaPolicy::None) {
+            set_numa_policy(p, n, info.numa_policy);
+        }
+        return p;
+    }
+#endif
+
+#ifndef _WIN32
+    std::size_t spill_page_size () noexcept
+    {
+        static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        return page_size;
+    }
+
+    // Map a new unlinked file in the spill directory.  The kernel writes
+    // its pages back to the file instead of failing under memory pressure.
+    void* allocate_spill (std::size_t nbytes)
+    {
+        std::string fname = the_spill_arena_dir + "/amrex_spill_XXXXXX";
+        int fd = mkstemp(&fname[0]);
+        if (fd < 0) {
+            amrex::Abort("Arena: failed to create spill file in " + the_spill_arena_dir);
+        }
+        unlink(fname.c_str());
+        void* p = nullptr;
+        if (ftruncate(fd, static_cast<off_t>(nbytes)) == 0) {
+            p = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) { p = nullptr; }
+        }
+        close(fd);
+        return p;
+    }
+#endif
+
+    void* allocate_host (ArenaInfo const& info, std::size_t nbytes)
+    {
+#ifndef _WIN32
+        if (info.use_spill_memory) {
+            return allocate_spill(nbytes);
+        }
+#endif
+#if defined(__linux__)
+        if (use_host_mmap(info)) {
+            return allocate_host_mmap(info, nbytes);
+        }
+#else
+        amrex::ignore_unused(info);
+#endif
+        return std::malloc(nbytes);
+    }
+
+    void deallocate_host (ArenaInfo const& info, void* p, std::size_t nbytes)
+    {
+#ifndef _WIN32
+        if (info.use_spill_memory) {
+            if (p) { munmap(p, nbytes); }
+            return;
+        }
+#endif
+#if defined(__linux__)
+        if (use_host_mmap(info)) {
+            if (p) { munmap(p, host_mmap_size(info, nbytes)); }
+            return;
+        }
+#else
+        amrex::ignore_unused(info,nbytes);
+#endif
+        std::free(p);
+    }
+
+    HugePages to_huge_pages (std::string const& s)
+    {
+        if (s == "none") {
+            return HugePages::None;
+        } else if (s == "transparent") {
+            return HugePages::Transparent;
+        } else if (s == "explicit") {
+            return HugePages::Explicit;
+        } else {
+            amrex::Abort("Arena: unknown huge pages option " + s
+                         + ". Must be none, transparent or explicit");
+            return HugePages::None;
+        }
+    }
+
+    NumaPolicy to_numa_policy (std::string const& s)
+    {
+        if (s == "none") {
+            return NumaPolicy::None;
+        } else if (s == "local") {
+            return NumaPolicy::Local;
+        } else if (s == "interleave") {
+            return NumaPolicy::Interleave;
+        } else {
+            amrex::Abort("Arena: unknown NUMA policy " + s
+                         + ". Must be none, local or interleave");
+            return NumaPolicy::None;
+        }
+    }
 }
 
 const std::size_t Arena::align_size;
 
 Arena::~Arena () {}
 
+void
+Arena::pageOut (void* p, std::size_t nbytes) const
+{
+#ifndef _WIN32
+    if (arena_info.use_spill_memory && p && nbytes > 0) {
+        const std::size_t page_size = spill_page_size();
+        auto lo = reinterpret_cast<std::size_t>(p) / page_size * page_size;
+        auto hi = aligned_size(page_size, reinterpret_cast<std::size_t>(p) + nbytes);
+        void* a = reinterpret_cast<void*>(lo);
+        msync(a, hi-lo, MS_SYNC);
+#ifdef MADV_PAGEOUT
+        madvise(a, hi-lo, MADV_PAGEOUT);
+#endif
+        madvise(a, hi-lo, MADV_DONTNEED);
+    }
+#else
+    amrex::ignore_unused(p,nbytes);
+#endif
+}
+
+void
+Arena::pageIn (void* p, std::size_t nbytes) const
+{
+#ifndef _WIN32
+    if (arena_info.use_spill_memory && p && nbytes > 0) {
+        const std::size_t page_size = spill_page_size();
+        auto lo = reinterpret_cast<std::size_t>(p) / page_size * page_size;
+        auto hi = aligned_size(page_size, reinterpret_cast<std::size_t>(p) + nbytes);
+        madvise(reinterpret_cast<void*>(lo), hi-lo, MADV_WILLNEED);
+    }
+#else
+    amrex::ignore_unused(p,nbytes);
+#endif
+}
+
 bool
 Arena::isDeviceAccessible () const
 {
@@ -125,7 +340,7 @@ Arena::allocate_system (std::size_t nbytes)
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
-        p = std::malloc(nbytes);
+        p = allocate_host(arena_info, nbytes);
         if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
     }
     else if (arena_info.device_use_hostalloc)
@@ -171,7 +386,7 @@ Arena::allocate_system (std::size_t nbytes)
         }
     }
 #else
-    p = std::malloc(nbytes);
+    p = allocate_host(arena_info, nbytes);
     if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
 #endif
     if (p == nullptr) amrex::Abort("Sorry, malloc failed");
@@ -185,7 +400,7 @@ Arena::deallocate_system (void* p, std::size_t nbytes)
     if (arena_info.use_cpu_memory)
     {
         if (p && arena_info.device_use_hostalloc) AMREX_MUNLOCK(p, nbytes);
-        std::free(p);
+        deallocate_host(arena_info, p, nbytes);
     }
     else if (arena_info.device_use_hostalloc)
     {
@@ -203,7 +418,7 @@ Arena::deallocate_system (void* p, std::size_t nbytes)
     }
 #else
     if (p && arena_info.device_use_hostalloc) AMREX_MUNLOCK(p, nbytes);
-    std::free(p);
+    deallocate_host(arena_info, p, nbytes);
 #endif
 }
 
@@ -264,11 +479,27 @@ Arena::Initialize ()
     pp.queryAdd(  "the_async_arena_release_threshold",   the_async_arena_release_threshold);
     pp.queryAdd("the_arena_is_managed", the_arena_is_managed);
     pp.queryAdd("abort_on_out_of_gpu_memory", abort_on_out_of_gpu_memory);
+    pp.queryAdd("the_arena_thread_cache", the_arena_thread_cache);
+    pp.queryAdd("the_arena_segregated_fit", the_arena_segregated_fit);
+    pp.queryAdd("the_arena_huge_pages", the_arena_huge_pages);
+    pp.queryAdd("the_arena_numa", the_arena_numa);
+    pp.queryAdd("the_cpu_arena_huge_pages", the_cpu_arena_huge_pages);
+    pp.queryAdd("the_cpu_arena_numa", the_cpu_arena_numa);
+    {
+        const char* tmpdir = std::getenv("TMPDIR");
+        the_spill_arena_dir = tmpdir ? tmpdir : "/tmp";
+        pp.queryAdd("the_spill_arena_dir", the_spill_arena_dir);
+    }
 
     {
-#if defined(BL_COALESCE_FABS) || defined(AMREX_USE_GPU)
+        // The huge page and NUMA policies only apply to host memory.
         ArenaInfo ai{};
         ai.SetReleaseThreshold(the_arena_release_threshold);
+        ai.SetThreadCache(the_arena_thread_cache);
+        ai.SetSegregatedFit(the_arena_segregated_fit);
+        ai.SetHugePages(to_huge_pages(the_arena_huge_pages));
+        ai.SetNumaPolicy(to_numa_policy(the_arena_numa));
+#if defined(BL_COALESCE_FABS) || defined(AMREX_USE_GPU)
         if (the_arena_is_managed) {
             the_arena = new CArena(0, ai.SetPreferred());
         } else {
@@ -279,7 +510,13 @@ Arena::Initialize ()
         the_arena->free(p);
 #endif
 #else
-        the_arena = The_BArena();
+        // BArena has none of these features.
+        if (ai.huge_pages != HugePages::None || ai.numa_policy != NumaPolicy::None ||
+            ai.use_thread_cache || ai.use_segregated_fit) {
+            the_arena = new CArena(0, ai.SetCpuMemory());
+        } else {
+            the_arena = The_BArena();
+        }
 #endif
     }
 
@@ -327,7 +564,22 @@ Arena::Initialize ()
         the_pinned_arena->free(p);
     }
 
-    the_cpu_arena = The_BArena();
+    {
+        ArenaInfo ai{};
+        ai.SetCpuMemory();
+        ai.SetHugePages(to_huge_pages(the_cpu_arena_huge_pages));
+        ai.SetNumaPolicy(to_numa_policy(the_cpu_arena_numa));
+        ai.SetThreadCache(the_arena_thread_cache);
+        if (ai.huge_pages != HugePages::None || ai.numa_policy != NumaPolicy::None ||
+            ai.use_thread_cache) {
+            the_cpu_arena = new CArena(0, ai);
+        } else {
+            the_cpu_arena = The_BArena();
+        }
+    }
+
+    // No file is created until the first allocation.
+    the_spill_arena = new CArena(0, ArenaInfo{}.SetSpillMemory());
 
     // Initialize the null arena
     auto null_arena = The_Null_Arena();
@@ -388,6 +640,18 @@ Arena::PrintUsage ()
             p->PrintUsage("The  Pinned Arena");
         }
     }
+    if (The_Cpu_Arena()) {
+        CArena* p = dynamic_cast<CArena*>(The_Cpu_Arena());
+        if (p) {
+            p->PrintUsage("The     Cpu Arena");
+        }
+    }
+    if (The_Spill_Arena()) {
+        CArena* p = dynamic_cast<CArena*>(The_Spill_Arena());
+        if (p) {
+            p->PrintUsage("The   Spill Arena");
+        }
+    }
 }
 
 void
@@ -433,6 +697,18 @@ Arena::PrintUsageToFiles (const std::string& filename, const std::string& messag
             p->PrintUsage(ofs, "The  Pinned Arena", "    ");
         }
     }
+    if (The_Cpu_Arena()) {
+        CArena* p = dynamic_cast<CArena*>(The_Cpu_Arena());
+        if (p) {
+            p->PrintUsage(ofs, "The     Cpu Arena", "    ");
+        }
+    }
+    if (The_Spill_Arena()) {
+        CArena* p = dynamic_cast<CArena*>(The_Spill_Arena());
+        if (p) {
+            p->PrintUsage(ofs, "The   Spill Arena", "    ");
+        }
+    }
 
     ofs << "\n";
 }
@@ -479,6 +755,9 @@ Arena::Finalize ()
         delete the_cpu_arena;
         the_cpu_arena = nullptr;
     }
+
+    delete the_spill_arena;
+    the_spill_arena = nullptr;
 }
 
 Arena*
@@ -541,4 +820,14 @@ The_Cpu_Arena ()
     }
 }
 
+Arena*
+The_Spill_Arena ()
+{
+    if        (the_spill_arena) {
+        return the_spill_arena;
+    } else {
+        return The_Null_Arena();
+    }
+}
+
 }
@@ -6,6 +6,9 @@
 #include <AMReX_Utility.H>
 #include <AMReX.H>
 
+#include <condition_variable>
+#include <mutex>
+
 namespace amrex {
 namespace AsyncOut {
 
@@ -23,6 +26,11 @@ MPI_Comm s_comm = MPI_COMM_NULL;
 
 std::unique_ptr<BackgroundThread> s_thread;
 
+Long s_max_staged = 0; // 0 means no limit
+Long s_staged = 0;
+std::mutex s_staged_mutx;
+std::condition_variable s_staged_cond;
+
 WriteInfo s_info;
 
 }
@@ -34,6 +42,9 @@ void Initialize ()
     ParmParse pp("amrex");
     pp.queryAdd("async_out", s_asyncout);
     pp.queryAdd("async_out_nfiles", s_noutfiles);
+    Long max_staged_mb = 0;
+    pp.queryAdd("async_out_max_staged_mb", max_staged_mb);
+    s_max_staged = max_staged_mb * 1024 * 1024;
 
     int nprocs = ParallelDescriptor::NProcs();
     s_noutfiles = std::min(s_noutfiles, nprocs);
@@ -111,7 +122,34 @@ void Submit (std::function<void()> const& a_f)
 
 void Finish ()
 {
-    s_thread->Finish();
+    if (s_thread) {
+        s_thread->Finish();
+    }
+}
+
+void ReserveStaging (Long nbytes)
+{
+    std::unique_lock<std::mutex> lck(s_staged_mutx);
+    if (s_max_staged > 0) {
+        s_staged_cond.wait(lck, [=] () -> bool
+                           { return s_staged == 0 || s_staged + nbytes <= s_max_staged; });
+    }
+    s_staged += nbytes;
+}
+
+void ReleaseStaging (Long nbytes)
+{
+    {
+        std::lock_guard<std::mutex> lck(s_staged_mutx);
+        s_staged -= nbytes;
+    }
+    s_staged_cond.notify_all();
+}
+
+Long StagedBytes ()
+{
+    std::lock_guard<std::mutex> lck(s_staged_mutx);
+    return s_staged;
 }
 
 void Wait ()
@@ -5,6 +5,7 @@
 #include <AMReX_Utility.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_BaseFab.H>
+#include <AMReX_ParmParse.H>
 
 #ifdef AMREX_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -12,7 +13,9 @@
 
 #include <AMReX_OpenMP.H>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace amrex {
 
@@ -28,8 +31,88 @@ Long BARef::total_hash_bytes_hwm = 0L;
 bool    BARef::initialized = false;
 bool BoxArray::initialized = false;
 
+BoxArray::IntersectIndex BoxArray::m_intersect_index = BoxArray::HASH;
+
 namespace {
     const int bl_ignore_max = 100000;
+
+    // Maximum number of boxes in a leaf of the BVH.
+    constexpr int bvh_leaf_size = 4;
+    // Subtrees larger than this are built by a separate OpenMP task.
+    constexpr int bvh_task_size = 4096;
+
+    int bvh_num_nodes (int n)
+    {
+        return (n <= bvh_leaf_size) ? 1 : 1 + bvh_num_nodes(n/2) + bvh_num_nodes(n-n/2);
+    }
+
+    //
+    // Build the subtree rooted at inode over index[begin:end).  The nodes are
+    // stored in depth-first order, so the size of every subtree is known in
+    // advance and the two children can be built concurrently.
+    //
+    void bvh_build (Vector<BARef::BVHNode>& nodes, Vector<int>& index,
+                    const Vector<Box>& boxes, int inode, int begin, int end)
+    {
+        const int n = end - begin;
+
+        nodes[inode].begin = begin;
+        nodes[inode].end   = end;
+
+        if (n <= bvh_leaf_size)
+        {
+            IntVect lo = boxes[index[begin]].smallEnd();
+            IntVect hi = boxes[index[begin]].bigEnd();
+            for (int i = begin+1; i < end; ++i) {
+                const Box& bx = boxes[index[i]];
+                lo.min(bx.smallEnd());
+                hi.max(bx.bigEnd());
+            }
+            nodes[inode].lo = lo;
+            nodes[inode].hi = hi;
+            nodes[inode].right = -1;
+            return;
+        }
+
+        //
+        // Split at the median along the direction of the largest spread of box centers.
+        //
+        IntVect clo(std::numeric_limits<int>::max());
+        IntVect chi(std::numeric_limits<int>::lowest());
+        for (int i = begin; i < end; ++i) {
+            const Box& bx = boxes[index[i]];
+            const IntVect c = bx.smallEnd() + bx.bigEnd();
+            clo.min(c);
+            chi.max(c);
+        }
+        const int dir = (chi-clo).maxDir(false);
+
+        const int mid = begin + n/2;
+        std::nth_element(index.begin()+begin, index.begin()+mid, index.begin()+end,
+                         [&boxes,dir] (int a, int b) -> bool
+                         {
+                             return boxes[a].smallEnd(dir) + boxes[a].bigEnd(dir)
+                                 <  boxes[b].smallEnd(dir) + boxes[b].bigEnd(dir);
+                         });
+
+        const int left  = inode + 1;
+        const int right = left + bvh_num_nodes(n/2);
+
+#ifdef AMREX_USE_OMP
+#pragma omp task if (n > bvh_task_size) default(shared) firstprivate(left,begin,mid)
+#endif
+        bvh_build(nodes, index, boxes, left, begin, mid);
+
+        bvh_build(nodes, index, boxes, right, mid, end);
+
+#ifdef AMREX_USE_OMP
+#pragma omp taskwait
+#endif
+
+        nodes[inode].lo = amrex::min(nodes[left].lo, nodes[right].lo);
+        nodes[inode].hi = amrex::max(nodes[left].hi, nodes[right].hi);
+        nodes[inode].right = right;
+    }
 }
 
 BARef::BARef ()
@@ -87,6 +170,7 @@ BARef::~BARef ()
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
+    updateMemoryUsage_bvh(-1);
 #endif
 }
 
@@ -178,10 +262,14 @@ BARef::resize (Long n) {
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
+    updateMemoryUsage_bvh(-1);
 #endif
     m_abox.resize(n);
     hash.clear();
     has_hashmap = false;
+    bvh.clear();
+    bvh_index.clear();
+    has_bvh = false;
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
@@ -222,6 +310,20 @@ BARef::updateMemoryUsage_hash (int s)
         }
     }
 }
+
+void
+BARef::updateMemoryUsage_bvh (int s)
+{
+    if (bvh.size() > 0) {
+        Long b = amrex::bytesOf(bvh) + amrex::bytesOf(bvh_index);
+        if (s > 0) {
+            total_hash_bytes += b;
+            total_hash_bytes_hwm = std::max(total_hash_bytes_hwm, total_hash_bytes);
+        } else {
+            total_hash_bytes -= b;
+        }
+    }
+}
 #endif
 
 void
@@ -260,6 +362,19 @@ BoxArray::Initialize ()
     if (!initialized) {
         initialized = true;
         BARef::Initialize();
+
+        ParmParse pp("boxarray");
+        std::string idx;
+        if (pp.query("intersect_index", idx))
+        {
+            if (idx == "hash") {
+                m_intersect_index = HASH;
+            } else if (idx == "bvh") {
+                m_intersect_index = BVH;
+            } else {
+                amrex::Abort("BoxArray::Initialize(): boxarray.intersect_index must be hash or bvh");
+            }
+        }
     }
 
     amrex::ExecOnFinalize(BoxArray::Finalize);
@@ -269,6 +384,7 @@ void
 BoxArray::Finalize ()
 {
     initialized = false;
+    m_intersect_index = HASH;
 }
 
 BoxArray::BoxArray ()
@@ -1183,6 +1299,19 @@ BoxArray::intersections (const Box&                         bx,
 {
     // This is called too many times BL_PROFILE("BoxArray::intersections()");
 
+    if (m_intersect_index == BVH) {
+        intersections_bvh(bx, isects, first_only, ng);
+    } else {
+        intersections_hash(bx, isects, first_only, ng);
+    }
+}
+
+void
+BoxArray::intersections_hash (const Box&                         bx,
+                              std::vector< std::pair<int,Box> >& isects,
+                              bool                               first_only,
+                              const IntVect&                     ng) const
+{
     BARef::HashType& BoxHashMap = getHashMap();
 
     isects.resize(0);
@@ -1263,6 +1392,72 @@ BoxArray::intersections (const Box&                         bx,
     }
 }
 
+void
+BoxArray::intersections_bvh (const Box&                         bx,
+                             std::vector< std::pair<int,Box> >& isects,
+                             bool                               first_only,
+                             const IntVect&                     ng) const
+{
+    const Vector<BARef::BVHNode>& nodes = getBVH();
+
+    isects.resize(0);
+
+    if (nodes.empty()) return;
+
+    BL_ASSERT(bx.ixType() == ixType());
+
+    //
+    // The search window in the index space of the untransformed boxes.
+    //
+    const Box& gbx = amrex::grow(bx,ng);
+    const IntVect& cr = crseRatio();
+    const IntVect qlo = (gbx.smallEnd() - getDoiHi()) * cr;
+    const IntVect qhi = (gbx.bigEnd()   + getDoiLo() + 1) * cr - 1;
+
+    auto& abox = m_ref->m_abox;
+    const int* index = m_ref->bvh_index.data();
+
+    // The tree is balanced, so its depth is at most about log2(size()).
+    int stack[64];
+    int nstack = 0;
+    stack[nstack++] = 0;
+
+    while (nstack > 0)
+    {
+        const int inode = stack[--nstack];
+        const BARef::BVHNode& node = nodes[inode];
+
+        if (!(node.lo.allLE(qhi) && node.hi.allGE(qlo))) continue;
+
+        if (node.right >= 0)
+        {
+            stack[nstack++] = node.right;
+            stack[nstack++] = inode + 1;
+            continue;
+        }
+
+        for (int i = node.begin; i < node.end; ++i)
+        {
+            const int k = index[i];
+            Box ibox;
+            if (m_bat.is_null()) {
+                ibox = abox[k];
+            } else if (m_bat.is_simple()) {
+                ibox = amrex::convert(amrex::coarsen(abox[k],cr),ixType());
+            } else {
+                ibox = m_bat.m_op.m_bndryReg(abox[k]);
+            }
+            const Box& isect = bx & amrex::grow(ibox,ng);
+
+            if (isect.ok())
+            {
+                isects.push_back(std::pair<int,Box>(k,isect));
+                if (first_only) return;
+            }
+        }
+    }
+}
+
 BoxList
 BoxArray::complementIn (const Box& bx) const
 {
@@ -1280,73 +1475,85 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 
     if (empty()) return;
 
-    BARef::HashType& BoxHashMap = getHashMap();
+    Vector<Box> intersect_boxes;
 
-    BL_ASSERT(bx.ixType() == ixType());
+    if (m_intersect_index == BVH)
+    {
+        std::vector< std::pair<int,Box> > isects;
+        intersections_bvh(bx, isects, false, IntVect::TheZeroVector());
+        for (auto const& is : isects) {
+            intersect_boxes.push_back(is.second);
+        }
+    }
+    else
+    {
+        BARef::HashType& BoxHashMap = getHashMap();
 
-    Box gbx = bx;
+        BL_ASSERT(bx.ixType() == ixType());
 
-    IntVect glo = gbx.smallEnd();
-    IntVect ghi = gbx.bigEnd();
-    const IntVect& doilo = getDoiLo();
-    const IntVect& doihi = getDoiHi();
+        Box gbx = bx;
 
-    gbx.setSmall(glo - doihi).setBig(ghi + doilo);
-    gbx.refine(crseRatio()).coarsen(m_ref->crsn);
+        IntVect glo = gbx.smallEnd();
+        IntVect ghi = gbx.bigEnd();
+        const IntVect& doilo = getDoiLo();
+        const IntVect& doihi = getDoiHi();
 
-    const IntVect& sm = amrex::max(gbx.smallEnd()-1, m_ref->bbox.smallEnd());
-    const IntVect& bg = amrex::min(gbx.bigEnd(),     m_ref->bbox.bigEnd());
+        gbx.setSmall(glo - doihi).setBig(ghi + doilo);
+        gbx.refine(crseRatio()).coarsen(m_ref->crsn);
 
-    Box cbx(sm,bg);
-    cbx.normalize();
+        const IntVect& sm = amrex::max(gbx.smallEnd()-1, m_ref->bbox.smallEnd());
+        const IntVect& bg = amrex::min(gbx.bigEnd(),     m_ref->bbox.bigEnd());
 
-    if (!cbx.intersects(m_ref->bbox)) return;
+        Box cbx(sm,bg);
+        cbx.normalize();
 
-    auto TheEnd = BoxHashMap.cend();
+        if (!cbx.intersects(m_ref->bbox)) return;
 
-    Vector<Box> intersect_boxes;
-    auto& abox = m_ref->m_abox;
-    if (m_bat.is_null()) {
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = abox[index];
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+        auto TheEnd = BoxHashMap.cend();
+
+        auto& abox = m_ref->m_abox;
+        if (m_bat.is_null()) {
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = abox[index];
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
-    } else if (m_bat.is_simple()) {
-        IndexType t = ixType();
-        IntVect cr = crseRatio();
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = amrex::convert(amrex::coarsen(abox[index],cr),t);
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+            });
+        } else if (m_bat.is_simple()) {
+            IndexType t = ixType();
+            IntVect cr = crseRatio();
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = amrex::convert(amrex::coarsen(abox[index],cr),t);
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
-    } else {
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = m_bat.m_op.m_bndryReg(abox[index]);
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+            });
+        } else {
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = m_bat.m_op.m_bndryReg(abox[index]);
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
+            });
+        }
     }
 
     BoxList newbl(bl.ixType());
@@ -1373,6 +1580,16 @@ BoxArray::clear_hash_bin () const
         m_ref->hash.clear();
         m_ref->has_hashmap = false;
     }
+
+    if (!m_ref->bvh.empty())
+    {
+#ifdef AMREX_MEM_PROFILING
+        m_ref->updateMemoryUsage_bvh(-1);
+#endif
+        m_ref->bvh.clear();
+        m_ref->bvh_index.clear();
+        m_ref->has_bvh = false;
+    }
 }
 
 //
@@ -1391,7 +1608,9 @@ BoxArray::removeOverlap (bool simplify)
 
     uniqify();
 
-    BARef::HashType& BoxHashMap = m_ref->hash;
+    // The hash is updated in place below as boxes are added, so it is used
+    // regardless of intersectIndex().
+    BARef::HashType& BoxHashMap = getHashMap();
 
     const Box EmptyBox;
 
@@ -1411,7 +1630,7 @@ BoxArray::removeOverlap (bool simplify)
     {
         if (m_ref->m_abox[i].ok())
         {
-            intersections(m_ref->m_abox[i],isects);
+            intersections_hash(m_ref->m_abox[i],isects,false,IntVect::TheZeroVector());
 
             for (int j = 0, N = isects.size(); j < N; j++)
             {
@@ -1539,6 +1758,50 @@ BoxArray::getHashMap () const
     return BoxHashMap;
 }
 
+const Vector<BARef::BVHNode>&
+BoxArray::getBVH () const
+{
+    Vector<BARef::BVHNode>& nodes = m_ref->bvh;
+
+    if (m_ref->HasBVH()) return nodes;
+
+#ifdef AMREX_USE_OMP
+#pragma omp critical(intersections_lock)
+#endif
+    {
+        if (nodes.empty() && size() > 0)
+        {
+            const int N = size();
+
+            Vector<int>& index = m_ref->bvh_index;
+            index.resize(N);
+            for (int i = 0; i < N; ++i) {
+                index[i] = i;
+            }
+
+            nodes.resize(bvh_num_nodes(N));
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (N > bvh_task_size && !OpenMP::in_parallel())
+#pragma omp single
+#endif
+            bvh_build(nodes, index, m_ref->m_abox, 0, 0, N);
+
+#ifdef AMREX_MEM_PROFILING
+            m_ref->updateMemoryUsage_bvh(1);
+#endif
+
+#ifdef AMREX_USE_OMP
+#pragma omp flush
+#pragma omp atomic write
+#endif
+            m_ref->has_bvh = true;
+        }
+    }
+
+    return nodes;
+}
+
 void
 BoxArray::uniqify ()
 {
@@ -4,12 +4,92 @@
 #include <AMReX_Gpu.H>
 #include <AMReX_ParallelReduce.H>
 
+#include <algorithm>
 #include <utility>
 #include <cstring>
 
 namespace amrex {
 
+namespace {
+    std::atomic<int> carena_next_id{0};
+
+    // The thread caches of the current thread, identified by the ID of their arena.
+    thread_local std::vector<std::pair<int,void*> > carena_thread_caches;
+
+    // Size classes are 16, 32, 48 and 64 bytes, and then four classes
+    // evenly spaced between consecutive powers of two.  They are used by
+    // the thread caches and by the bins of segregated fit.  This returns
+    // the smallest class that can hold nbytes.
+    int carena_size_class (std::size_t nbytes) noexcept
+    {
+        if (nbytes <= 64) {
+            return static_cast<int>((nbytes-1)/16);
+        } else {
+            int p = 6;
+            while ((std::size_t(1) << (p+1)) < nbytes) { ++p; }
+            const std::size_t step = std::size_t(1) << (p-2);
+            const int m = static_cast<int>((nbytes+step-1)/step);
+            return 4 + 4*(p-6) + (m-5);
+        }
+    }
+
+    std::size_t carena_class_size (int c) noexcept
+    {
+        if (c < 4) {
+            return 16*(c+1);
+        } else {
+            const int p = 6 + (c-4)/4;
+            const int m = 5 + (c-4)%4;
+            return std::size_t(m) << (p-2);
+        }
+    }
+
+    // The largest size class whose size does not exceed nbytes.
+    int carena_bin (std::size_t nbytes) noexcept
+    {
+        const int c = carena_size_class(nbytes);
+        return (carena_class_size(c) == nbytes) ? c : c-1;
+    }
+
+    int carena_ctz (std::uint64_t x) noexcept
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        while ((x & 1) == 0) { x >>= 1; ++n; }
+        return n;
+#endif
+    }
+
+    // The number of blocks moved between a thread cache and the free list at
+    // once.  A thread cache keeps at most twice as many free blocks per class.
+    int tcache_batch_size (std::size_t nbytes) noexcept
+    {
+        return static_cast<int>(std::max(std::size_t(1),
+                                         std::min(std::size_t(16), (256*1024)/nbytes)));
+    }
+}
+
+struct CArena::ThreadCache
+{
+    explicit ThreadCache (int nclasses) : free_blocks(nclasses) {}
+
+    //! Free blocks of each size class.  Only accessed by the owning thread.
+    std::vector<std::vector<void*> > free_blocks;
+    //! All blocks owned by this cache and their size classes.  Only accessed by the owning thread.
+    std::unordered_map<void*,int> owned;
+    //! Blocks freed by other threads.  Protected by carena_mutex.
+    std::vector<void*> remote;
+    std::atomic<bool> has_remote{false};
+
+    std::atomic<Long> nhits{0};
+    std::atomic<Long> nmisses{0};
+    std::atomic<Long> nremote{0};
+};
+
 CArena::CArena (std::size_t hunk_size, ArenaInfo info)
+    : m_id(carena_next_id++)
 {
     arena_info = info;
     //
@@ -19,6 +99,10 @@ CArena::CArena (std::size_t hunk_size, ArenaInfo info)
     m_used = 0;
     m_actually_used = 0;
 
+    if (arena_info.use_segregated_fit) {
+        m_sf_bins.resize(NumSegregatedBins);
+    }
+
     BL_ASSERT(m_hunk >= hunk_size);
     BL_ASSERT(m_hunk%Arena::align_size == 0);
 }
@@ -30,17 +114,154 @@ CArena::~CArena ()
     }
 }
 
+std::unique_lock<std::mutex>
+CArena::lock_carena ()
+{
+    std::unique_lock<std::mutex> lock(carena_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        lock.lock();
+        ++m_nlock_wait;
+    }
+    ++m_nlock;
+    return lock;
+}
+
+CArena::ThreadCache&
+CArena::getThreadCache ()
+{
+    for (auto const& tc : carena_thread_caches) {
+        if (tc.first == m_id) {
+            return *static_cast<ThreadCache*>(tc.second);
+        }
+    }
+
+    auto tc = std::make_unique<ThreadCache>(carena_size_class(ThreadCacheMaxSize)+1);
+    ThreadCache* p = tc.get();
+    {
+        auto lock = lock_carena();
+        m_tcache.push_back(std::move(tc));
+    }
+    carena_thread_caches.emplace_back(m_id, p);
+    return *p;
+}
+
+// The blocks have already been counted in m_tcache_free_bytes by free.
+void
+CArena::drain_remote (ThreadCache& tc)
+{
+    for (void* vp : tc.remote) {
+        const int c = tc.owned[vp];
+        tc.free_blocks[c].push_back(vp);
+    }
+    tc.remote.clear();
+    tc.has_remote.store(false, std::memory_order_relaxed);
+}
+
 void*
-CArena::alloc (std::size_t nbytes)
+CArena::alloc_cached (std::size_t nbytes)
+{
+    ThreadCache& tc = getThreadCache();
+
+    if (tc.has_remote.load(std::memory_order_acquire)) {
+        auto lock = lock_carena();
+        drain_remote(tc);
+    }
+
+    const int c = carena_size_class(nbytes);
+    const std::size_t csize = carena_class_size(c);
+    auto& fl = tc.free_blocks[c];
+
+    if (!fl.empty()) {
+        void* vp = fl.back();
+        fl.pop_back();
+        m_tcache_free_bytes -= csize;
+        tc.nhits.fetch_add(1, std::memory_order_relaxed);
+        return vp;
+    }
+
+    tc.nmisses.fetch_add(1, std::memory_order_relaxed);
+
+    //
+    // Refill the cache with a batch of blocks and hand out the first one.
+    //
+    const int nbatch = tcache_batch_size(csize);
+    void* r = nullptr;
+    auto lock = lock_carena();
+    for (int i = 0; i < nbatch; ++i) {
+        void* vp = alloc_protected(csize);
+        m_tcache_owner[vp] = &tc;
+        tc.owned[vp] = c;
+        if (i == 0) {
+            r = vp;
+        } else {
+            fl.push_back(vp);
+            m_tcache_free_bytes += csize;
+        }
+    }
+    return r;
+}
+
+bool
+CArena::free_cached (void* vp)
 {
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    ThreadCache& tc = getThreadCache();
+
+    auto it = tc.owned.find(vp);
+    if (it == tc.owned.end()) { return false; }
+
+    const int c = it->second;
+    const std::size_t csize = carena_class_size(c);
+    auto& fl = tc.free_blocks[c];
+
+    fl.push_back(vp);
+    m_tcache_free_bytes += csize;
 
+    //
+    // Return the oldest half of the free blocks if there are too many.
+    //
+    const int nbatch = tcache_batch_size(csize);
+    if (static_cast<int>(fl.size()) > 2*nbatch) {
+        auto lock = lock_carena();
+        for (int i = 0; i < nbatch; ++i) {
+            tc.owned.erase(fl[i]);
+            m_tcache_owner.erase(fl[i]);
+            free_protected(fl[i]);
+        }
+        fl.erase(fl.begin(), fl.begin()+nbatch);
+        m_tcache_free_bytes -= nbatch*csize;
+    }
+
+    return true;
+}
+
+void*
+CArena::alloc (std::size_t nbytes)
+{
     nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
 
+    if (arena_info.use_thread_cache && nbytes <= ThreadCacheMaxSize) {
+        return alloc_cached(nbytes);
+    }
+
+    auto lock = lock_carena();
+    return alloc_protected(nbytes);
+}
+
+void*
+CArena::alloc_protected (std::size_t nbytes)
+{
     if (static_cast<Long>(m_used+nbytes) >= arena_info.release_threshold) {
         freeUnused_protected();
     }
 
+    if (arena_info.use_segregated_fit) {
+        void* vp = alloc_segregated(nbytes);
+        m_actually_used += nbytes;
+        m_used_hwm = std::max(m_used_hwm, m_used);
+        m_actually_used_hwm = std::max(m_actually_used_hwm, m_actually_used);
+        return vp;
+    }
+
     //
     // Find node in freelist at lowest memory address that'll satisfy request.
     //
@@ -58,6 +279,8 @@ CArena::alloc (std::size_t nbytes)
     {
         const std::size_t N = nbytes < m_hunk ? m_hunk : nbytes;
 
+        m_fragmented_hwm = std::max(m_fragmented_hwm, m_used - heap_space_actually_used());
+
         vp = allocate_system(N);
 
         m_used += N;
@@ -106,6 +329,8 @@ CArena::alloc (std::size_t nbytes)
     }
 
     m_actually_used += nbytes;
+    m_used_hwm = std::max(m_used_hwm, m_used);
+    m_actually_used_hwm = std::max(m_actually_used_hwm, m_actually_used);
 
     BL_ASSERT(!(vp == 0));
 
@@ -122,8 +347,33 @@ CArena::free (void* vp)
         return;
     }
 
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    if (arena_info.use_thread_cache && free_cached(vp)) {
+        return;
+    }
+
+    auto lock = lock_carena();
+
+    if (arena_info.use_thread_cache) {
+        //
+        // A block handed out by the cache of another thread goes back to that cache.
+        //
+        auto owner_it = m_tcache_owner.find(vp);
+        if (owner_it != m_tcache_owner.end()) {
+            ThreadCache* tc = owner_it->second;
+            tc->remote.push_back(vp);
+            m_tcache_free_bytes += m_busylist.find(Node(vp,0,0))->size();
+            tc->nremote.fetch_add(1, std::memory_order_relaxed);
+            tc->has_remote.store(true, std::memory_order_release);
+            return;
+        }
+    }
 
+    free_protected(vp);
+}
+
+void
+CArena::free_protected (void* vp)
+{
     //
     // `vp' had better be in the busy list.
     //
@@ -136,6 +386,14 @@ CArena::free (void* vp)
 
     m_actually_used -= busy_it->size();
 
+    if (arena_info.use_segregated_fit) {
+        void* owner = busy_it->owner();
+        const std::size_t nbytes = busy_it->size();
+        m_busylist.erase(busy_it);
+        free_segregated(vp, owner, nbytes);
+        return;
+    }
+
     //
     // Put free'd block on free list and save iterator to insert()ed position.
     //
@@ -198,10 +456,119 @@ CArena::free (void* vp)
     }
 }
 
+void
+CArena::insert_segregated (void* vp, void* owner, std::size_t nbytes)
+{
+    const int b = std::min(carena_bin(nbytes), NumSegregatedBins-1);
+    m_sf_free.emplace(vp, std::make_pair(owner, nbytes));
+    m_sf_free_end.emplace(static_cast<char*>(vp)+nbytes, vp);
+    m_sf_bins[b].insert(vp);
+    m_sf_nonempty[b/64] |= std::uint64_t(1) << (b%64);
+}
+
+void
+CArena::erase_segregated (void* vp)
+{
+    auto it = m_sf_free.find(vp);
+    BL_ASSERT(it != m_sf_free.end());
+    const std::size_t nbytes = it->second.second;
+    const int b = std::min(carena_bin(nbytes), NumSegregatedBins-1);
+    m_sf_free_end.erase(static_cast<char*>(vp)+nbytes);
+    m_sf_free.erase(it);
+    m_sf_bins[b].erase(vp);
+    if (m_sf_bins[b].empty()) {
+        m_sf_nonempty[b/64] &= ~(std::uint64_t(1) << (b%64));
+    }
+}
+
+void*
+CArena::alloc_segregated (std::size_t nbytes)
+{
+    //
+    // Any block in a bin at or above the size class of the request is big enough.
+    //
+    int bin = -1;
+    const int c = carena_size_class(nbytes);
+    if (c < NumSegregatedBins) {
+        for (int w = c/64; w < NumSegregatedBins/64; ++w) {
+            std::uint64_t mask = m_sf_nonempty[w];
+            if (w == c/64) {
+                mask &= ~std::uint64_t(0) << (c%64);
+            }
+            if (mask != 0) {
+                bin = w*64 + carena_ctz(mask);
+                break;
+            }
+        }
+    }
+    void* vp;
+    void* owner;
+    std::size_t size;
+
+    if (bin < 0)
+    {
+        size = nbytes < m_hunk ? m_hunk : nbytes;
+
+        m_fragmented_hwm = std::max(m_fragmented_hwm, m_used - heap_space_actually_used());
+
+        vp = allocate_system(size);
+
+        m_used += size;
+
+        m_alloc.push_back(std::make_pair(vp,size));
+
+        owner = vp;
+    }
+    else
+    {
+        vp = *m_sf_bins[bin].begin();
+        auto const& block = m_sf_free[vp];
+        owner = block.first;
+        size = block.second;
+        BL_ASSERT(size >= nbytes);
+        erase_segregated(vp);
+    }
+
+    if (size > nbytes) {
+        insert_segregated(static_cast<char*>(vp)+nbytes, owner, size-nbytes);
+    }
+
+    m_busylist.insert(Node(vp, owner, nbytes));
+
+    return vp;
+}
+
+void
+CArena::free_segregated (void* vp, void* owner, std::size_t nbytes)
+{
+    //
+    // Coalesce with the free blocks right below and above this block.
+    //
+    auto lo_it = m_sf_free_end.find(vp);
+    if (lo_it != m_sf_free_end.end()) {
+        void* lo = lo_it->second;
+        auto const& lo_block = m_sf_free[lo];
+        if (lo_block.first == owner) {
+            nbytes += lo_block.second;
+            erase_segregated(lo);
+            vp = lo;
+        }
+    }
+
+    void* hi = static_cast<char*>(vp) + nbytes;
+    auto hi_it = m_sf_free.find(hi);
+    if (hi_it != m_sf_free.end() && hi_it->second.first == owner) {
+        nbytes += hi_it->second.second;
+        erase_segregated(hi);
+    }
+
+    insert_segregated(vp, owner, nbytes);
+}
+
 std::size_t
 CArena::freeUnused ()
 {
-    std::lock_guard<std::mutex> lock(carena_mutex);
+    auto lock = lock_carena();
     return freeUnused_protected();
 }
 
@@ -212,6 +579,19 @@ CArena::freeUnused_protected ()
     m_alloc.erase(std::remove_if(m_alloc.begin(), m_alloc.end(),
                                  [&nbytes,this] (std::pair<void*,std::size_t> a)
                                  {
+                                     if (arena_info.use_segregated_fit) {
+                                         auto it = m_sf_free.find(a.first);
+                                         if (it != m_sf_free.end() &&
+                                             it->second.first  == a.first &&
+                                             it->second.second == a.second)
+                                         {
+                                             erase_segregated(a.first);
+                                             nbytes += a.second;
+                                             deallocate_system(a.first,a.second);
+                                             return true;
+                                         }
+                                         return false;
+                                     }
                                      // We cannot simply use std::set::erase because
                                      // Node::operator== only compares the starting address.
                                      auto it = m_freelist.find(Node(a.first,nullptr,0));
@@ -240,7 +620,42 @@ CArena::heap_space_used () const noexcept
 std::size_t
 CArena::heap_space_actually_used () const noexcept
 {
-    return m_actually_used;
+    return m_actually_used - m_tcache_free_bytes.load(std::memory_order_relaxed);
+}
+
+std::size_t
+CArena::heap_space_used_hwm () const noexcept
+{
+    return m_used_hwm;
+}
+
+std::size_t
+CArena::heap_space_actually_used_hwm () const noexcept
+{
+    return m_actually_used_hwm;
+}
+
+std::size_t
+CArena::heap_space_fragmented_hwm () const noexcept
+{
+    return m_fragmented_hwm;
+}
+
+void
+CArena::FreeBlockStats (Long& nblocks, std::size_t& largest) const
+{
+    largest = 0;
+    if (arena_info.use_segregated_fit) {
+        nblocks = m_sf_free.size();
+        for (auto const& kv : m_sf_free) {
+            largest = std::max(largest, kv.second.second);
+        }
+    } else {
+        nblocks = m_freelist.size();
+        for (auto const& node : m_freelist) {
+            largest = std::max(largest, node.size());
+        }
+    }
 }
 
 std::size_t
@@ -258,6 +673,17 @@ CArena::sizeOf (void* p) const noexcept
     }
 }
 
+void
+CArena::ThreadCacheStats (Long& nhits, Long& nmisses, Long& nremote) const noexcept
+{
+    nhits = nmisses = nremote = 0;
+    for (auto const& tc : m_tcache) {
+        nhits   += tc->nhits.load(std::memory_order_relaxed);
+        nmisses += tc->nmisses.load(std::memory_order_relaxed);
+        nremote += tc->nremote.load(std::memory_order_relaxed);
+    }
+}
+
 void
 CArena::PrintUsage (std::string const& name) const
 {
@@ -279,6 +705,19 @@ CArena::PrintUsage (std::string const& name) const
     amrex::Print() << "[" << name << "] space allocated (MB): " << min_megabytes << "\n";
     amrex::Print() << "[" << name << "] space used      (MB): " << actual_min_megabytes << "\n";
 #endif
+
+    Long nhits, nmisses, nremote;
+    ThreadCacheStats(nhits, nmisses, nremote);
+    Long nlock = m_nlock;
+    Long nlock_wait = m_nlock_wait;
+    ParallelReduce::Sum<Long>({nhits, nmisses, nremote, nlock, nlock_wait},
+                              IOProc, ParallelDescriptor::Communicator());
+    if (arena_info.use_thread_cache) {
+        amrex::Print() << "[" << name << "] thread cache: " << nhits << " hits, "
+                       << nmisses << " misses, " << nremote << " frees by other threads\n";
+    }
+    amrex::Print() << "[" << name << "] lock: " << nlock << " acquisitions, "
+                   << nlock_wait << " had to wait\n";
 }
 
 void
@@ -288,8 +727,24 @@ CArena::PrintUsage (std::ostream& os, std::string const& name, std::string const
     Long actual_megabytes = heap_space_actually_used() / (1024*1024);
     os << space << "[" << name << "] space allocated (MB): " << megabytes << "\n";
     os << space << "[" << name << "] space used      (MB): " << actual_megabytes << "\n";
+    Long nfree;
+    std::size_t largest_free;
+    FreeBlockStats(nfree, largest_free);
     os << space << "[" << name << "]: " << m_alloc.size() << " allocs, "
-       << m_busylist.size() << " busy blocks, " << m_freelist.size() << " free blocks\n";
+       << m_busylist.size() << " busy blocks, " << nfree << " free blocks"
+       << (arena_info.use_segregated_fit ? " (segregated fit)\n" : "\n");
+    os << space << "[" << name << "] largest free block (MB): " << largest_free / (1024*1024)
+       << ", high water mark allocated (MB): " << heap_space_used_hwm() / (1024*1024)
+       << ", used (MB): " << heap_space_actually_used_hwm() / (1024*1024)
+       << ", fragmented (MB): " << heap_space_fragmented_hwm() / (1024*1024) << "\n";
+    if (arena_info.use_thread_cache) {
+        Long nhits, nmisses, nremote;
+        ThreadCacheStats(nhits, nmisses, nremote);
+        os << space << "[" << name << "] thread cache: " << nhits << " hits, "
+           << nmisses << " misses, " << nremote << " frees by other threads\n";
+    }
+    os << space << "[" << name << "] lock: " << m_nlock << " acquisitions, "
+       << m_nlock_wait << " had to wait\n";
 }
 
 }
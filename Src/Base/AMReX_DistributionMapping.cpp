@@ -9,6 +9,7 @@
 #include <AMReX_VisMF.H>
 #include <AMReX_Utility.H>
 #include <AMReX_Morton.H>
+#include <AMReX_Machine.H>
 
 #include <iostream>
 #include <fstream>
@@ -17,6 +18,7 @@
 #include <map>
 #include <vector>
 #include <queue>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <string>
@@ -25,6 +27,10 @@
 
 namespace {
 int flag_verbose_mapper;
+int  graph_halo;
+amrex::Real graph_node_weight;
+amrex::Real graph_imbalance;
+int  graph_passes;
 }
 
 namespace amrex {
@@ -41,6 +47,8 @@ namespace amrex {
 // We default to SFC.
 DistributionMapping::Strategy DistributionMapping::m_Strategy = DistributionMapping::SFC;
 
+DistributionMapping::SFCCurve DistributionMapping::m_SFCCurve = DistributionMapping::MORTON;
+
 DistributionMapping::PVMF DistributionMapping::m_BuildMap = 0;
 
 const Vector<int>&
@@ -74,6 +82,9 @@ DistributionMapping::strategy (DistributionMapping::Strategy how)
     case RRSFC:
         m_BuildMap = &DistributionMapping::RRSFCProcessorMap;
         break;
+    case GRAPH:
+        m_BuildMap = &DistributionMapping::GraphProcessorMap;
+        break;
     default:
         amrex::Error("Bad DistributionMapping::Strategy");
     }
@@ -91,6 +102,18 @@ DistributionMapping::SFC_Threshold ()
     return sfc_threshold;
 }
 
+void
+DistributionMapping::SFC_Curve (DistributionMapping::SFCCurve curve)
+{
+    DistributionMapping::m_SFCCurve = curve;
+}
+
+DistributionMapping::SFCCurve
+DistributionMapping::SFC_Curve ()
+{
+    return DistributionMapping::m_SFCCurve;
+}
+
 bool
 DistributionMapping::operator== (const DistributionMapping& rhs) const noexcept
 {
@@ -115,6 +138,10 @@ DistributionMapping::Initialize ()
     max_efficiency   = 0.9_rt;
     node_size        = 0;
     flag_verbose_mapper = 0;
+    graph_halo          = 1;
+    graph_node_weight   = 4.0_rt;
+    graph_imbalance     = 0.05_rt;
+    graph_passes        = 4;
 
     ParmParse pp("DistributionMapping");
 
@@ -124,6 +151,10 @@ DistributionMapping::Initialize ()
     pp.queryAdd("sfc_threshold",       sfc_threshold);
     pp.queryAdd("node_size",           node_size);
     pp.queryAdd("verbose_mapper",      flag_verbose_mapper);
+    pp.queryAdd("graph_halo",          graph_halo);
+    pp.queryAdd("graph_node_weight",   graph_node_weight);
+    pp.queryAdd("graph_imbalance",     graph_imbalance);
+    pp.queryAdd("graph_passes",        graph_passes);
 
     std::string theStrategy;
 
@@ -145,6 +176,10 @@ DistributionMapping::Initialize ()
         {
             strategy(RRSFC);
         }
+        else if (theStrategy == "GRAPH")
+        {
+            strategy(GRAPH);
+        }
         else
         {
             std::string msg("Unknown strategy: ");
@@ -157,6 +192,26 @@ DistributionMapping::Initialize ()
         strategy(m_Strategy);  // default
     }
 
+    std::string theCurve;
+
+    if (pp.query("sfc_curve", theCurve))
+    {
+        if (theCurve == "MORTON")
+        {
+            SFC_Curve(MORTON);
+        }
+        else if (theCurve == "HILBERT")
+        {
+            SFC_Curve(HILBERT);
+        }
+        else
+        {
+            std::string msg("Unknown sfc_curve: ");
+            msg += theCurve;
+            amrex::Warning(msg.c_str());
+        }
+    }
+
     amrex::ExecOnFinalize(DistributionMapping::Finalize);
 
     initialized = true;
@@ -168,6 +223,7 @@ DistributionMapping::Finalize ()
     initialized = false;
 
     m_Strategy = SFC;
+    m_SFCCurve = MORTON;
 
     DistributionMapping::m_BuildMap = 0;
 }
@@ -933,7 +989,7 @@ SFCToken::Compare::operator () (const SFCToken& lhs,
 namespace {
 
     AMREX_FORCE_INLINE
-    SFCToken makeSFCToken (int box_index, IntVect const& iv)
+    SFCToken makeMortonSFCToken (int box_index, IntVect const& iv)
     {
         SFCToken token;
         token.m_box = box_index;
@@ -995,6 +1051,107 @@ namespace {
 
         return token;
     }
+
+    /*
+    * Convert the coordinates x of a point on a 2^b x ... x 2^b grid in
+    * place to the "transposed" Hilbert index (J. Skilling, Programming the
+    * Hilbert curve, AIP Conf. Proc. 707, 381 (2004)).  Interleaving the
+    * bits of x[0], x[1], ..., x[AMREX_SPACEDIM-1], with x[0] the most
+    * significant, gives the index along the Hilbert curve.
+    */
+    AMREX_FORCE_INLINE
+    void hilbertTranspose (Array<uint32_t,AMREX_SPACEDIM>& x, int b)
+    {
+        const uint32_t m = 1u << (b-1);
+        // Inverse undo
+        for (uint32_t q = m; q > 1; q >>= 1) {
+            const uint32_t p = q - 1;
+            for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+                if (x[i] & q) {
+                    x[0] ^= p; // invert
+                } else {
+                    const uint32_t t = (x[0] ^ x[i]) & p; // exchange
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+        // Gray encode
+        for (int i = 1; i < AMREX_SPACEDIM; ++i) {
+            x[i] ^= x[i-1];
+        }
+        uint32_t t = 0;
+        for (uint32_t q = m; q > 1; q >>= 1) {
+            if (x[AMREX_SPACEDIM-1] & q) { t ^= q-1; }
+        }
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            x[i] ^= t;
+        }
+    }
+
+    AMREX_FORCE_INLINE
+    SFCToken makeHilbertSFCToken (int box_index, IntVect const& iv)
+    {
+        SFCToken token;
+        token.m_box = box_index;
+
+        // The coordinates are shifted the same way as for the Morton order.
+        // The bits are then interleaved in the opposite order so that
+        // m_morton can be compared in the same way.
+
+#if (AMREX_SPACEDIM == 3)
+
+        constexpr int imin = -(1 << 29);
+        AMREX_ASSERT_WITH_MESSAGE(AMREX_D_TERM(iv[0] >= imin && iv[0] < -imin,
+                                            && iv[1] >= imin && iv[1] < -imin,
+                                            && iv[2] >= imin && iv[2] < -imin),
+                                  "SFCToken: index out of range");
+        Array<uint32_t,AMREX_SPACEDIM> x{uint32_t(iv[0] - imin),
+                                         uint32_t(iv[1] - imin),
+                                         uint32_t(iv[2] - imin)};
+        hilbertTranspose(x, 30);
+        for (int i = 0; i < 3; ++i) {
+            token.m_morton[i] = Morton::makeSpace(x[2] & 0x3FF)
+                             | (Morton::makeSpace(x[1] & 0x3FF) << 1)
+                             | (Morton::makeSpace(x[0] & 0x3FF) << 2);
+            x[0] = x[0] >> 10;
+            x[1] = x[1] >> 10;
+            x[2] = x[2] >> 10;
+        }
+
+#elif (AMREX_SPACEDIM == 2)
+
+        constexpr uint32_t offset = 1u << 31;
+        Array<uint32_t,AMREX_SPACEDIM> x;
+        for (int i = 0; i < 2; ++i) {
+            x[i] = (iv[i] >= 0) ? static_cast<uint32_t>(iv[i]) + offset
+                : static_cast<uint32_t>(iv[i]-std::numeric_limits<int>::lowest());
+        }
+        hilbertTranspose(x, 32);
+        token.m_morton[0] = Morton::makeSpace(x[1] & 0xFFFF)
+                         | (Morton::makeSpace(x[0] & 0xFFFF) << 1);
+        token.m_morton[1] = Morton::makeSpace(x[1] >> 16)
+                         | (Morton::makeSpace(x[0] >> 16) << 1);
+
+#elif (AMREX_SPACEDIM == 1)
+
+        // In 1D, the Hilbert curve is the same as the Morton curve.
+        token = makeMortonSFCToken(box_index, iv);
+
+#endif
+
+        return token;
+    }
+
+    AMREX_FORCE_INLINE
+    SFCToken makeSFCToken (int box_index, IntVect const& iv)
+    {
+        if (DistributionMapping::SFC_Curve() == DistributionMapping::HILBERT) {
+            return makeHilbertSFCToken(box_index, iv);
+        } else {
+            return makeMortonSFCToken(box_index, iv);
+        }
+    }
 }
 
 static
@@ -1126,7 +1283,7 @@ DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
         tokens.push_back(makeSFCToken(i, bx.smallEnd()));
     }
     //
-    // Put'm in Morton space filling curve order.
+    // Put'm in space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
     //
@@ -1371,7 +1528,7 @@ DistributionMapping::RRSFCDoIt (const BoxArray&          boxes,
         tokens.push_back(makeSFCToken(i, bx.smallEnd()));
     }
     //
-    // Put'm in Morton space filling curve order.
+    // Put'm in space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
 
@@ -1397,6 +1554,234 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
     RRSFCDoIt(boxes,nprocs);
 }
 
+void
+DistributionMapping::GraphProcessorMapDoIt (const BoxArray&          boxes,
+                                            const std::vector<Long>& wgts,
+                                            int                      nprocs,
+                                            Real*                    eff)
+{
+    BL_PROFILE("DistributionMapping::GraphProcessorMapDoIt()");
+
+    const int N = boxes.size();
+
+    //
+    // The node of each process.  Communication between processes on
+    // different nodes costs graph_node_weight times as much as that on the
+    // same node.  The processes are ordered by node so that consecutive
+    // pieces of the space filling curve are assigned to the same node.
+    // If nprocs is not the size of the current subcommunicator, the
+    // processes are not mapped to ranks we can ask about, so they are all
+    // treated as being on the same node.
+    //
+    Vector<int> node(nprocs, 0);
+#ifdef BL_USE_MPI
+    if (nprocs == ParallelContext::NProcsSub()) {
+        node = machine::node_ids(ParallelContext::CommunicatorSub());
+    }
+#endif
+    Vector<int> ord(nprocs);
+    std::iota(ord.begin(), ord.end(), 0);
+    std::stable_sort(ord.begin(), ord.end(),
+                     [&] (int a, int b) { return node[a] < node[b]; });
+
+    //
+    // Initial partition along the space filling curve.
+    //
+    std::vector<SFCToken> tokens;
+    tokens.reserve(N);
+    Long total_wgt = 0;
+    for (int i = 0; i < N; ++i)
+    {
+        const Box& bx = boxes[i];
+        tokens.push_back(makeSFCToken(i, bx.smallEnd()));
+        total_wgt += wgts[i];
+    }
+    std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+
+    std::vector< std::vector<int> > vec(nprocs);
+    Distribute(tokens, wgts, nprocs, Real(total_wgt)/nprocs, vec);
+
+    Vector<int> part(N);
+    Vector<Long> load(nprocs, 0);
+    Vector<int> count(nprocs, 0);
+    for (int k = 0; k < nprocs; ++k) {
+        const int p = ord[k];
+        for (int i : vec[k]) {
+            part[i] = p;
+            load[p] += wgts[i];
+            ++count[p];
+        }
+    }
+
+    //
+    // The graph of the boxes.  The weight of an edge is the number of
+    // ghost cells exchanged between the two boxes.
+    //
+    Vector<int> adj_offset(N+1, 0);
+    Vector<int> adj_box;
+    Vector<Long> adj_wgt;
+    {
+        Vector<std::map<int,Long> > nbrs(N);
+        std::vector< std::pair<int,Box> > isects;
+        for (int i = 0; i < N; ++i) {
+            boxes.intersections(amrex::grow(boxes[i],graph_halo), isects);
+            for (auto const& is : isects) {
+                const int j = is.first;
+                if (j != i) {
+                    const Long w = is.second.numPts();
+                    nbrs[i][j] += w;
+                    nbrs[j][i] += w;
+                }
+            }
+        }
+        for (int i = 0; i < N; ++i) {
+            adj_offset[i+1] = adj_offset[i] + nbrs[i].size();
+        }
+        adj_box.reserve(adj_offset[N]);
+        adj_wgt.reserve(adj_offset[N]);
+        for (int i = 0; i < N; ++i) {
+            for (auto const& kv : nbrs[i]) {
+                adj_box.push_back(kv.first);
+                adj_wgt.push_back(kv.second);
+            }
+        }
+    }
+
+    auto comm_cost = [&] (int p, int q) -> Real {
+        return (p == q) ? 0.0_rt : ((node[p] == node[q]) ? 1.0_rt : graph_node_weight);
+    };
+
+    auto total_comm = [&] (Real& off_proc, Real& off_node) {
+        off_proc = 0.0_rt;
+        off_node = 0.0_rt;
+        for (int i = 0; i < N; ++i) {
+            for (int e = adj_offset[i]; e < adj_offset[i+1]; ++e) {
+                const int q = part[adj_box[e]];
+                if (q != part[i]) { off_proc += adj_wgt[e]; }
+                if (node[q] != node[part[i]]) { off_node += adj_wgt[e]; }
+            }
+        }
+    };
+
+    Real off_proc_0 = 0.0_rt, off_node_0 = 0.0_rt;
+    if (verbose) { total_comm(off_proc_0, off_node_0); }
+
+    //
+    // Greedy boundary refinement: move a box to the process of one of its
+    // neighbors if that reduces the weighted communication volume without
+    // making the load imbalance worse than allowed.
+    //
+    const Long max_load = std::max(*std::max_element(load.begin(), load.end()),
+                                   Long((1.0_rt+graph_imbalance)*Real(total_wgt)/nprocs));
+    int nmoves = 0;
+    std::map<int,Real> gain;
+    for (int ipass = 0; ipass < graph_passes; ++ipass)
+    {
+        int nmoves_pass = 0;
+        for (auto const& t : tokens)
+        {
+            const int i = t.m_box;
+            const int p = part[i];
+            if (count[p] <= 1) { continue; }
+
+            gain.clear();
+            for (int e = adj_offset[i]; e < adj_offset[i+1]; ++e) {
+                const int q = part[adj_box[e]];
+                if (q != p && load[q] + wgts[i] <= max_load) {
+                    gain[q] = 0.0_rt;
+                }
+            }
+            if (gain.empty()) { continue; }
+
+            for (auto& kv : gain) {
+                const int q = kv.first;
+                Real g = 0.0_rt;
+                for (int e = adj_offset[i]; e < adj_offset[i+1]; ++e) {
+                    const int r = part[adj_box[e]];
+                    g += adj_wgt[e] * (comm_cost(p,r) - comm_cost(q,r));
+                }
+                kv.second = g;
+            }
+
+            auto best = std::max_element(gain.begin(), gain.end(),
+                                         [] (std::pair<const int,Real> const& a,
+                                             std::pair<const int,Real> const& b)
+                                         { return a.second < b.second; });
+            if (best->second > 0.0_rt) {
+                const int q = best->first;
+                part[i] = q;
+                load[p] -= wgts[i];
+                load[q] += wgts[i];
+                --count[p];
+                ++count[q];
+                ++nmoves_pass;
+            }
+        }
+        nmoves += nmoves_pass;
+        if (nmoves_pass == 0) { break; }
+    }
+
+    for (int i = 0; i < N; ++i) {
+        m_ref->m_pmap[i] = ParallelContext::local_to_global_rank(part[i]);
+    }
+
+    if (eff || verbose)
+    {
+        Real sum_wgt = 0, max_wgt = 0;
+        for (int p = 0; p < nprocs; ++p)
+        {
+            max_wgt = std::max(max_wgt, Real(load[p]));
+            sum_wgt += load[p];
+        }
+        Real efficiency = (sum_wgt/(nprocs*max_wgt));
+        if (eff) *eff = efficiency;
+
+        if (verbose)
+        {
+            Real off_proc, off_node;
+            total_comm(off_proc, off_node);
+            amrex::Print() << "GRAPH efficiency: " << efficiency
+                           << ", boxes moved from SFC: " << nmoves
+                           << ", off-process halo cells: " << off_proc_0 << " -> " << off_proc
+                           << ", off-node halo cells: " << off_node_0 << " -> " << off_node
+                           << '\n';
+        }
+    }
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray& boxes,
+                                        int             nprocs)
+{
+    BL_ASSERT(boxes.size() > 0);
+
+    std::vector<Long> wgts;
+
+    wgts.reserve(boxes.size());
+
+    for (int i = 0, N = boxes.size(); i < N; ++i)
+    {
+        wgts.push_back(boxes[i].volume());
+    }
+
+    GraphProcessorMap(boxes, wgts, nprocs);
+}
+
+void
+DistributionMapping::GraphProcessorMap (const BoxArray&          boxes,
+                                        const std::vector<Long>& wgts,
+                                        int                      nprocs,
+                                        Real*                    efficiency)
+{
+    BL_ASSERT(boxes.size() > 0);
+    BL_ASSERT(boxes.size() == static_cast<int>(wgts.size()));
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(wgts.size());
+
+    GraphProcessorMapDoIt(boxes, wgts, nprocs, efficiency);
+}
+
 DistributionMapping
 DistributionMapping::makeKnapSack (const Vector<Real>& rcost, int nmax)
 {
@@ -1754,6 +2139,131 @@ DistributionMapping::makeSFC (const LayoutData<Real>& rcost_local,
     return r;
 }
 
+DistributionMapping
+DistributionMapping::makeIncremental (const DistributionMapping& dm, const Vector<Real>& rcost,
+                                      Real& currentEfficiency, Real& proposedEfficiency,
+                                      Real threshold)
+{
+    BL_PROFILE("makeIncremental");
+
+    AMREX_ALWAYS_ASSERT(dm.size() == rcost.size());
+
+    ComputeDistributionMappingEfficiency(dm, rcost, &currentEfficiency);
+    proposedEfficiency = currentEfficiency;
+
+    const int nprocs = ParallelContext::NProcsSub();
+    const int nboxes = rcost.size();
+    if (nprocs < 2 || nboxes == 0) { return dm; }
+
+    Vector<int> pmap = dm.ProcessorMap();
+
+    // The boxes owned by each process sorted by cost, and the processes
+    // sorted by load.
+    using RIpair = std::pair<Real,int>;
+    Vector<std::set<RIpair> > boxes(nprocs);
+    Vector<Real> load(nprocs, 0.0_rt);
+    for (int i = 0; i < nboxes; ++i) {
+        const int p = ParallelContext::global_to_local_rank(pmap[i]);
+        boxes[p].insert(RIpair(rcost[i], i));
+        load[p] += rcost[i];
+    }
+    std::set<RIpair> procs;
+    for (int p = 0; p < nprocs; ++p) {
+        procs.insert(RIpair(load[p], p));
+    }
+
+    // Repeatedly move a box from the most loaded process to the least
+    // loaded one.  The box is chosen such that the larger of the two new
+    // loads is as small as possible, i.e., its cost is closest to half of
+    // the difference in load.  We stop when that would reduce the load of
+    // the most loaded process by no more than the fraction threshold.
+    int nmoves = 0;
+    for (int imove = 0; imove < nboxes; ++imove)
+    {
+        const int pmax = procs.rbegin()->second;
+        const int pmin = procs.begin()->second;
+        const Real diff = load[pmax] - load[pmin];
+        auto const& bmax = boxes[pmax];
+
+        auto best = bmax.end();
+        Real gain = 0.0_rt;
+        auto it = bmax.lower_bound(RIpair(0.5_rt*diff, -1));
+        for (int n = 0; n < 2; ++n) {
+            if (it != bmax.end() && it->first < diff) {
+                const Real g = std::min(it->first, diff - it->first);
+                if (g > gain) {
+                    gain = g;
+                    best = it;
+                }
+            }
+            if (it == bmax.begin()) { break; }
+            --it;
+        }
+
+        if (best == bmax.end() || gain <= threshold*load[pmax]) { break; }
+
+        const RIpair b = *best;
+        boxes[pmax].erase(best);
+        boxes[pmin].insert(b);
+        procs.erase(RIpair(load[pmax], pmax));
+        procs.erase(RIpair(load[pmin], pmin));
+        load[pmax] -= b.first;
+        load[pmin] += b.first;
+        procs.insert(RIpair(load[pmax], pmax));
+        procs.insert(RIpair(load[pmin], pmin));
+        pmap[b.second] = ParallelContext::local_to_global_rank(pmin);
+        ++nmoves;
+    }
+
+    if (verbose) {
+        amrex::Print() << "DistributionMapping::makeIncremental moved " << nmoves
+                       << " of " << nboxes << " boxes\n";
+    }
+
+    if (nmoves == 0) { return dm; }
+
+    DistributionMapping r(std::move(pmap));
+    ComputeDistributionMappingEfficiency(r, rcost, &proposedEfficiency);
+    return r;
+}
+
+DistributionMapping
+DistributionMapping::makeIncremental (const LayoutData<Real>& rcost_local,
+                                      Real& currentEfficiency, Real& proposedEfficiency,
+                                      Real threshold, bool broadcastToAll, int root)
+{
+    BL_PROFILE("makeIncremental");
+
+    const DistributionMapping& dm = rcost_local.DistributionMap();
+
+    Vector<Real> rcost(rcost_local.size());
+    ParallelDescriptor::GatherLayoutDataToVector<Real>(rcost_local, rcost, root);
+    // rcost is now filled out on root
+
+    DistributionMapping r = dm;
+    if (ParallelDescriptor::MyProc() == root)
+    {
+        r = makeIncremental(dm, rcost, currentEfficiency, proposedEfficiency, threshold);
+    }
+
+#ifdef BL_USE_MPI
+    // Broadcast the new distribution mapping (optional).  If no boxes are
+    // moved, all processes keep the original one.
+    if (broadcastToAll)
+    {
+        Vector<int> pmap = r.ProcessorMap();
+        ParallelDescriptor::Bcast(pmap.data(), pmap.size(), root);
+        if (ParallelDescriptor::MyProc() != root && pmap != dm.ProcessorMap()) {
+            r = DistributionMapping(std::move(pmap));
+        }
+    }
+#else
+    amrex::ignore_unused(broadcastToAll);
+#endif
+
+    return r;
+}
+
 std::vector<std::vector<int> >
 DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, const int nprocs)
 {
@@ -1774,7 +2284,7 @@ DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, const int np
         wgts.push_back(v);
     }
     //
-    // Put'm in Morton space filling curve order.
+    // Put'm in space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
 
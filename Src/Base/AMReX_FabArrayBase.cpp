@@ -5,6 +5,7 @@
 #include <AMReX_Geometry.H>
 #include <AMReX_FArrayBox.H>
 #include <AMReX_NonLocalBC.H>
+#include <AMReX_OpenMP.H>
 
 #include <AMReX_BArena.H>
 #include <AMReX_CArena.H>
@@ -30,6 +31,15 @@ namespace amrex {
 // Set default values in Initialize()!!!
 //
 int     FabArrayBase::MaxComp;
+bool    FabArrayBase::fb_persistent_comm;
+bool    FabArrayBase::fb_neighbor_comm;
+
+#ifdef AMREX_USE_MPI
+namespace {
+    // Pairs of a communicator and its duplicate for persistent requests
+    Vector<std::pair<MPI_Comm,MPI_Comm> > persistent_comms;
+}
+#endif
 
 #if defined(AMREX_USE_GPU)
 
@@ -59,24 +69,27 @@ IntVect FabArrayBase::comm_tile_size(AMREX_D_DECL(1024000, 1024000, 1024000));
 IntVect FabArrayBase::comm_tile_size(AMREX_D_DECL(1024000, 8, 8));
 #endif
 
+FabArrayBase::CacheStats           FabArrayBase::m_TAC_stats("TileArrayCache");
+FabArrayBase::CacheStats           FabArrayBase::m_FBC_stats("FBCache");
+FabArrayBase::CacheStats           FabArrayBase::m_CPC_stats("CopyCache");
+FabArrayBase::CacheStats           FabArrayBase::m_FPinfo_stats("FillPatchCache");
+FabArrayBase::CacheStats           FabArrayBase::m_CFinfo_stats("CrseFineCache");
+
 FabArrayBase::TACache              FabArrayBase::m_TheTileArrayCache;
-FabArrayBase::FBCache              FabArrayBase::m_TheFBCache;
-FabArrayBase::CPCache              FabArrayBase::m_TheCPCache;
+FabArrayBase::FBCache              FabArrayBase::m_TheFBCache(FabArrayBase::m_FBC_stats);
+FabArrayBase::CPCache              FabArrayBase::m_TheCPCache(FabArrayBase::m_CPC_stats);
 FabArrayBase::RB90Cache            FabArrayBase::m_TheRB90Cache;
 FabArrayBase::RB180Cache           FabArrayBase::m_TheRB180Cache;
 FabArrayBase::PolarBCache          FabArrayBase::m_ThePolarBCache;
-FabArrayBase::FPinfoCache          FabArrayBase::m_TheFillPatchCache;
-FabArrayBase::CFinfoCache          FabArrayBase::m_TheCrseFineCache;
+FabArrayBase::FPinfoCache          FabArrayBase::m_TheFillPatchCache(FabArrayBase::m_FPinfo_stats);
+FabArrayBase::CFinfoCache          FabArrayBase::m_TheCrseFineCache(FabArrayBase::m_CFinfo_stats);
 
 #ifdef AMREX_USE_GPU
-std::multimap<FabArrayBase::BDKey,FabArrayBase::ParForInfo*> FabArrayBase::m_TheParForCache;
+FabArrayBase::CacheStats           FabArrayBase::m_ParFor_stats("ParForCache");
+FabArrayBase::MetaDataCache<FabArrayBase::ParForInfo> FabArrayBase::m_TheParForCache(FabArrayBase::m_ParFor_stats);
 #endif
 
-FabArrayBase::CacheStats           FabArrayBase::m_TAC_stats("TileArrayCache");
-FabArrayBase::CacheStats           FabArrayBase::m_FBC_stats("FBCache");
-FabArrayBase::CacheStats           FabArrayBase::m_CPC_stats("CopyCache");
-FabArrayBase::CacheStats           FabArrayBase::m_FPinfo_stats("FillPatchCache");
-FabArrayBase::CacheStats           FabArrayBase::m_CFinfo_stats("CrseFineCache");
+Long FabArrayBase::metadata_cache_max_bytes;
 
 std::map<FabArrayBase::BDKey, int> FabArrayBase::m_BD_count;
 
@@ -89,6 +102,101 @@ namespace
 {
     Arena* the_fa_arena = nullptr;
     bool initialized = false;
+
+    // Hashes used to look up the metadata caches.
+    void hash_combine (std::size_t& seed, std::size_t h) noexcept
+    {
+        seed ^= h + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    std::size_t hash_value (const FabArrayBase::BDKey& k) noexcept
+    {
+        return FabArrayBase::BDKey::Hash()(k);
+    }
+
+    std::size_t hash_value (const IntVect& iv) noexcept
+    {
+        return IntVect::shift_hasher()(iv);
+    }
+
+    std::size_t hash_value (const IndexType& t) noexcept
+    {
+        return hash_value(t.toIntVect());
+    }
+
+    std::size_t hash_value (const Box& b) noexcept
+    {
+        std::size_t seed = hash_value(b.smallEnd());
+        hash_combine(seed, hash_value(b.bigEnd()));
+        hash_combine(seed, hash_value(b.ixType()));
+        return seed;
+    }
+
+    std::size_t hash_value (const Periodicity& p) noexcept
+    {
+        return hash_value(p.Domain());
+    }
+
+#ifdef AMREX_USE_GPU
+    // Only the ParFor cache hashes an int
+    std::size_t hash_value (int i) noexcept
+    {
+        return std::hash<int>()(i);
+    }
+#endif
+
+    std::size_t hash_value (bool b) noexcept
+    {
+        return std::hash<bool>()(b);
+    }
+
+    template <class T, class... Ts>
+    std::size_t metadata_hash (const T& x, const Ts&... xs) noexcept
+    {
+        std::size_t seed = hash_value(x);
+        (void)std::initializer_list<int>{(hash_combine(seed, hash_value(xs)), 0)...};
+        return seed;
+    }
+
+    // Number of threads used to build the tags for nlocal local boxes.
+    int metadata_nthreads (int nlocal) noexcept
+    {
+#ifdef AMREX_USE_OMP
+        return (nlocal > 1 && !omp_in_parallel()) ? omp_get_max_threads() : 1;
+#else
+        amrex::ignore_unused(nlocal);
+        return 1;
+#endif
+    }
+
+    // The thread-local tags are built with a static schedule, so appending
+    // them in thread order reproduces the order of the serial loop.
+    void merge_tags (FabArrayBase::MapOfCopyComTagContainers& tags,
+                     Vector<FabArrayBase::MapOfCopyComTagContainers>& tags_t)
+    {
+        for (auto& m : tags_t) {
+            for (auto& kv : m) {
+                auto& v = tags[kv.first];
+                if (v.empty()) {
+                    v = std::move(kv.second);
+                } else {
+                    v.insert(v.end(), kv.second.begin(), kv.second.end());
+                }
+            }
+        }
+    }
+
+    void merge_tags (FabArrayBase::CopyComTagsContainer& tags,
+                     Vector<FabArrayBase::CopyComTagsContainer>& tags_t)
+    {
+        for (auto& v : tags_t) {
+            if (tags.empty()) {
+                tags = std::move(v);
+            } else {
+                tags.insert(tags.end(), v.begin(), v.end());
+            }
+        }
+    }
 }
 
 void
@@ -101,6 +209,9 @@ FabArrayBase::Initialize ()
     // Set default values here!!!
     //
     FabArrayBase::MaxComp           = 25;
+    FabArrayBase::fb_persistent_comm = false;
+    FabArrayBase::fb_neighbor_comm = false;
+    FabArrayBase::metadata_cache_max_bytes = 0;
 
     ParmParse pp("fabarray");
 
@@ -117,6 +228,9 @@ FabArrayBase::Initialize ()
     }
 
     pp.queryAdd("maxcomp",             FabArrayBase::MaxComp);
+    pp.queryAdd("fb_persistent_comm",  FabArrayBase::fb_persistent_comm);
+    pp.queryAdd("fb_neighbor_comm",    FabArrayBase::fb_neighbor_comm);
+    pp.queryAdd("metadata_cache_max_bytes", FabArrayBase::metadata_cache_max_bytes);
 
     if (MaxComp < 1) {
         MaxComp = 1;
@@ -226,6 +340,17 @@ FabArrayBase::clear ()
     indexArray.clear();
     ownership.clear();
     m_bdkey = BDKey();
+    m_spilled.clear();
+    m_spill_arena = nullptr;
+}
+
+void
+FabArrayBase::unspill () const
+{
+    for (auto const& m : m_spilled) {
+        m_spill_arena->pageIn(m.first, m.second);
+    }
+    m_spilled.clear();
 }
 
 Box
@@ -265,7 +390,7 @@ FabArrayBase::CPC::bytes () const
 Long
 FabArrayBase::FB::bytes () const
 {
-    int cnt = sizeof(FabArrayBase::FB);
+    Long cnt = sizeof(FabArrayBase::FB);
 
     if (m_LocTags)
         cnt += amrex::bytesOf(*m_LocTags);
@@ -276,6 +401,14 @@ FabArrayBase::FB::bytes () const
     if (m_RcvTags)
         cnt += FabArrayBase::bytesOfMapOfCopyComTagContainers(*m_RcvTags);
 
+#ifdef AMREX_USE_MPI
+    if (m_pcomm)
+        cnt += m_pcomm->bytes();
+
+    if (m_ncomm)
+        cnt += m_ncomm->bytes();
+#endif
+
     return cnt;
 }
 
@@ -355,43 +488,55 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
         const int nlocal_dst = imap_dst.size();
         const IntVect& ng_dst = m_dstng;
 
-        std::vector< std::pair<int,Box> > isects;
-
         const std::vector<IntVect>& pshifts = m_period.shiftIntVect();
 
-        auto& send_tags = *m_SndTags;
+        const int nthreads_snd = metadata_nthreads(nlocal_src);
+
+        BL_PROFILE_VAR("FabArrayBase::CPC::define()::send", blp_send);
 
-        for (int i = 0; i < nlocal_src; ++i)
+        Vector<CopyComTag::MapOfCopyComTagContainers> send_tags_t(nthreads_snd);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads_snd)
+#endif
         {
-            const int   k_src = imap_src[i];
-            const Box& bx_src = amrex::grow(ba_src[k_src], ng_src);
+            auto& send_tags = send_tags_t[OpenMP::get_thread_num()];
+            std::vector< std::pair<int,Box> > isects;
 
-            for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+            for (int i = 0; i < nlocal_src; ++i)
             {
-                ba_dst.intersections(bx_src+(*pit), isects, false, ng_dst);
+                const int   k_src = imap_src[i];
+                const Box& bx_src = amrex::grow(ba_src[k_src], ng_src);
 
-                for (int j = 0, M = isects.size(); j < M; ++j)
+                for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
                 {
-                    const int k_dst     = isects[j].first;
-                    const Box& bx       = isects[j].second;
-                    const int dst_owner = dm_dst[k_dst];
+                    ba_dst.intersections(bx_src+(*pit), isects, false, ng_dst);
 
-                    if (ParallelDescriptor::sameTeam(dst_owner)) {
-                        continue; // local copy will be dealt with later
-                    } else if (MyProc == dm_src[k_src]) {
-                        BoxList const bl_dst = m_tgco ? boxDiff(bx, ba_dst[k_dst]) : BoxList(bx);
-                        for (auto const& b : bl_dst) {
-                            send_tags[dst_owner].push_back(CopyComTag(b, b-(*pit), k_dst, k_src));
+                    for (int j = 0, M = isects.size(); j < M; ++j)
+                    {
+                        const int k_dst     = isects[j].first;
+                        const Box& bx       = isects[j].second;
+                        const int dst_owner = dm_dst[k_dst];
+
+                        if (ParallelDescriptor::sameTeam(dst_owner)) {
+                            continue; // local copy will be dealt with later
+                        } else if (MyProc == dm_src[k_src]) {
+                            BoxList const bl_dst = m_tgco ? boxDiff(bx, ba_dst[k_dst]) : BoxList(bx);
+                            for (auto const& b : bl_dst) {
+                                send_tags[dst_owner].push_back(CopyComTag(b, b-(*pit), k_dst, k_src));
+                            }
                         }
                     }
                 }
             }
         }
 
-        auto& recv_tags = *m_RcvTags;
+        merge_tags(*m_SndTags, send_tags_t);
 
-        BoxList bl_local(ba_dst.ixType());
-        BoxList bl_remote(ba_dst.ixType());
+        BL_PROFILE_VAR_STOP(blp_send);
 
         bool check_local = false, check_remote = false;
 #if defined(AMREX_USE_GPU)
@@ -408,36 +553,60 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
             check_local = true;
         }
 
-        for (int i = 0; i < nlocal_dst; ++i)
+        const int nthreads_rcv = metadata_nthreads(nlocal_dst);
+
+        BL_PROFILE_VAR("FabArrayBase::CPC::define()::recv", blp_recv);
+
+        Vector<CopyComTag::MapOfCopyComTagContainers> recv_tags_t(nthreads_rcv);
+        Vector<CopyComTag::CopyComTagsContainer> loc_tags_t(nthreads_rcv);
+        Vector<BoxList> bl_local_t(nthreads_rcv, BoxList(ba_dst.ixType()));
+        Vector<BoxList> bl_remote_t(nthreads_rcv, BoxList(ba_dst.ixType()));
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads_rcv)
+#endif
         {
-            const int   k_dst = imap_dst[i];
-            const Box& bx_dst_valid = ba_dst[k_dst];
-            const Box& bx_dst = amrex::grow(bx_dst_valid, ng_dst);
+            const int tid = OpenMP::get_thread_num();
+            auto& recv_tags = recv_tags_t[tid];
+            auto& loc_tags = loc_tags_t[tid];
+            auto& bl_local = bl_local_t[tid];
+            auto& bl_remote = bl_remote_t[tid];
+            std::vector< std::pair<int,Box> > isects;
 
-            for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+            for (int i = 0; i < nlocal_dst; ++i)
             {
-                ba_src.intersections(bx_dst+(*pit), isects, false, ng_src);
+                const int   k_dst = imap_dst[i];
+                const Box& bx_dst_valid = ba_dst[k_dst];
+                const Box& bx_dst = amrex::grow(bx_dst_valid, ng_dst);
 
-                for (int j = 0, M = isects.size(); j < M; ++j)
+                for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
                 {
-                    const int k_src     = isects[j].first;
-                    const Box& bx       = isects[j].second - *pit;
-                    const int src_owner = dm_src[k_src];
-
-                    BoxList const bl_dst = m_tgco ? boxDiff(bx,bx_dst_valid) : BoxList(bx);
-                    for (auto const& b : bl_dst) {
-                        if (ParallelDescriptor::sameTeam(src_owner, MyProc)) { // local copy
-                            const BoxList tilelist(b, FabArrayBase::comm_tile_size);
-                            for (auto const& btile : tilelist) {
-                                m_LocTags->push_back(CopyComTag(btile, btile+(*pit), k_dst, k_src));
-                            }
-                            if (check_local) {
-                                bl_local.push_back(b);
-                            }
-                        } else if (MyProc == dm_dst[k_dst]) {
-                            recv_tags[src_owner].push_back(CopyComTag(b, b+(*pit), k_dst, k_src));
-                            if (check_remote) {
-                                bl_remote.push_back(b);
+                    ba_src.intersections(bx_dst+(*pit), isects, false, ng_src);
+
+                    for (int j = 0, M = isects.size(); j < M; ++j)
+                    {
+                        const int k_src     = isects[j].first;
+                        const Box& bx       = isects[j].second - *pit;
+                        const int src_owner = dm_src[k_src];
+
+                        BoxList const bl_dst = m_tgco ? boxDiff(bx,bx_dst_valid) : BoxList(bx);
+                        for (auto const& b : bl_dst) {
+                            if (ParallelDescriptor::sameTeam(src_owner, MyProc)) { // local copy
+                                const BoxList tilelist(b, FabArrayBase::comm_tile_size);
+                                for (auto const& btile : tilelist) {
+                                    loc_tags.push_back(CopyComTag(btile, btile+(*pit), k_dst, k_src));
+                                }
+                                if (check_local) {
+                                    bl_local.push_back(b);
+                                }
+                            } else if (MyProc == dm_dst[k_dst]) {
+                                recv_tags[src_owner].push_back(CopyComTag(b, b+(*pit), k_dst, k_src));
+                                if (check_remote) {
+                                    bl_remote.push_back(b);
+                                }
                             }
                         }
                     }
@@ -445,6 +614,20 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
             }
         }
 
+        merge_tags(*m_RcvTags, recv_tags_t);
+        merge_tags(*m_LocTags, loc_tags_t);
+
+        BoxList bl_local(ba_dst.ixType());
+        BoxList bl_remote(ba_dst.ixType());
+        for (int t = 0; t < nthreads_rcv; ++t) {
+            bl_local.join(bl_local_t[t]);
+            bl_remote.join(bl_remote_t[t]);
+        }
+
+        BL_PROFILE_VAR_STOP(blp_recv);
+
+        BL_PROFILE_VAR("FabArrayBase::CPC::define()::threadsafe", blp_threadsafe);
+
         if (bl_local.size() <= 1) {
             m_threadsafe_loc = true;
         } else {
@@ -457,6 +640,10 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
             m_threadsafe_rcv = BoxArray(std::move(bl_remote)).isDisjoint();
         }
 
+        BL_PROFILE_VAR_STOP(blp_threadsafe);
+
+        BL_PROFILE_VAR("FabArrayBase::CPC::define()::sort", blp_sort);
+
         for (int ipass = 0; ipass < 2; ++ipass) // pass 0: send; pass 1: recv
         {
             CopyComTag::MapOfCopyComTagContainers & Tags = (ipass == 0) ? *m_SndTags : *m_RcvTags;
@@ -467,6 +654,8 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
                 std::sort(cctv.begin(), cctv.end());
             }
         }
+
+        BL_PROFILE_VAR_STOP(blp_sort);
     }
 }
 
@@ -520,63 +709,13 @@ FabArrayBase::flushCPC (bool no_assertion) const
     amrex::ignore_unused(no_assertion);
     BL_ASSERT(no_assertion || getBDKey() == m_bdkey);
 
-    std::vector<CPCacheIter> others;
-
-    std::pair<CPCacheIter,CPCacheIter> er_it = m_TheCPCache.equal_range(m_bdkey);
-
-    for (CPCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-        const BDKey& srckey = it->second->m_srcbdk;
-        const BDKey& dstkey = it->second->m_dstbdk;
-
-        BL_ASSERT((srckey==dstkey && srckey==m_bdkey) ||
-                  (m_bdkey==srckey) || (m_bdkey==dstkey));
-
-        if (srckey != dstkey) {
-            const BDKey& otherkey = (m_bdkey == srckey) ? dstkey : srckey;
-            std::pair<CPCacheIter,CPCacheIter> o_er_it = m_TheCPCache.equal_range(otherkey);
-
-            for (CPCacheIter oit = o_er_it.first; oit != o_er_it.second; ++oit)
-            {
-                if (it->second == oit->second)
-                    others.push_back(oit);
-            }
-        }
-
-#ifdef AMREX_MEM_PROFILING
-        m_CPC_stats.bytes -= it->second->bytes();
-#endif
-        m_CPC_stats.recordErase(it->second->m_nuse);
-        delete it->second;
-    }
-
-    m_TheCPCache.erase(er_it.first, er_it.second);
-
-    for (std::vector<CPCacheIter>::iterator it = others.begin(),
-             End = others.end(); it != End; ++it)
-    {
-        m_TheCPCache.erase(*it);
-    }
+    m_TheCPCache.erase(m_bdkey);
 }
 
 void
 FabArrayBase::flushCPCache ()
 {
-    std::vector<CPC*> cpcs;
-    for (CPCacheIter it = m_TheCPCache.begin(); it != m_TheCPCache.end(); ++it)
-    {
-        if (it->first == it->second->m_srcbdk) {
-            m_CPC_stats.recordErase(it->second->m_nuse);
-            cpcs.push_back(it->second);
-        }
-    }
-    for (auto& c : cpcs) {
-        delete c;
-    }
     m_TheCPCache.clear();
-#ifdef AMREX_MEM_PROFILING
-    m_CPC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::CPC&
@@ -592,41 +731,28 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     const BDKey& srckey = src.getBDKey();
     const BDKey& dstkey =     getBDKey();
 
-    std::pair<CPCacheIter,CPCacheIter> er_it = m_TheCPCache.equal_range(dstkey);
-
-    for (CPCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-        if (it->second->m_srcng  == srcng &&
-            it->second->m_dstng  == dstng &&
-            it->second->m_srcbdk == srckey &&
-            it->second->m_dstbdk == dstkey &&
-            it->second->m_period == period &&
-            it->second->m_tgco   == to_ghost_cells_only &&
-            it->second->m_srcba  == src.boxArray() &&
-            it->second->m_dstba  == boxArray())
-        {
-            ++(it->second->m_nuse);
-            m_CPC_stats.recordUse();
-            return *(it->second);
-        }
-    }
+    const std::size_t hash = metadata_hash(dstkey, srckey, dstng, srcng, period,
+                                           to_ghost_cells_only);
+
+    CPC* cpc = m_TheCPCache.find(hash, [&] (CPC const& c) {
+        return c.m_srcng  == srcng &&
+               c.m_dstng  == dstng &&
+               c.m_srcbdk == srckey &&
+               c.m_dstbdk == dstkey &&
+               c.m_period == period &&
+               c.m_tgco   == to_ghost_cells_only &&
+               c.m_srcba  == src.boxArray() &&
+               c.m_dstba  == boxArray();
+    });
+    if (cpc) { return *cpc; }
 
     // Have to build a new one
-    CPC* new_cpc = new CPC(*this, dstng, src, srcng, period, to_ghost_cells_only);
-
-#ifdef AMREX_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif
+    m_TheCPCache.evict(metadata_cache_max_bytes,
+                       [] (CPC const& c) { return c.m_nflight > 0; });
 
-    new_cpc->m_nuse = 1;
-    m_CPC_stats.recordBuild();
-    m_CPC_stats.recordUse();
+    CPC* new_cpc = new CPC(*this, dstng, src, srcng, period, to_ghost_cells_only);
 
-    m_TheCPCache.insert(er_it.second, CPCache::value_type(dstkey,new_cpc));
-    if (srckey != dstkey) {
-        m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
-    }
+    m_TheCPCache.insert(hash, new_cpc, new_cpc->bytes(), dstkey, srckey);
 
     return *new_cpc;
 }
@@ -676,56 +802,69 @@ FabArrayBase::FB::define_fb (const FabArrayBase& fa)
     const int nlocal = imap.size();
     const IntVect& ng = m_ngrow;
     const IntVect ng_ng = m_ngrow - 1;
-    std::vector< std::pair<int,Box> > isects;
 
     const std::vector<IntVect>& pshifts = m_period.shiftIntVect();
 
-    auto& send_tags = *m_SndTags;
+    const int nthreads = metadata_nthreads(nlocal);
 
-    for (int i = 0; i < nlocal; ++i)
+    BL_PROFILE_VAR("FabArrayBase::FB::define_fb()::send", blp_send);
+
+    Vector<CopyComTag::MapOfCopyComTagContainers> send_tags_t(nthreads);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads)
+#endif
     {
-        const int ksnd = imap[i];
-        const Box& vbx = ba[ksnd];
-        const Box& vbx_ng  = amrex::grow(vbx,1);
+        auto& send_tags = send_tags_t[OpenMP::get_thread_num()];
+        std::vector< std::pair<int,Box> > isects;
 
-        for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < nlocal; ++i)
         {
-            ba.intersections(vbx+(*pit), isects, false, ng);
+            const int ksnd = imap[i];
+            const Box& vbx = ba[ksnd];
+            const Box& vbx_ng  = amrex::grow(vbx,1);
 
-            for (int j = 0, M = isects.size(); j < M; ++j)
+            for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
             {
-                const int krcv      = isects[j].first;
-                const Box& bx       = isects[j].second;
-                const int dst_owner = dm[krcv];
+                ba.intersections(vbx+(*pit), isects, false, ng);
 
-                if (ParallelDescriptor::sameTeam(dst_owner)) {
-                    continue;  // local copy will be dealt with later
-                } else if (MyProc == dm[ksnd]) {
-                    BoxList bl = amrex::boxDiff(bx, ba[krcv]);
-                    if (m_multi_ghost)
-                    {
-                        // In the case where ngrow>1, augment the send/rcv box list
-                        // with boxes for overlapping ghost nodes.
-                        const Box& ba_krcv   = amrex::grow(ba[krcv],1);
-                        const Box& dst_bx_ng = (amrex::grow(ba_krcv,ng_ng) & (vbx_ng + (*pit)));
-                        const BoxList &bltmp = ba.complementIn(dst_bx_ng);
-                        for (auto const& btmp : bltmp)
+                for (int j = 0, M = isects.size(); j < M; ++j)
+                {
+                    const int krcv      = isects[j].first;
+                    const Box& bx       = isects[j].second;
+                    const int dst_owner = dm[krcv];
+
+                    if (ParallelDescriptor::sameTeam(dst_owner)) {
+                        continue;  // local copy will be dealt with later
+                    } else if (MyProc == dm[ksnd]) {
+                        BoxList bl = amrex::boxDiff(bx, ba[krcv]);
+                        if (m_multi_ghost)
                         {
-                            bl.join(amrex::boxDiff(btmp,ba_krcv));
+                            // In the case where ngrow>1, augment the send/rcv box list
+                            // with boxes for overlapping ghost nodes.
+                            const Box& ba_krcv   = amrex::grow(ba[krcv],1);
+                            const Box& dst_bx_ng = (amrex::grow(ba_krcv,ng_ng) & (vbx_ng + (*pit)));
+                            const BoxList &bltmp = ba.complementIn(dst_bx_ng);
+                            for (auto const& btmp : bltmp)
+                            {
+                                bl.join(amrex::boxDiff(btmp,ba_krcv));
+                            }
+                            bl.simplify();
                         }
-                        bl.simplify();
+                        for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
+                            send_tags[dst_owner].push_back(CopyComTag(*lit, (*lit)-(*pit), krcv, ksnd));
                     }
-                    for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
-                        send_tags[dst_owner].push_back(CopyComTag(*lit, (*lit)-(*pit), krcv, ksnd));
                 }
             }
         }
     }
 
-    auto& recv_tags = *m_RcvTags;
+    merge_tags(*m_SndTags, send_tags_t);
 
-    BoxList bl_local(ba.ixType());
-    BoxList bl_remote(ba.ixType());
+    BL_PROFILE_VAR_STOP(blp_send);
 
     bool check_local = false, check_remote = false;
 #if defined(AMREX_USE_GPU)
@@ -742,77 +881,117 @@ FabArrayBase::FB::define_fb (const FabArrayBase& fa)
         check_local = true;
     }
 
-    for (int i = 0; i < nlocal; ++i)
+    BL_PROFILE_VAR("FabArrayBase::FB::define_fb()::recv", blp_recv);
+
+    Vector<CopyComTag::MapOfCopyComTagContainers> recv_tags_t(nthreads);
+    Vector<CopyComTag::CopyComTagsContainer> loc_tags_t(nthreads);
+    Vector<BoxList> bl_local_t(nthreads, BoxList(ba.ixType()));
+    Vector<BoxList> bl_remote_t(nthreads, BoxList(ba.ixType()));
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads)
+#endif
     {
-        const int   krcv = imap[i];
-        const Box& vbx   = ba[krcv];
-        const Box& vbx_ng  = amrex::grow(vbx,1);
-        const Box& bxrcv = amrex::grow(vbx, ng);
+        const int tid = OpenMP::get_thread_num();
+        auto& recv_tags = recv_tags_t[tid];
+        auto& loc_tags = loc_tags_t[tid];
+        auto& bl_local = bl_local_t[tid];
+        auto& bl_remote = bl_remote_t[tid];
+        std::vector< std::pair<int,Box> > isects;
 
-        for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < nlocal; ++i)
         {
-            ba.intersections(bxrcv+(*pit), isects);
+            const int   krcv = imap[i];
+            const Box& vbx   = ba[krcv];
+            const Box& vbx_ng  = amrex::grow(vbx,1);
+            const Box& bxrcv = amrex::grow(vbx, ng);
 
-            for (int j = 0, M = isects.size(); j < M; ++j)
+            for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
             {
-                const int ksnd      = isects[j].first;
-                const Box& dst_bx   = isects[j].second - *pit;
-                const int src_owner = dm[ksnd];
+                ba.intersections(bxrcv+(*pit), isects);
 
-                BoxList bl = amrex::boxDiff(dst_bx, vbx);
-
-                if (m_multi_ghost)
-                {
-                    // In the case where ngrow>1, augment the send/rcv box list
-                    // with boxes for overlapping ghost nodes.
-                    Box ba_ksnd = ba[ksnd];
-                    ba_ksnd.grow(1);
-                    const Box dst_bx_ng = (ba_ksnd & (bxrcv + (*pit))) - (*pit);
-                    const BoxList &bltmp = ba.complementIn(dst_bx_ng);
-                    for (auto const& btmp : bltmp)
-                    {
-                        bl.join(amrex::boxDiff(btmp,vbx_ng));
-                    }
-                    bl.simplify();
-                }
-                for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
+                for (int j = 0, M = isects.size(); j < M; ++j)
                 {
-                    const Box& blbx = *lit;
+                    const int ksnd      = isects[j].first;
+                    const Box& dst_bx   = isects[j].second - *pit;
+                    const int src_owner = dm[ksnd];
+
+                    BoxList bl = amrex::boxDiff(dst_bx, vbx);
 
-                    if (ParallelDescriptor::sameTeam(src_owner)) { // local copy
-                        const BoxList tilelist(blbx, FabArrayBase::comm_tile_size);
-                        for (BoxList::const_iterator
-                                 it_tile  = tilelist.begin(),
-                                 End_tile = tilelist.end();   it_tile != End_tile; ++it_tile)
+                    if (m_multi_ghost)
+                    {
+                        // In the case where ngrow>1, augment the send/rcv box list
+                        // with boxes for overlapping ghost nodes.
+                        Box ba_ksnd = ba[ksnd];
+                        ba_ksnd.grow(1);
+                        const Box dst_bx_ng = (ba_ksnd & (bxrcv + (*pit))) - (*pit);
+                        const BoxList &bltmp = ba.complementIn(dst_bx_ng);
+                        for (auto const& btmp : bltmp)
                         {
-                            m_LocTags->push_back(CopyComTag(*it_tile, (*it_tile)+(*pit), krcv, ksnd));
-                        }
-                        if (check_local) {
-                            bl_local.push_back(blbx);
+                            bl.join(amrex::boxDiff(btmp,vbx_ng));
                         }
-                    } else if (MyProc == dm[krcv]) {
-                        recv_tags[src_owner].push_back(CopyComTag(blbx, blbx+(*pit), krcv, ksnd));
-                        if (check_remote) {
-                            bl_remote.push_back(blbx);
+                        bl.simplify();
+                    }
+                    for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
+                    {
+                        const Box& blbx = *lit;
+
+                        if (ParallelDescriptor::sameTeam(src_owner)) { // local copy
+                            const BoxList tilelist(blbx, FabArrayBase::comm_tile_size);
+                            for (BoxList::const_iterator
+                                     it_tile  = tilelist.begin(),
+                                     End_tile = tilelist.end();   it_tile != End_tile; ++it_tile)
+                            {
+                                loc_tags.push_back(CopyComTag(*it_tile, (*it_tile)+(*pit), krcv, ksnd));
+                            }
+                            if (check_local) {
+                                bl_local.push_back(blbx);
+                            }
+                        } else if (MyProc == dm[krcv]) {
+                            recv_tags[src_owner].push_back(CopyComTag(blbx, blbx+(*pit), krcv, ksnd));
+                            if (check_remote) {
+                                bl_remote.push_back(blbx);
+                            }
                         }
                     }
                 }
             }
         }
+    }
 
-        if (bl_local.size() <= 1) {
-            m_threadsafe_loc = true;
-        } else {
-            m_threadsafe_loc = BoxArray(std::move(bl_local)).isDisjoint();
-        }
+    merge_tags(*m_RcvTags, recv_tags_t);
+    merge_tags(*m_LocTags, loc_tags_t);
 
-        if (bl_remote.size() <= 1) {
-            m_threadsafe_rcv = true;
-        } else {
-            m_threadsafe_rcv = BoxArray(std::move(bl_remote)).isDisjoint();
-        }
+    BoxList bl_local(ba.ixType());
+    BoxList bl_remote(ba.ixType());
+    for (int t = 0; t < nthreads; ++t) {
+        bl_local.join(bl_local_t[t]);
+        bl_remote.join(bl_remote_t[t]);
+    }
+
+    BL_PROFILE_VAR_STOP(blp_recv);
+
+    BL_PROFILE_VAR("FabArrayBase::FB::define_fb()::threadsafe", blp_threadsafe);
+
+    if (bl_local.size() <= 1) {
+        m_threadsafe_loc = true;
+    } else {
+        m_threadsafe_loc = BoxArray(std::move(bl_local)).isDisjoint();
+    }
+
+    if (bl_remote.size() <= 1) {
+        m_threadsafe_rcv = true;
+    } else {
+        m_threadsafe_rcv = BoxArray(std::move(bl_remote)).isDisjoint();
     }
 
+    BL_PROFILE_VAR_STOP(blp_threadsafe);
+
+    BL_PROFILE_VAR("FabArrayBase::FB::define_fb()::sort", blp_sort);
+
     for (int ipass = 0; ipass < 2; ++ipass) // pass 0: send; pass 1: recv
     {
         CopyComTag::MapOfCopyComTagContainers & Tags = (ipass == 0) ? *m_SndTags : *m_RcvTags;
@@ -875,6 +1054,8 @@ FabArrayBase::FB::define_fb (const FabArrayBase& fa)
             }
         }
     }
+
+    BL_PROFILE_VAR_STOP(blp_sort);
 }
 
 void
@@ -891,41 +1072,55 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
     const int nlocal = imap.size();
     const IntVect& ng = m_ngrow;
     const IndexType& typ = ba.ixType();
-    std::vector< std::pair<int,Box> > isects;
 
     const std::vector<IntVect>& pshifts = m_period.shiftIntVect();
 
-    auto& send_tags = *m_SndTags;
-
     Box pdomain = m_period.Domain();
     pdomain.convert(typ);
 
-    for (int i = 0; i < nlocal; ++i)
-    {
-        const int ksnd = imap[i];
-        Box bxsnd = amrex::grow(ba[ksnd],ng);
-        bxsnd &= pdomain; // source must be inside the periodic domain.
+    const int nthreads = metadata_nthreads(nlocal);
 
-        if (!bxsnd.ok()) continue;
+    BL_PROFILE_VAR("FabArrayBase::FB::define_epo()::send", blp_send);
 
-        for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
+    Vector<CopyComTag::MapOfCopyComTagContainers> send_tags_t(nthreads);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        auto& send_tags = send_tags_t[OpenMP::get_thread_num()];
+        std::vector< std::pair<int,Box> > isects;
+
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < nlocal; ++i)
         {
-            if (*pit != IntVect::TheZeroVector())
-            {
-                ba.intersections(bxsnd+(*pit), isects, false, ng);
+            const int ksnd = imap[i];
+            Box bxsnd = amrex::grow(ba[ksnd],ng);
+            bxsnd &= pdomain; // source must be inside the periodic domain.
 
-                for (int j = 0, M = isects.size(); j < M; ++j)
+            if (!bxsnd.ok()) continue;
+
+            for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
+            {
+                if (*pit != IntVect::TheZeroVector())
                 {
-                    const int krcv      = isects[j].first;
-                    const Box& bx       = isects[j].second;
-                    const int dst_owner = dm[krcv];
+                    ba.intersections(bxsnd+(*pit), isects, false, ng);
 
-                    if (ParallelDescriptor::sameTeam(dst_owner)) {
-                        continue;  // local copy will be dealt with later
-                    } else if (MyProc == dm[ksnd]) {
-                        const BoxList& bl = amrex::boxDiff(bx, pdomain);
-                        for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit) {
-                            send_tags[dst_owner].push_back(CopyComTag(*lit, (*lit)-(*pit), krcv, ksnd));
+                    for (int j = 0, M = isects.size(); j < M; ++j)
+                    {
+                        const int krcv      = isects[j].first;
+                        const Box& bx       = isects[j].second;
+                        const int dst_owner = dm[krcv];
+
+                        if (ParallelDescriptor::sameTeam(dst_owner)) {
+                            continue;  // local copy will be dealt with later
+                        } else if (MyProc == dm[ksnd]) {
+                            const BoxList& bl = amrex::boxDiff(bx, pdomain);
+                            for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit) {
+                                send_tags[dst_owner].push_back(CopyComTag(*lit, (*lit)-(*pit), krcv, ksnd));
+                            }
                         }
                     }
                 }
@@ -933,10 +1128,9 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
         }
     }
 
-    auto& recv_tags = *m_RcvTags;
+    merge_tags(*m_SndTags, send_tags_t);
 
-    BoxList bl_local(ba.ixType());
-    BoxList bl_remote(ba.ixType());
+    BL_PROFILE_VAR_STOP(blp_send);
 
     bool check_local = false, check_remote = false;
 #if defined(AMREX_USE_GPU)
@@ -953,50 +1147,72 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
         check_local = true;
     }
 
-    for (int i = 0; i < nlocal; ++i)
-    {
-        const int   krcv = imap[i];
-        const Box& vbx   = ba[krcv];
-        const Box& bxrcv = amrex::grow(vbx, ng);
+    BL_PROFILE_VAR("FabArrayBase::FB::define_epo()::recv", blp_recv);
+
+    Vector<CopyComTag::MapOfCopyComTagContainers> recv_tags_t(nthreads);
+    Vector<CopyComTag::CopyComTagsContainer> loc_tags_t(nthreads);
+    Vector<BoxList> bl_local_t(nthreads, BoxList(ba.ixType()));
+    Vector<BoxList> bl_remote_t(nthreads, BoxList(ba.ixType()));
 
-        if (pdomain.contains(bxrcv)) continue;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        const int tid = OpenMP::get_thread_num();
+        auto& recv_tags = recv_tags_t[tid];
+        auto& loc_tags = loc_tags_t[tid];
+        auto& bl_local = bl_local_t[tid];
+        auto& bl_remote = bl_remote_t[tid];
+        std::vector< std::pair<int,Box> > isects;
 
-        for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
+#ifdef AMREX_USE_OMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < nlocal; ++i)
         {
-            if (*pit != IntVect::TheZeroVector())
-            {
-                ba.intersections(bxrcv+(*pit), isects, false, ng);
+            const int   krcv = imap[i];
+            const Box& vbx   = ba[krcv];
+            const Box& bxrcv = amrex::grow(vbx, ng);
 
-                for (int j = 0, M = isects.size(); j < M; ++j)
-                {
-                    const int ksnd      = isects[j].first;
-                    const Box& dst_bx   = isects[j].second - *pit;
-                    const int src_owner = dm[ksnd];
+            if (pdomain.contains(bxrcv)) continue;
 
-                    const BoxList& bl = amrex::boxDiff(dst_bx, pdomain);
+            for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
+            {
+                if (*pit != IntVect::TheZeroVector())
+                {
+                    ba.intersections(bxrcv+(*pit), isects, false, ng);
 
-                    for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
+                    for (int j = 0, M = isects.size(); j < M; ++j)
                     {
-                        Box sbx = (*lit) + (*pit);
-                        sbx &= pdomain; // source must be inside the periodic domain.
-
-                        if (sbx.ok()) {
-                            Box dbx = sbx - (*pit);
-                            if (ParallelDescriptor::sameTeam(src_owner)) { // local copy
-                                const BoxList tilelist(dbx, FabArrayBase::comm_tile_size);
-                                for (BoxList::const_iterator
-                                         it_tile  = tilelist.begin(),
-                                         End_tile = tilelist.end();   it_tile != End_tile; ++it_tile)
-                                {
-                                    m_LocTags->push_back(CopyComTag(*it_tile, (*it_tile)+(*pit), krcv, ksnd));
-                                }
-                                if (check_local) {
-                                    bl_local.push_back(dbx);
-                                }
-                            } else if (MyProc == dm[krcv]) {
-                                recv_tags[src_owner].push_back(CopyComTag(dbx, sbx, krcv, ksnd));
-                                if (check_remote) {
-                                    bl_remote.push_back(dbx);
+                        const int ksnd      = isects[j].first;
+                        const Box& dst_bx   = isects[j].second - *pit;
+                        const int src_owner = dm[ksnd];
+
+                        const BoxList& bl = amrex::boxDiff(dst_bx, pdomain);
+
+                        for (BoxList::const_iterator lit = bl.begin(); lit != bl.end(); ++lit)
+                        {
+                            Box sbx = (*lit) + (*pit);
+                            sbx &= pdomain; // source must be inside the periodic domain.
+
+                            if (sbx.ok()) {
+                                Box dbx = sbx - (*pit);
+                                if (ParallelDescriptor::sameTeam(src_owner)) { // local copy
+                                    const BoxList tilelist(dbx, FabArrayBase::comm_tile_size);
+                                    for (BoxList::const_iterator
+                                             it_tile  = tilelist.begin(),
+                                             End_tile = tilelist.end();   it_tile != End_tile; ++it_tile)
+                                    {
+                                        loc_tags.push_back(CopyComTag(*it_tile, (*it_tile)+(*pit), krcv, ksnd));
+                                    }
+                                    if (check_local) {
+                                        bl_local.push_back(dbx);
+                                    }
+                                } else if (MyProc == dm[krcv]) {
+                                    recv_tags[src_owner].push_back(CopyComTag(dbx, sbx, krcv, ksnd));
+                                    if (check_remote) {
+                                        bl_remote.push_back(dbx);
+                                    }
                                 }
                             }
                         }
@@ -1004,20 +1220,38 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
                 }
             }
         }
+    }
 
-        if (bl_local.size() <= 1) {
-            m_threadsafe_loc = true;
-        } else {
-            m_threadsafe_loc = BoxArray(std::move(bl_local)).isDisjoint();
-        }
+    merge_tags(*m_RcvTags, recv_tags_t);
+    merge_tags(*m_LocTags, loc_tags_t);
 
-        if (bl_remote.size() <= 1) {
-            m_threadsafe_rcv = true;
-        } else {
-            m_threadsafe_rcv = BoxArray(std::move(bl_remote)).isDisjoint();
-        }
+    BoxList bl_local(ba.ixType());
+    BoxList bl_remote(ba.ixType());
+    for (int t = 0; t < nthreads; ++t) {
+        bl_local.join(bl_local_t[t]);
+        bl_remote.join(bl_remote_t[t]);
+    }
+
+    BL_PROFILE_VAR_STOP(blp_recv);
+
+    BL_PROFILE_VAR("FabArrayBase::FB::define_epo()::threadsafe", blp_threadsafe);
+
+    if (bl_local.size() <= 1) {
+        m_threadsafe_loc = true;
+    } else {
+        m_threadsafe_loc = BoxArray(std::move(bl_local)).isDisjoint();
     }
 
+    if (bl_remote.size() <= 1) {
+        m_threadsafe_rcv = true;
+    } else {
+        m_threadsafe_rcv = BoxArray(std::move(bl_remote)).isDisjoint();
+    }
+
+    BL_PROFILE_VAR_STOP(blp_threadsafe);
+
+    BL_PROFILE_VAR("FabArrayBase::FB::define_epo()::sort", blp_sort);
+
     for (int ipass = 0; ipass < 2; ++ipass) // pass 0: send; pass 1: recv
     {
         CopyComTag::MapOfCopyComTagContainers & Tags = (ipass == 0) ? *m_SndTags : *m_RcvTags;
@@ -1028,40 +1262,215 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
             std::sort(cctv.begin(), cctv.end());
         }
     }
+
+    BL_PROFILE_VAR_STOP(blp_sort);
 }
 
 FabArrayBase::FB::~FB ()
 {}
 
+#ifdef AMREX_USE_MPI
+
+namespace {
+    template <typename T>
+    void fb_send_init (char* buf, std::size_t nbytes, int rank, int tag, MPI_Comm comm,
+                       MPI_Request* req)
+    {
+        BL_MPI_REQUIRE( MPI_Send_init(reinterpret_cast<T*>(buf), nbytes/sizeof(T),
+                                      ParallelDescriptor::Mpi_typemap<T>::type(),
+                                      rank, tag, comm, req) );
+    }
+
+    template <typename T>
+    void fb_recv_init (char* buf, std::size_t nbytes, int rank, int tag, MPI_Comm comm,
+                       MPI_Request* req)
+    {
+        BL_MPI_REQUIRE( MPI_Recv_init(reinterpret_cast<T*>(buf), nbytes/sizeof(T),
+                                      ParallelDescriptor::Mpi_typemap<T>::type(),
+                                      rank, tag, comm, req) );
+    }
+
+    // The message is described with the same data type as the one
+    // ParallelDescriptor::Asend and Arecv would use, so that CheckRcvStats
+    // can be used on the statuses.
+    void fb_comm_init (bool is_send, char* buf, std::size_t nbytes, int rank, int tag,
+                       MPI_Comm comm, MPI_Request* req)
+    {
+        const int comm_data_type = ParallelDescriptor::select_comm_data_type(nbytes);
+        if (comm_data_type == 1) {
+            if (is_send) {
+                fb_send_init<char>(buf, nbytes, rank, tag, comm, req);
+            } else {
+                fb_recv_init<char>(buf, nbytes, rank, tag, comm, req);
+            }
+        } else if (comm_data_type == 2) {
+            if (is_send) {
+                fb_send_init<unsigned long long>(buf, nbytes, rank, tag, comm, req);
+            } else {
+                fb_recv_init<unsigned long long>(buf, nbytes, rank, tag, comm, req);
+            }
+        } else if (comm_data_type == 3) {
+            if (is_send) {
+                fb_send_init<ParallelDescriptor::lull_t>(buf, nbytes, rank, tag, comm, req);
+            } else {
+                fb_recv_init<ParallelDescriptor::lull_t>(buf, nbytes, rank, tag, comm, req);
+            }
+        } else {
+            amrex::Abort("TODO: message size is too big");
+        }
+    }
+}
+
+FabArrayBase::FB::PersistentComm::~PersistentComm ()
+{
+    int mpi_finalized = 0;
+    MPI_Finalized(&mpi_finalized);
+    if (!mpi_finalized) {
+        for (auto& req : recv_reqs) {
+            if (req != MPI_REQUEST_NULL) { MPI_Request_free(&req); }
+        }
+        for (auto& req : send_reqs) {
+            if (req != MPI_REQUEST_NULL) { MPI_Request_free(&req); }
+        }
+    }
+    if (m_arena) {
+        if (the_recv_data) { m_arena->free(the_recv_data); }
+        if (the_send_data) { m_arena->free(the_send_data); }
+    }
+}
+
+void
+FabArrayBase::FB::PersistentComm::initRequests ()
+{
+    // Messages of zero size have been removed so that all the requests
+    // are valid for MPI_Startall.
+    const int nrecv = recv_from.size();
+    recv_reqs.assign(nrecv, MPI_REQUEST_NULL);
+    recv_stat.resize(nrecv);
+    for (int i = 0; i < nrecv; ++i) {
+        AMREX_ASSERT(recv_size[i] > 0);
+        const int rank = ParallelContext::global_to_local_rank(recv_from[i]);
+        fb_comm_init(false, recv_data[i], recv_size[i], rank, m_tag, m_comm, &recv_reqs[i]);
+    }
+
+    const int nsend = send_rank.size();
+    send_reqs.assign(nsend, MPI_REQUEST_NULL);
+    for (int i = 0; i < nsend; ++i) {
+        AMREX_ASSERT(send_size[i] > 0);
+        const int rank = ParallelContext::global_to_local_rank(send_rank[i]);
+        fb_comm_init(true, send_data[i], send_size[i], rank, m_tag, m_comm, &send_reqs[i]);
+    }
+}
+
+void
+FabArrayBase::FB::PersistentComm::startRecvs ()
+{
+    if (!recv_reqs.empty()) {
+        BL_MPI_REQUIRE( MPI_Startall(recv_reqs.size(), recv_reqs.data()) );
+    }
+}
+
+void
+FabArrayBase::FB::PersistentComm::startSends ()
+{
+    if (!send_reqs.empty()) {
+        BL_MPI_REQUIRE( MPI_Startall(send_reqs.size(), send_reqs.data()) );
+    }
+}
+
+MPI_Comm
+FabArrayBase::getPersistentCommunicator (MPI_Comm comm)
+{
+    for (auto const& p : persistent_comms) {
+        if (p.first == comm) { return p.second; }
+    }
+    MPI_Comm dup;
+    BL_MPI_REQUIRE( MPI_Comm_dup(comm, &dup) );
+    persistent_comms.emplace_back(comm, dup);
+    return dup;
+}
+
+FabArrayBase::FB::NeighborComm::~NeighborComm ()
+{
+    int mpi_finalized = 0;
+    MPI_Finalized(&mpi_finalized);
+    if (!mpi_finalized && m_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_comm);
+    }
+}
+
+FabArrayBase::FB::NeighborComm const&
+FabArrayBase::FB::getNeighborComm () const
+{
+    MPI_Comm comm = ParallelContext::CommunicatorSub();
+    if (m_ncomm && m_ncomm->m_parent == comm) {
+        return *m_ncomm;
+    }
+
+    BL_PROFILE("FabArrayBase::FB::getNeighborComm()");
+
+    m_ncomm = std::make_unique<NeighborComm>();
+    m_ncomm->m_parent = comm;
+
+    Vector<int> sources;
+    for (auto const& kv : *m_RcvTags) {
+        sources.push_back(ParallelContext::global_to_local_rank(kv.first));
+        m_ncomm->recv_cctc.push_back(&kv.second);
+    }
+
+    Vector<int> destinations;
+    for (auto const& kv : *m_SndTags) {
+        destinations.push_back(ParallelContext::global_to_local_rank(kv.first));
+        m_ncomm->send_cctc.push_back(&kv.second);
+    }
+
+    // No reordering so that the ranks in comm and m_comm are the same.
+    BL_MPI_REQUIRE( MPI_Dist_graph_create_adjacent(comm,
+                                                   sources.size(), sources.data(), MPI_UNWEIGHTED,
+                                                   destinations.size(), destinations.data(), MPI_UNWEIGHTED,
+                                                   MPI_INFO_NULL, 0, &(m_ncomm->m_comm)) );
+
+    m_TheFBCache.updateBytes(this, bytes());
+
+    return *m_ncomm;
+}
+
+Long
+FabArrayBase::FB::NeighborComm::bytes () const
+{
+    return sizeof(NeighborComm) + amrex::bytesOf(recv_cctc) + amrex::bytesOf(send_cctc);
+}
+
+Long
+FabArrayBase::FB::PersistentComm::bytes () const
+{
+    Long cnt = sizeof(PersistentComm)
+        + amrex::bytesOf(recv_from) + amrex::bytesOf(recv_data)
+        + amrex::bytesOf(recv_size) + amrex::bytesOf(recv_reqs)
+        + amrex::bytesOf(recv_stat) + amrex::bytesOf(recv_cctc)
+        + amrex::bytesOf(send_rank) + amrex::bytesOf(send_data)
+        + amrex::bytesOf(send_size) + amrex::bytesOf(send_reqs)
+        + amrex::bytesOf(send_cctc);
+    // The buffers
+    for (auto n : recv_size) { cnt += n; }
+    for (auto n : send_size) { cnt += n; }
+    return cnt;
+}
+
+#endif
+
 void
 FabArrayBase::flushFB (bool no_assertion) const
 {
     amrex::ignore_unused(no_assertion);
     BL_ASSERT(no_assertion || getBDKey() == m_bdkey);
-    std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
-    for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-#ifdef AMREX_MEM_PROFILING
-        m_FBC_stats.bytes -= it->second->bytes();
-#endif
-        m_FBC_stats.recordErase(it->second->m_nuse);
-        delete it->second;
-    }
-    m_TheFBCache.erase(er_it.first, er_it.second);
+    m_TheFBCache.erase(m_bdkey);
 }
 
 void
 FabArrayBase::flushFBCache ()
 {
-    for (FBCacheIter it = m_TheFBCache.begin(); it != m_TheFBCache.end(); ++it)
-    {
-        m_FBC_stats.recordErase(it->second->m_nuse);
-        delete it->second;
-    }
     m_TheFBCache.clear();
-#ifdef AMREX_MEM_PROFILING
-    m_FBC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::FB&
@@ -1071,36 +1480,38 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
     BL_PROFILE("FabArrayBase::getFB()");
 
     BL_ASSERT(getBDKey() == m_bdkey);
-    std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
-    for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-        if (it->second->m_typ        == boxArray().ixType()      &&
-            it->second->m_crse_ratio == boxArray().crseRatio()   &&
-            it->second->m_ngrow      == nghost                   &&
-            it->second->m_cross      == cross                    &&
-            it->second->m_multi_ghost== m_multi_ghost            &&
-            it->second->m_epo        == enforce_periodicity_only &&
-            it->second->m_period     == period              )
-        {
-            ++(it->second->m_nuse);
-            m_FBC_stats.recordUse();
-            return *(it->second);
-        }
-    }
 
-    // Have to build a new one
-    FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only,m_multi_ghost);
+    const std::size_t hash = metadata_hash(m_bdkey, boxArray().ixType(), boxArray().crseRatio(),
+                                           nghost, cross, m_multi_ghost,
+                                           enforce_periodicity_only, period);
+
+    FB* fb = m_TheFBCache.find(hash, [&] (FB const& f) {
+        return f.m_typ        == boxArray().ixType()      &&
+               f.m_crse_ratio == boxArray().crseRatio()   &&
+               f.m_ngrow      == nghost                   &&
+               f.m_cross      == cross                    &&
+               f.m_multi_ghost== m_multi_ghost            &&
+               f.m_epo        == enforce_periodicity_only &&
+               f.m_period     == period;
+    });
+    if (fb) { return *fb; }
 
-#ifdef AMREX_MEM_PROFILING
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
+    // Have to build a new one
+    m_TheFBCache.evict(metadata_cache_max_bytes, [] (FB const& f) {
+#ifdef AMREX_USE_MPI
+        // The graph communicator is built collectively.  Evicting it on
+        // some processes only would make the processes go out of sync.
+        if (f.m_ncomm) { return true; }
+        // Likewise, the persistent requests would be rebuilt with a new
+        // tag on some processes only, and the messages would never match.
+        if (f.m_pcomm) { return true; }
 #endif
+        return f.m_nflight > 0;
+    });
 
-    new_fb->m_nuse = 1;
-    m_FBC_stats.recordBuild();
-    m_FBC_stats.recordUse();
+    FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only,m_multi_ghost);
 
-    m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
+    m_TheFBCache.insert(hash, new_fb, new_fb->bytes(), m_bdkey, m_bdkey);
 
     return *new_fb;
 }
@@ -1845,39 +2256,26 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     const BDKey& srckey = srcfa.getBDKey();
     const BDKey& dstkey = dstfa.getBDKey();
 
-    std::pair<FPinfoCacheIter,FPinfoCacheIter> er_it = m_TheFillPatchCache.equal_range(dstkey);
+    const std::size_t hash = metadata_hash(dstkey, srckey, dstdomain, dstng);
 
-    for (FPinfoCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-        if (it->second->m_srcbdk    == srckey    &&
-            it->second->m_dstbdk    == dstkey    &&
-            it->second->m_dstdomain == dstdomain &&
-            it->second->m_dstng     == dstng     &&
-            it->second->m_dstdomain.ixType() == dstdomain.ixType() &&
-            it->second->m_coarsener->doit(it->second->m_dstdomain) == coarsener.doit(dstdomain))
-        {
-            ++(it->second->m_nuse);
-            m_FPinfo_stats.recordUse();
-            return *(it->second);
-        }
-    }
+    FPinfo* fpc = m_TheFillPatchCache.find(hash, [&] (FPinfo const& f) {
+        return f.m_srcbdk    == srckey    &&
+               f.m_dstbdk    == dstkey    &&
+               f.m_dstdomain == dstdomain &&
+               f.m_dstng     == dstng     &&
+               f.m_dstdomain.ixType() == dstdomain.ixType() &&
+               f.m_coarsener->doit(f.m_dstdomain) == coarsener.doit(dstdomain);
+    });
+    if (fpc) { return *fpc; }
 
     // Have to build a new one
+    m_TheFillPatchCache.evict(metadata_cache_max_bytes,
+                              [] (FPinfo const&) { return false; });
+
     FPinfo* new_fpc = new FPinfo(srcfa, dstfa, dstdomain, dstng, coarsener,
                                  fgeom.Domain(), cgeom.Domain(), index_space);
 
-#ifdef AMREX_MEM_PROFILING
-    m_FPinfo_stats.bytes += new_fpc->bytes();
-    m_FPinfo_stats.bytes_hwm = std::max(m_FPinfo_stats.bytes_hwm, m_FPinfo_stats.bytes);
-#endif
-
-    new_fpc->m_nuse = 1;
-    m_FPinfo_stats.recordBuild();
-    m_FPinfo_stats.recordUse();
-
-    m_TheFillPatchCache.insert(er_it.second, FPinfoCache::value_type(dstkey,new_fpc));
-    if (srckey != dstkey)
-        m_TheFillPatchCache.insert(          FPinfoCache::value_type(srckey,new_fpc));
+    m_TheFillPatchCache.insert(hash, new_fpc, new_fpc->bytes(), dstkey, srckey);
 
     return *new_fpc;
 }
@@ -1888,43 +2286,7 @@ FabArrayBase::flushFPinfo (bool no_assertion)
     amrex::ignore_unused(no_assertion);
     BL_ASSERT(no_assertion || getBDKey() == m_bdkey);
 
-    std::vector<FPinfoCacheIter> others;
-
-    std::pair<FPinfoCacheIter,FPinfoCacheIter> er_it = m_TheFillPatchCache.equal_range(m_bdkey);
-
-    for (FPinfoCacheIter it = er_it.first; it != er_it.second; ++it)
-    {
-        const BDKey& srckey = it->second->m_srcbdk;
-        const BDKey& dstkey = it->second->m_dstbdk;
-
-        BL_ASSERT((srckey==dstkey && srckey==m_bdkey) ||
-                  (m_bdkey==srckey) || (m_bdkey==dstkey));
-
-        if (srckey != dstkey) {
-            const BDKey& otherkey = (m_bdkey == srckey) ? dstkey : srckey;
-            std::pair<FPinfoCacheIter,FPinfoCacheIter> o_er_it = m_TheFillPatchCache.equal_range(otherkey);
-
-            for (FPinfoCacheIter oit = o_er_it.first; oit != o_er_it.second; ++oit)
-            {
-                if (it->second == oit->second)
-                    others.push_back(oit);
-            }
-        }
-
-#ifdef AMREX_MEM_PROFILING
-        m_FPinfo_stats.bytes -= it->second->bytes();
-#endif
-        m_FPinfo_stats.recordErase(it->second->m_nuse);
-        delete it->second;
-    }
-
-    m_TheFillPatchCache.erase(er_it.first, er_it.second);
-
-    for (std::vector<FPinfoCacheIter>::iterator it = others.begin(),
-             End = others.end(); it != End; ++it)
-    {
-        m_TheFillPatchCache.erase(*it);
-    }
+    m_TheFillPatchCache.erase(m_bdkey);
 }
 
 FabArrayBase::CFinfo::CFinfo (const FabArrayBase& finefa,
@@ -2010,34 +2372,24 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
     BL_PROFILE("FabArrayBase::TheCFinfo()");
 
     const BDKey& key = finefa.getBDKey();
-    auto er_it = m_TheCrseFineCache.equal_range(key);
-    for (auto it = er_it.first; it != er_it.second; ++it)
-    {
-        if (it->second->m_fine_bdk    == key                        &&
-            it->second->m_fine_domain == CFinfo::Domain(finegm, ng,
-                                                        include_periodic,
-                                                        include_physbndry) &&
-            it->second->m_ng          == ng)
-        {
-            ++(it->second->m_nuse);
-            m_CFinfo_stats.recordUse();
-            return *(it->second);
-        }
-    }
+    const Box fine_domain = CFinfo::Domain(finegm, ng, include_periodic, include_physbndry);
 
-    // Have to build a new one
-    CFinfo* new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
+    const std::size_t hash = metadata_hash(key, fine_domain, ng);
 
-#ifdef AMREX_MEM_PROFILING
-    m_CFinfo_stats.bytes += new_cfinfo->bytes();
-    m_CFinfo_stats.bytes_hwm = std::max(m_CFinfo_stats.bytes_hwm, m_CFinfo_stats.bytes);
-#endif
+    CFinfo* cfinfo = m_TheCrseFineCache.find(hash, [&] (CFinfo const& c) {
+        return c.m_fine_bdk    == key         &&
+               c.m_fine_domain == fine_domain &&
+               c.m_ng          == ng;
+    });
+    if (cfinfo) { return *cfinfo; }
 
-    new_cfinfo->m_nuse = 1;
-    m_CFinfo_stats.recordBuild();
-    m_CFinfo_stats.recordUse();
+    // Have to build a new one
+    m_TheCrseFineCache.evict(metadata_cache_max_bytes,
+                             [] (CFinfo const&) { return false; });
+
+    CFinfo* new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
 
-    m_TheCrseFineCache.insert(er_it.second, CFinfoCache::value_type(key,new_cfinfo));
+    m_TheCrseFineCache.insert(hash, new_cfinfo, new_cfinfo->bytes(), key, key);
 
     return *new_cfinfo;
 }
@@ -2047,16 +2399,7 @@ FabArrayBase::flushCFinfo (bool no_assertion)
 {
     amrex::ignore_unused(no_assertion);
     BL_ASSERT(no_assertion || getBDKey() == m_bdkey);
-    auto er_it = m_TheCrseFineCache.equal_range(m_bdkey);
-    for (auto it = er_it.first; it != er_it.second; ++it)
-    {
-#ifdef AMREX_MEM_PROFILING
-        m_CFinfo_stats.bytes -= it->second->bytes();
-#endif
-        m_CFinfo_stats.recordErase(it->second->m_nuse);
-        delete it->second;
-    }
-    m_TheCrseFineCache.erase(er_it.first, er_it.second);
+    m_TheCrseFineCache.erase(m_bdkey);
 }
 
 void
@@ -2068,6 +2411,20 @@ FabArrayBase::Finalize ()
     FabArrayBase::flushRB180Cache();
     FabArrayBase::flushPolarBCache();
     FabArrayBase::flushTileArrayCache();
+    m_TheFillPatchCache.clear();
+    m_TheCrseFineCache.clear();
+
+#ifdef AMREX_USE_MPI
+    // After the FB cache, which holds the requests on these communicators
+    {
+        int mpi_finalized = 0;
+        MPI_Finalized(&mpi_finalized);
+        for (auto& p : persistent_comms) {
+            if (!mpi_finalized) { MPI_Comm_free(&p.second); }
+        }
+        persistent_comms.clear();
+    }
+#endif
 
 #ifdef AMREX_USE_GPU
     FabArrayBase::flushParForCache();
@@ -2080,6 +2437,9 @@ FabArrayBase::Finalize ()
         m_CPC_stats.print();
         m_FPinfo_stats.print();
         m_CFinfo_stats.print();
+#ifdef AMREX_USE_GPU
+        m_ParFor_stats.print();
+#endif
     }
 
     if (amrex::system::verbose > 1) {
@@ -2092,6 +2452,9 @@ FabArrayBase::Finalize ()
     m_CPC_stats = CacheStats("CopyCache");
     m_FPinfo_stats = CacheStats("FillPatchCache");
     m_CFinfo_stats = CacheStats("CrseFineCache");
+#ifdef AMREX_USE_GPU
+    m_ParFor_stats = CacheStats("ParForCache");
+#endif
 
     m_BD_count.clear();
 
@@ -2119,6 +2482,7 @@ FabArrayBase::getTileArray (const IntVect& tilesize) const
             buildTileArray(tilesize, *p);
             p->nuse = 0;
             m_TAC_stats.recordBuild();
+            m_TAC_stats.recordMiss();
 #ifdef AMREX_MEM_PROFILING
             m_TAC_stats.bytes += p->bytes();
             m_TAC_stats.bytes_hwm = std::max(m_TAC_stats.bytes_hwm,
@@ -2129,6 +2493,7 @@ FabArrayBase::getTileArray (const IntVect& tilesize) const
 #pragma omp master
 #endif
         {
+            if (p->nuse > 0) { m_TAC_stats.recordHit(); }
             ++(p->nuse);
             m_TAC_stats.recordUse();
         }
@@ -2529,20 +2894,21 @@ FabArrayBase::ParForInfo const&
 FabArrayBase::getParForInfo (const IntVect& nghost, int nthreads) const
 {
     AMREX_ASSERT(getBDKey() == m_bdkey);
-    auto er_it = m_TheParForCache.equal_range(m_bdkey);
-    for (auto it = er_it.first; it != er_it.second; ++it) {
-        if (it->second->m_typ        == boxArray().ixType()    &&
-            it->second->m_crse_ratio == boxArray().crseRatio() &&
-            it->second->m_ng         == nghost                 &&
-            it->second->m_nthreads   == nthreads)
-        {
-            return *(it->second);
-        }
-    }
 
+    const std::size_t hash = metadata_hash(m_bdkey, boxArray().ixType(), boxArray().crseRatio(),
+                                           nghost, nthreads);
+
+    ParForInfo* pfi = m_TheParForCache.find(hash, [&] (ParForInfo const& p) {
+        return p.m_typ        == boxArray().ixType()    &&
+               p.m_crse_ratio == boxArray().crseRatio() &&
+               p.m_ng         == nghost                 &&
+               p.m_nthreads   == nthreads;
+    });
+    if (pfi) { return *pfi; }
+
+    // These are used by asynchronous kernels, so they are never evicted.
     ParForInfo* new_pfi = new ParForInfo(*this, nghost, nthreads);
-    m_TheParForCache.insert(er_it.second,
-                            std::multimap<BDKey,ParForInfo*>::value_type(m_bdkey,new_pfi));
+    m_TheParForCache.insert(hash, new_pfi, sizeof(ParForInfo), m_bdkey, m_bdkey);
     return *new_pfi;
 }
 
@@ -2552,19 +2918,12 @@ FabArrayBase::flushParForInfo (bool no_assertion) const
     amrex::ignore_unused(no_assertion);
     AMREX_ASSERT(no_assertion || getBDKey() == m_bdkey);
     AMREX_ASSERT(getBDKey() == m_bdkey);
-    auto er_it = m_TheParForCache.equal_range(m_bdkey);
-    for (auto it = er_it.first; it != er_it.second; ++it) {
-        delete it->second;
-    }
-    m_TheParForCache.erase(er_it.first, er_it.second);
+    m_TheParForCache.erase(m_bdkey);
 }
 
 void
 FabArrayBase::flushParForCache ()
 {
-    for (auto it = m_TheParForCache.begin(); it != m_TheParForCache.end(); ++it) {
-        delete it->second;
-    }
     m_TheParForCache.clear();
 }
 
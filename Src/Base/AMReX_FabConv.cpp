@@ -2,9 +2,12 @@
 #include <AMReX_FabConv.H>
 #include <AMReX_FArrayBox.H>
 #include <AMReX_FPC.H>
+#include <AMReX_OpenMP.H>
 #include <AMReX_REAL.H>
 #include <AMReX_Utility.H>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -905,6 +908,141 @@ operator>> (std::istream&   is,
     return is;
 }
 
+//
+// Fast paths for IEEE 32 and 64-bit reals in either byte order.  The loops
+// are written so that the compiler vectorizes them, and large buffers are
+// split over OpenMP threads.
+//
+
+namespace {
+
+//
+// 4 or 8 if rd is an IEEE float or double in the native or the reversed
+// native byte order, 0 otherwise.
+//
+int
+ieee_bytes (const RealDescriptor& rd, bool& swapped)
+{
+    const Vector<Long>& fmt = rd.formatarray();
+    const Vector<int>&  ord = rd.orderarray();
+    const int nb = int(ord.size());
+    const int* native_order = nullptr;
+    const int* swapped_order = nullptr;
+    if (nb == 4 && fmt.size() == 8 && std::equal(fmt.begin(), fmt.end(), FPC::ieee_float)) {
+        native_order  = FPC::Native32RealDescriptor().order();
+        swapped_order = (native_order[0] == 1) ? FPC::reverse_float_order
+                                               : FPC::normal_float_order;
+    } else if (nb == 8 && fmt.size() == 8 && std::equal(fmt.begin(), fmt.end(), FPC::ieee_double)) {
+        native_order  = FPC::Native64RealDescriptor().order();
+        swapped_order = (native_order[0] == 1) ? FPC::reverse_double_order
+                                               : FPC::normal_double_order;
+    } else {
+        return 0;
+    }
+    if (std::equal(ord.begin(), ord.end(), native_order)) {
+        swapped = false;
+        return nb;
+    } else if (std::equal(ord.begin(), ord.end(), swapped_order)) {
+        swapped = true;
+        return nb;
+    }
+    return 0;
+}
+
+inline std::uint32_t byte_swap (std::uint32_t u)
+{
+    return ((u & 0x000000FFu) << 24) | ((u & 0x0000FF00u) <<  8) |
+           ((u & 0x00FF0000u) >>  8) | ((u & 0xFF000000u) >> 24);
+}
+
+inline std::uint64_t byte_swap (std::uint64_t u)
+{
+    return (std::uint64_t(byte_swap(std::uint32_t(u))) << 32) |
+            std::uint64_t(byte_swap(std::uint32_t(u >> 32)));
+}
+
+template <typename T> struct ieee_traits;
+template <> struct ieee_traits<float>  { using uint_type = std::uint32_t; };
+template <> struct ieee_traits<double> { using uint_type = std::uint64_t; };
+
+//
+// Convert TI to TO with optional byte swaps of the input and the output.
+// Unlike the generic conversion, this rounds to nearest and keeps
+// infinities, NaNs and denormals, as a cast does.
+//
+template <typename TI, typename TO, bool SwapIn, bool SwapOut>
+void
+ieee_convert (void* out, const void* in, Long nitems)
+{
+    using UI = typename ieee_traits<TI>::uint_type;
+    using UO = typename ieee_traits<TO>::uint_type;
+
+    const char* pin  = static_cast<const char*>(in);
+    char*       pout = static_cast<char*>(out);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for if (nitems >= 65536 && ! OpenMP::in_parallel())
+#endif
+    for (Long i = 0; i < nitems; ++i)
+    {
+        UI ui;
+        std::memcpy(&ui, pin + i*sizeof(UI), sizeof(UI));
+        if (SwapIn) { ui = byte_swap(ui); }
+        TI x;
+        std::memcpy(&x, &ui, sizeof(TI));
+        const TO y = static_cast<TO>(x);
+        UO uo;
+        std::memcpy(&uo, &y, sizeof(UO));
+        if (SwapOut) { uo = byte_swap(uo); }
+        std::memcpy(pout + i*sizeof(UO), &uo, sizeof(UO));
+    }
+}
+
+template <typename TI, typename TO>
+void
+ieee_convert (void* out, const void* in, Long nitems, bool swapIn, bool swapOut)
+{
+    if (swapIn) {
+        if (swapOut) { ieee_convert<TI,TO,true ,true >(out, in, nitems); }
+        else         { ieee_convert<TI,TO,true ,false>(out, in, nitems); }
+    } else {
+        if (swapOut) { ieee_convert<TI,TO,false,true >(out, in, nitems); }
+        else         { ieee_convert<TI,TO,false,false>(out, in, nitems); }
+    }
+}
+
+//
+// Returns false if the conversion has no fast path.
+//
+bool
+ieee_fast_convert (void*                 out,
+                   const void*           in,
+                   Long                  nitems,
+                   const RealDescriptor& ord,
+                   const RealDescriptor& ird)
+{
+    bool swapIn = false, swapOut = false;
+    const int ib = ieee_bytes(ird, swapIn);
+    const int ob = ieee_bytes(ord, swapOut);
+    if (ib == 0 || ob == 0) {
+        return false;
+    }
+
+    // ---- the same size only swaps bytes, a change of size converts
+    if (ib == 4 && ob == 4) {
+        ieee_convert<float,float>(out, in, nitems, swapIn, swapOut);
+    } else if (ib == 8 && ob == 8) {
+        ieee_convert<double,double>(out, in, nitems, swapIn, swapOut);
+    } else if (ib == 8) {
+        ieee_convert<double,float>(out, in, nitems, swapIn, swapOut);
+    } else {
+        ieee_convert<float,double>(out, in, nitems, swapIn, swapOut);
+    }
+    return true;
+}
+
+}
+
 static
 void
 PD_convert (void*                 out,
@@ -923,23 +1061,13 @@ PD_convert (void*                 out,
         BL_ASSERT(int(n) == nitems);
         memcpy(out, in, n*ord.numBytes());
     }
+    else if (boffs == 0 && ! onescmp && ieee_fast_convert(out, in, nitems, ord, ird)) {
+        // ---- done
+    }
     else if (ord.formatarray() == ird.formatarray() && boffs == 0 && ! onescmp) {
         permute_real_word_order(out, in, nitems,
                                 ord.order(), ird.order(), ord.numBytes());
     }
-    else if (ird == FPC::NativeRealDescriptor() && ord == FPC::Native32RealDescriptor()) {
-      auto rIn = static_cast<const char*>(in);
-      auto rOut= static_cast<char*>(out);
-      for(Long i(0); i < nitems; ++i) {
-        Real x;
-        float y;
-        std::memcpy(&x, rIn, sizeof(Real));
-        y = static_cast<float>(x);
-        std::memcpy(rOut, &y, sizeof(float));
-        rOut += sizeof(float);
-        rIn += sizeof(Real);
-      }
-    }
     else
     {
         PD_fconvert(out, in, nitems, boffs, ord.format(), ord.order(),
@@ -249,6 +249,10 @@ MFIter::Initialize ()
         ++depth;
         AMREX_ALWAYS_ASSERT_WITH_MESSAGE(depth == 1 || MFIter::allow_multiple_mfiters,
             "Nested or multiple active MFIters is not supported by default.  This can be changed by calling MFIter::allowMultipleMFIters(true)".);
+
+        if (fabArray.isSpilled()) {
+            fabArray.unspill();
+        }
     }
 
     if (flags & AllBoxes)  // a very special case
@@ -219,6 +219,49 @@ class Machine
         node_ids = get_node_ids();
     }
 
+    // get the node IDs of the ranks of comm, indexed by rank in comm.
+    // without the machine's node IDs, they come from the shared memory
+    // domains of MPI, and the ID of a node is its lowest rank in comm.
+    // they are cached by the global ranks of comm, so that this is
+    // collective over comm only the first time it is called for a group
+    Vector<int> const& get_node_ids (MPI_Comm comm)
+    {
+        int rank_me, rank_n;
+        MPI_Comm_rank(comm, &rank_me);
+        MPI_Comm_size(comm, &rank_n);
+
+        Vector<int> g_ranks(rank_n);
+        {
+            MPI_Group group, world_group;
+            MPI_Comm_group(comm, &group);
+            MPI_Comm_group(ParallelDescriptor::Communicator(), &world_group);
+            Vector<int> l_ranks(rank_n);
+            for (int i = 0; i < rank_n; ++i) { l_ranks[i] = i; }
+            MPI_Group_translate_ranks(group, rank_n, l_ranks.data(), world_group, g_ranks.data());
+            MPI_Group_free(&group);
+            MPI_Group_free(&world_group);
+        }
+
+        auto it = node_ids_cache.find(g_ranks);
+        if (it != node_ids_cache.end()) {
+            return it->second;
+        }
+
+        int node_id;
+        if (flag_nersc_df) {
+            node_id = node_ids[ParallelDescriptor::MyProc()];
+        } else {
+            MPI_Comm shm_comm;
+            MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank_me, MPI_INFO_NULL, &shm_comm);
+            node_id = rank_me;
+            MPI_Allreduce(MPI_IN_PLACE, &node_id, 1, MPI_INT, MPI_MIN, shm_comm);
+            MPI_Comm_free(&shm_comm);
+        }
+        Vector<int> ids(rank_n, 0);
+        ParallelAllGather::AllGather(node_id, ids.data(), comm);
+        return node_ids_cache.emplace(std::move(g_ranks), std::move(ids)).first->second;
+    }
+
     // find a compact neighborhood of size rank_n in the current ParallelContext subgroup
     Vector<int> find_best_nbh (int nbh_rank_n, bool flag_local_ranks)
     {
@@ -323,6 +366,8 @@ class Machine
     bool flag_nersc_df;
     // int my_node_id;
     Vector<int> node_ids;
+    // node IDs of the ranks of a communicator, keyed by their global ranks
+    std::map<Vector<int>, Vector<int>> node_ids_cache;
 
     NeighborhoodCache nbh_cache;
 
@@ -595,6 +640,11 @@ Vector<int> find_best_nbh (int rank_n, bool flag_local_ranks) {
     return the_machine->find_best_nbh(rank_n, flag_local_ranks);
 }
 
+Vector<int> node_ids (MPI_Comm comm) {
+    AMREX_ASSERT(the_machine);
+    return the_machine->get_node_ids(comm);
+}
+
 }}
 
 #endif
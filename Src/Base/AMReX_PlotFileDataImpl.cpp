@@ -142,4 +142,52 @@ PlotFileDataImpl::get (int level, std::string const& varname) noexcept
     return mf;
 }
 
+MultiFab
+PlotFileDataImpl::getMapped (int level, bool sparse) noexcept
+{
+#ifdef AMREX_USE_GPU
+    amrex::ignore_unused(sparse);
+    return get(level);
+#else
+    MultiFab mf(m_ba[level], m_dmap[level], m_ncomp, m_ngrow[level], MFInfo().SetAlloc(false));
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        int gid = mfi.index();
+        Array4<Real> const& a = m_vismf[level]->mapFAB(gid, sparse);
+        if (a.p) {
+            mf.setFab(mfi, FArrayBox(a));
+        } else {
+            mf.setFab(mfi, std::unique_ptr<FArrayBox>(m_vismf[level]->readFAB(gid, -1)));
+        }
+    }
+    return mf;
+#endif
+}
+
+MultiFab
+PlotFileDataImpl::getMapped (int level, std::string const& varname, bool sparse) noexcept
+{
+#ifdef AMREX_USE_GPU
+    amrex::ignore_unused(sparse);
+    return get(level, varname);
+#else
+    MultiFab mf(m_ba[level], m_dmap[level], 1, m_ngrow[level], MFInfo().SetAlloc(false));
+    auto r = std::find(std::begin(m_var_names), std::end(m_var_names), varname);
+    if (r == std::end(m_var_names)) {
+        amrex::Abort("PlotFileDataImpl::getMapped: varname not found "+varname);
+    } else {
+        int icomp = std::distance(std::begin(m_var_names), r);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            int gid = mfi.index();
+            Array4<Real> const& a = m_vismf[level]->mapFAB(gid, sparse);
+            if (a.p) {
+                mf.setFab(mfi, FArrayBox(Array4<Real>(a, icomp, 1)));
+            } else {
+                mf.setFab(mfi, std::unique_ptr<FArrayBox>(m_vismf[level]->readFAB(gid, icomp)));
+            }
+        }
+    }
+    return mf;
+#endif
+}
+
 }
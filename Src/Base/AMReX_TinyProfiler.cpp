@@ -10,6 +10,7 @@
 #include <AMReX_GpuDevice.H>
 #endif
 #include <AMReX_Print.H>
+#include <AMReX_CArena.H>
 
 #ifdef AMREX_USE_CUPTI
 #include <AMReX_CuptiTrace.H>
@@ -35,6 +36,7 @@ double TinyProfiler::t_init = std::numeric_limits<double>::max();
 int TinyProfiler::device_synchronize_around_region = 0;
 int TinyProfiler::n_print_tabs = 0;
 int TinyProfiler::verbose = 0;
+int TinyProfiler::arena_stats = 0;
 
 namespace {
     std::set<std::string> improperly_nested_timers;
@@ -303,6 +305,7 @@ TinyProfiler::Initialize () noexcept
         pp.queryAdd("device_synchronize_around_region", device_synchronize_around_region);
         pp.queryAdd("verbose", verbose);
         pp.queryAdd("v", verbose);
+        pp.queryAdd("arena_stats", arena_stats);
     }
 }
 
@@ -392,6 +395,79 @@ TinyProfiler::Finalize (bool bFlushing) noexcept
             amrex::Print() << "END REGION " << kv.first << "\n";
         }
     }
+
+    if (arena_stats) {
+        PrintArenaStats();
+    }
+}
+
+void
+TinyProfiler::PrintArenaStats ()
+{
+    const std::vector<std::pair<std::string,Arena*> > arenas
+        {{"The_Arena", The_Arena()}, {"The_Device_Arena", The_Device_Arena()},
+         {"The_Managed_Arena", The_Managed_Arena()}, {"The_Pinned_Arena", The_Pinned_Arena()},
+         {"The_Cpu_Arena", The_Cpu_Arena()}, {"The_Spill_Arena", The_Spill_Arena()}};
+
+    // Arenas may be aliases of each other; report each CArena once, in the same order on all processes.
+    std::vector<std::pair<std::string,CArena const*> > carenas;
+    for (auto const& a : arenas) {
+        auto p = dynamic_cast<CArena const*>(a.second);
+        bool found = false;
+        for (auto const& c : carenas) {
+            found = found || (c.second == p);
+        }
+        if (p && !found) {
+            carenas.emplace_back(a.first, p);
+        }
+    }
+    if (carenas.empty()) return;
+
+    int ioproc = ParallelDescriptor::IOProcessorNumber();
+    const Long mb = 1024*1024;
+
+    // Frag % is the part of the free memory outside the largest free block.
+    const std::string hline(111, '-');
+    if (ParallelDescriptor::IOProcessor()) {
+        amrex::OutStream() << "\nTinyProfiler arena memory (MB), max across processes:\n"
+                           << hline << "\n"
+                           << std::left << std::setw(20) << "Arena" << std::right
+                           << std::setw(13) << "Allocated"
+                           << std::setw(13) << "Used"
+                           << std::setw(13) << "Peak Alloc"
+                           << std::setw(13) << "Peak Used"
+                           << std::setw(13) << "Peak Frag"
+                           << std::setw(13) << "Free Blocks"
+                           << std::setw(13) << "Frag %"
+                           << "\n" << hline << "\n";
+    }
+
+    for (auto const& c : carenas) {
+        Long nfree;
+        std::size_t largest_free;
+        c.second->FreeBlockStats(nfree, largest_free);
+        const std::size_t total_free = c.second->heap_space_used()
+            - c.second->heap_space_actually_used();
+        const Long frag = (total_free > largest_free)
+            ? static_cast<Long>(100.0*double(total_free-largest_free)/double(total_free)) : 0;
+        Vector<Long> v{static_cast<Long>(c.second->heap_space_used())/mb,
+                       static_cast<Long>(c.second->heap_space_actually_used())/mb,
+                       static_cast<Long>(c.second->heap_space_used_hwm())/mb,
+                       static_cast<Long>(c.second->heap_space_actually_used_hwm())/mb,
+                       static_cast<Long>(c.second->heap_space_fragmented_hwm())/mb,
+                       nfree, frag};
+        ParallelReduce::Max<Long>(v.data(), v.size(), ioproc, ParallelDescriptor::Communicator());
+        if (ParallelDescriptor::IOProcessor()) {
+            amrex::OutStream() << std::left << std::setw(20) << c.first << std::right;
+            for (auto x : v) {
+                amrex::OutStream() << std::setw(13) << x;
+            }
+            amrex::OutStream() << "\n";
+        }
+    }
+    if (ParallelDescriptor::IOProcessor()) {
+        amrex::OutStream() << hline << "\n" << std::endl;
+    }
 }
 
 void
@@ -5,9 +5,24 @@
 #include <AMReX_Utility.H>
 #include <AMReX_VisMF.H>
 
+#ifdef AMREX_USE_OMP
+#include <omp.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <cerrno>
 #include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
 #include <limits>
+#include <set>
 
 namespace amrex {
 
@@ -28,6 +43,9 @@ bool VisMF::usePersistentIFStreams(false);
 bool VisMF::useSynchronousReads(false);
 bool VisMF::useDynamicSetSelection(true);
 bool VisMF::allowSparseWrites(true);
+Long VisMF::compressionChunkSize(262144);
+bool VisMF::useTwoPhaseWrite(false);
+Long VisMF::stripeSize(1048576);
 
 Long VisMFBuffer::ioBufferSize(VisMF::IO_Buffer_Size);
 
@@ -76,6 +94,15 @@ VisMF::Initialize ()
     pp.queryAdd("usedynamicsetselection", useDynamicSetSelection);
     pp.queryAdd("iobuffersize", ioBufferSize);
     pp.queryAdd("allowsparsewrites", allowSparseWrites);
+    pp.queryAdd("compressionchunksize", compressionChunkSize);
+    if(compressionChunkSize <= 0) {
+      amrex::Abort("vismf.compressionchunksize must be positive");
+    }
+    pp.queryAdd("usetwophasewrite", useTwoPhaseWrite);
+    pp.queryAdd("stripesize", stripeSize);
+    if(stripeSize <= 0) {
+      amrex::Abort("vismf.stripesize must be positive");
+    }
 
     initialized = true;
 }
@@ -280,7 +307,9 @@ operator<< (std::ostream        &os,
       os << hd.m_max      << '\n';
     }
 
-    if(hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1) {
+    if(hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
+    {
       BL_ASSERT(hd.m_famin.size() == hd.m_ncomp);
       BL_ASSERT(hd.m_famin.size() == hd.m_famax.size());
       for(int i(0); i < hd.m_famin.size(); ++i) {
@@ -295,7 +324,8 @@ operator<< (std::ostream        &os,
 
     if(hd.m_vers == VisMF::Header::NoFabHeader_v1       ||
        hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       if(FArrayBox::getFormat() == FABio::FAB_NATIVE) {
         os << FPC::NativeRealDescriptor() << '\n';
@@ -306,6 +336,19 @@ operator<< (std::ostream        &os,
       }
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      // ---- one line per fab:  nchunks end_0 end_1 ... end_n-1
+      BL_ASSERT(hd.m_chunkends.size() == hd.m_ba.size());
+      os << hd.m_chunksize << '\n';
+      for(int i(0); i < hd.m_chunkends.size(); ++i) {
+        os << hd.m_chunkends[i].size();
+        for(int j(0); j < hd.m_chunkends[i].size(); ++j) {
+          os << ' ' << hd.m_chunkends[i][j];
+        }
+        os << '\n';
+      }
+    }
+
     os.flags(oflags);
     os.precision(oldPrec);
 
@@ -366,7 +409,9 @@ operator>> (std::istream  &is,
       BL_ASSERT(hd.m_ba.size() == hd.m_max.size());
     }
 
-    if(hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1) {
+    if(hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
+    {
       char ch;
       hd.m_famin.resize(hd.m_ncomp);
       hd.m_famax.resize(hd.m_ncomp);
@@ -385,11 +430,26 @@ operator>> (std::istream  &is,
     }
     if(hd.m_vers == VisMF::Header::NoFabHeader_v1       ||
        hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
+       hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       is >> hd.m_writtenRD;
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      is >> hd.m_chunksize;
+      BL_ASSERT(hd.m_chunksize > 0);
+      hd.m_chunkends.resize(hd.m_ba.size());
+      for(int i(0); i < hd.m_chunkends.size(); ++i) {
+        Long nchunks;
+        is >> nchunks;
+        hd.m_chunkends[i].resize(nchunks);
+        for(Long j(0); j < nchunks; ++j) {
+          is >> hd.m_chunkends[i][j];
+        }
+      }
+    }
+
 
     if( ! is.good()) {
         amrex::Error("Read of VisMF::Header failed");
@@ -513,6 +573,82 @@ VisMF::GetFab (int fabIndex,
     return *m_pa[ncomp][fabIndex];
 }
 
+Array4<Real>
+VisMF::mapFAB (int fabIndex, bool sparse) const
+{
+#ifdef _WIN32
+    amrex::ignore_unused(fabIndex, sparse);
+    return Array4<Real>{};
+#else
+    BL_PROFILE("VisMF::mapFAB()");
+
+    if(m_hdr.m_vers != Header::Version_v1 && ! NoFabHeader(m_hdr)) {
+        return Array4<Real>{};
+    }
+    if(NoFabHeader(m_hdr) && m_hdr.m_writtenRD != FPC::NativeRealDescriptor()) {
+        return Array4<Real>{};
+    }
+
+    std::string FullName(VisMF::DirName(m_fafabname));
+    FullName += m_hdr.m_fod[fabIndex].m_name;
+
+    auto it = m_mappedFiles.find(FullName);
+    if(it == m_mappedFiles.end()) {
+        std::pair<char*, std::size_t> mapped(nullptr, 0);
+        int fd = ::open(FullName.c_str(), O_RDONLY);
+        struct stat sb;
+        if(fd >= 0 && ::fstat(fd, &sb) == 0 && sb.st_size > 0) {
+            void *p = ::mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if(p != MAP_FAILED) {
+                mapped = std::make_pair(static_cast<char*>(p), std::size_t(sb.st_size));
+            }
+        }
+        if(fd >= 0) {
+            ::close(fd);
+        }
+        it = m_mappedFiles.emplace(FullName, mapped).first;
+    }
+    char *base(it->second.first);
+    const std::size_t fileSize(it->second.second);
+    if(base == nullptr) {
+        return Array4<Real>{};
+    }
+
+    Box fab_box(amrex::grow(m_hdr.m_ba[fabIndex], m_hdr.m_ngrow));
+    std::size_t dataStart(m_hdr.m_fod[fabIndex].m_head);
+
+    if(m_hdr.m_vers == Header::Version_v1) {
+        // ---- the fab header is one line:  FAB realdescriptor box ncomp
+        const char *hBegin = base + dataStart;
+        const char *hEnd = static_cast<const char*>(std::memchr(hBegin, '\n', fileSize - dataStart));
+        if(hEnd == nullptr || std::strncmp(hBegin, "FAB ", 4) != 0) {
+            return Array4<Real>{};
+        }
+        std::istringstream hss(std::string(hBegin + 4, hEnd));
+        RealDescriptor rd;
+        hss >> rd;
+        if(hss.fail() || rd != FPC::NativeRealDescriptor()) {
+            return Array4<Real>{};
+        }
+        dataStart = hEnd + 1 - base;
+    }
+
+    const std::size_t dataBytes(fab_box.numPts() * m_hdr.m_ncomp * sizeof(Real));
+    if(dataStart % alignof(Real) != 0 || dataStart + dataBytes > fileSize) {
+        return Array4<Real>{};
+    }
+
+    if(sparse) {
+        // ---- only the pages of this fab, as other fabs in the file may be read whole
+        const std::size_t pageSize(::sysconf(_SC_PAGESIZE));
+        const std::size_t pageBegin(dataStart / pageSize * pageSize);
+        ::madvise(base + pageBegin, dataStart + dataBytes - pageBegin, MADV_RANDOM);
+    }
+
+    return makeArray4(reinterpret_cast<Real*>(base + dataStart), fab_box, m_hdr.m_ncomp);
+#endif
+}
+
 void
 VisMF::clear (int fabIndex,
               int compIndex)
@@ -660,7 +796,12 @@ VisMF::Header::Header (const FabArray<FArrayBox>& mf,
     bool run_on_device = Gpu::inLaunchRegion()
         && (mf.arena()->isManaged() || mf.arena()->isDevice());
 
-    if(version == NoFabHeaderFAMinMax_v1) {
+    if(version == Compressed_v1) {
+      m_chunksize = VisMF::GetCompressionChunkSize();
+      m_chunkends.resize(m_ba.size());
+    }
+
+    if(version == NoFabHeaderFAMinMax_v1 || version == Compressed_v1) {
       // ---- calculate FabArray min max values only
       m_min.clear();
       m_max.clear();
@@ -914,6 +1055,181 @@ VisMF::WriteHeader (const std::string &mf_name, VisMF::Header &hdr,
 }
 
 
+namespace
+{
+    //
+    // Path helpers for the references WriteDelta puts in the header.  Both
+    // work on the names only and never touch the file system.
+    //
+    std::string NormalizePath (const std::string &path)
+    {
+        const bool absolute( ! path.empty() && path[0] == '/');
+        std::vector<std::string> parts;
+        std::istringstream iss(path);
+        std::string part;
+        while(std::getline(iss, part, '/')) {
+            if(part.empty() || part == ".") {
+                continue;
+            }
+            if(part == ".." && ! parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else if(part != ".." || ! absolute) {
+                parts.push_back(part);
+            }
+        }
+        std::string normalized(absolute ? "/" : "");
+        for(std::size_t i(0); i < parts.size(); ++i) {
+            normalized += (i == 0 ? "" : "/") + parts[i];
+        }
+        return normalized;
+    }
+
+    //
+    // The path of toDir relative to fromDir, with a trailing slash
+    // unless it is empty.
+    //
+    std::string RelativePath (const std::string &fromDir, const std::string &toDir)
+    {
+        const std::string from(NormalizePath(fromDir)), to(NormalizePath(toDir));
+        if(( ! from.empty() && from[0] == '/') != ( ! to.empty() && to[0] == '/')) {
+            return to.empty() ? to : to + '/';
+        }
+        std::vector<std::string> fromParts, toParts;
+        std::string part;
+        std::istringstream fss(from), tss(to);
+        while(std::getline(fss, part, '/')) { if( ! part.empty()) { fromParts.push_back(part); } }
+        while(std::getline(tss, part, '/')) { if( ! part.empty()) { toParts.push_back(part); } }
+        std::size_t common(0);
+        while(common < fromParts.size() && common < toParts.size() &&
+              fromParts[common] == toParts[common])
+        {
+            ++common;
+        }
+        std::string relative;
+        for(std::size_t i(common); i < fromParts.size(); ++i) {
+            if(fromParts[i] == "..") {    // ---- cannot climb back out of these
+                return to.empty() ? to : to + '/';
+            }
+            relative += "../";
+        }
+        for(std::size_t i(common); i < toParts.size(); ++i) {
+            relative += toParts[i] + '/';
+        }
+        return relative;
+    }
+
+    //
+    // XXH64 (https://github.com/Cyan4973/xxHash), used by WriteDelta to
+    // find the fabs that changed.  The words are read in the byte order
+    // of the machine, which is fine as the hashes are never stored.
+    //
+    constexpr std::uint64_t XXH_P1 = 11400714785074694791ULL;
+    constexpr std::uint64_t XXH_P2 = 14029467366897019727ULL;
+    constexpr std::uint64_t XXH_P3 =  1609587929392839161ULL;
+    constexpr std::uint64_t XXH_P4 =  9650029242287828579ULL;
+    constexpr std::uint64_t XXH_P5 =  2870177450012600261ULL;
+
+    inline std::uint64_t XXH_rotl (std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    inline std::uint64_t XXH_round (std::uint64_t acc, std::uint64_t input)
+    {
+        acc += input * XXH_P2;
+        return XXH_rotl(acc, 31) * XXH_P1;
+    }
+
+    inline std::uint64_t XXH_merge (std::uint64_t acc, std::uint64_t val)
+    {
+        acc ^= XXH_round(0, val);
+        return acc * XXH_P1 + XXH_P4;
+    }
+
+    inline std::uint64_t XXH_read64 (const unsigned char *p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    std::uint64_t XXH64 (const void *data, std::size_t len, std::uint64_t seed = 0)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        const unsigned char *end = p + len;
+        std::uint64_t h;
+        if(len >= 32) {
+            std::uint64_t v1(seed + XXH_P1 + XXH_P2), v2(seed + XXH_P2), v3(seed), v4(seed - XXH_P1);
+            const unsigned char *limit = end - 32;
+            do {
+                v1 = XXH_round(v1, XXH_read64(p));      p += 8;
+                v2 = XXH_round(v2, XXH_read64(p));      p += 8;
+                v3 = XXH_round(v3, XXH_read64(p));      p += 8;
+                v4 = XXH_round(v4, XXH_read64(p));      p += 8;
+            } while(p <= limit);
+            h = XXH_rotl(v1, 1) + XXH_rotl(v2, 7) + XXH_rotl(v3, 12) + XXH_rotl(v4, 18);
+            h = XXH_merge(h, v1);
+            h = XXH_merge(h, v2);
+            h = XXH_merge(h, v3);
+            h = XXH_merge(h, v4);
+        } else {
+            h = seed + XXH_P5;
+        }
+        h += static_cast<std::uint64_t>(len);
+        for( ; p + 8 <= end; p += 8) {
+            h ^= XXH_round(0, XXH_read64(p));
+            h = XXH_rotl(h, 27) * XXH_P1 + XXH_P4;
+        }
+        if(p + 4 <= end) {
+            std::uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            h ^= static_cast<std::uint64_t>(v) * XXH_P1;
+            h = XXH_rotl(h, 23) * XXH_P2 + XXH_P3;
+            p += 4;
+        }
+        for( ; p < end; ++p) {
+            h ^= (*p) * XXH_P5;
+            h = XXH_rotl(h, 11) * XXH_P1;
+        }
+        h ^= h >> 33;
+        h *= XXH_P2;
+        h ^= h >> 29;
+        h *= XXH_P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    //
+    // Hash all the data of a fab.  Blocks are hashed by OpenMP threads and
+    // the hash of the fab is the hash of the block hashes.
+    //
+    std::uint64_t HashFab (const FArrayBox &fab)
+    {
+        Real const* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+        std::unique_ptr<FArrayBox> hostfab;
+        if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+            hostfab = std::make_unique<FArrayBox>(fab.box(), fab.nComp(),
+                                                  The_Pinned_Arena());
+            Gpu::dtoh_memcpy_async(hostfab->dataPtr(), fab.dataPtr(),
+                                   fab.size()*sizeof(Real));
+            Gpu::streamSynchronize();
+            fabdata = hostfab->dataPtr();
+        }
+#endif
+        const char *bytes = reinterpret_cast<const char *>(fabdata);
+        const Long nBytes(fab.size() * sizeof(Real));
+        const Long blockSize(1048576);
+        const Long nBlocks((nBytes + blockSize - 1) / blockSize);
+        Vector<std::uint64_t> blockHash(nBlocks);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for
+#endif
+        for(Long b = 0; b < nBlocks; ++b) {
+            blockHash[b] = XXH64(bytes + b * blockSize, std::min(blockSize, nBytes - b * blockSize));
+        }
+        return XXH64(blockHash.dataPtr(), nBlocks * sizeof(std::uint64_t), nBytes);
+    }
+}
+
+
 Long
 VisMF::Write (const FabArray<FArrayBox>&    mf,
               const std::string& mf_name,
@@ -921,6 +1237,101 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
               bool               set_ghost)
 {
     BL_PROFILE("VisMF::Write(FabArray)");
+    return VisMF::WriteDoit(mf, mf_name, how, set_ghost, nullptr, std::string());
+}
+
+
+void
+VisMF::DeltaState::clear ()
+{
+    *this = DeltaState();
+}
+
+
+Long
+VisMF::WriteDelta (const FabArray<FArrayBox>& mf,
+                   const std::string& mf_name,
+                   DeltaState&        state,
+                   const std::string& final_name,
+                   VisMF::How         how)
+{
+    BL_PROFILE("VisMF::WriteDelta");
+
+    const std::string finalName(final_name.empty() ? mf_name : final_name);
+    const int nBoxes(mf.size());
+
+    Vector<std::uint64_t> hash(nBoxes, 0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        hash[mfi.index()] = HashFab(mf[mfi]);
+    }
+
+    // ---- the earlier write, or a file of an older one that it still
+    // ---- references, may have been deleted or renamed since
+    int previousExists(0);
+    if( ! state.m_name.empty()) {
+        if(ParallelDescriptor::IOProcessor()) {
+            previousExists = amrex::FileExists(state.m_name + TheMultiFabHdrFileSuffix);
+            const std::string dir(VisMF::DirName(state.m_name));
+            std::set<std::string> fileNames;
+            for(const auto &fod : state.m_fod) {
+                fileNames.insert(fod.m_name);
+            }
+            for(auto it = fileNames.cbegin(); previousExists && it != fileNames.cend(); ++it) {
+                previousExists = amrex::FileExists(dir + *it);
+            }
+        }
+        ParallelDescriptor::Bcast(&previousExists, 1, ParallelDescriptor::IOProcessorNumber());
+    }
+
+    // ---- the same on all ranks, so all take the same path
+    const bool sameLayout( previousExists && state.m_name != finalName &&
+                          state.m_ba == mf.boxArray() &&
+                          state.m_dm == mf.DistributionMap() &&
+                          state.m_ncomp == mf.nComp() &&
+                          state.m_ngrow == mf.nGrowVect() &&
+                          state.m_vers == currentVersion &&
+                          state.m_writtenRD == *FArrayBox::getDataDescriptor() &&
+                          FArrayBox::getFormat() != FABio::FAB_ASCII &&
+                          FArrayBox::getFormat() != FABio::FAB_8BIT);
+
+    state.m_skip.assign(nBoxes, 0);
+    if(sameLayout) {
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            state.m_skip[mfi.index()] = (hash[mfi.index()] == state.m_hash[mfi.index()]);
+        }
+        ParallelDescriptor::ReduceIntMax(state.m_skip.dataPtr(), nBoxes);
+    }
+
+    if(verbose && ParallelDescriptor::IOProcessor()) {
+        const int nSkip(std::accumulate(state.m_skip.begin(), state.m_skip.end(), 0));
+        amrex::Print() << "VisMF::WriteDelta:  " << mf_name << ":  writing "
+                       << nBoxes - nSkip << " of " << nBoxes << " fabs\n";
+    }
+
+    Long bytesWritten = VisMF::WriteDoit(mf, mf_name, how, false, &state, finalName);
+
+    state.m_name      = finalName;
+    state.m_ba        = mf.boxArray();
+    state.m_dm        = mf.DistributionMap();
+    state.m_ncomp     = mf.nComp();
+    state.m_ngrow     = mf.nGrowVect();
+    state.m_vers      = currentVersion;
+    state.m_writtenRD = *FArrayBox::getDataDescriptor();
+    state.m_hash      = std::move(hash);
+    state.m_skip.clear();
+
+    return bytesWritten;
+}
+
+
+Long
+VisMF::WriteDoit (const FabArray<FArrayBox>&    mf,
+                  const std::string& mf_name,
+                  VisMF::How         how,
+                  bool               set_ghost,
+                  DeltaState*        delta,
+                  const std::string& final_name)
+{
     BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
     BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
 
@@ -977,18 +1388,44 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     NFilesIter nfi(nOutFiles, filePrefix, groupSets, setBuf);
 
     bool oldHeader(currentVersion == VisMF::Header::Version_v1);
+    bool compressed(currentVersion == VisMF::Header::Compressed_v1);
+    Vector< Vector<Long> > localChunkEnds;
+
+    if(compressed && (FArrayBox::getFormat() == FABio::FAB_ASCII ||
+                      FArrayBox::getFormat() == FABio::FAB_8BIT))
+    {
+        amrex::Abort("VisMF::Write:  Header::Compressed_v1 requires a binary fab format");
+    }
+
+    // ---- two-phase writes keep the static set order so FindOffsets applies
+    bool twoPhase(useTwoPhaseWrite && ! compressed && ! useSparseFPP &&
+                  FArrayBox::getFormat() != FABio::FAB_ASCII &&
+                  FArrayBox::getFormat() != FABio::FAB_8BIT);
+
+    // ---- a delta keeps the fab locations on the I/O processor
+    const Vector<int> *skip = (delta != nullptr) ? &delta->m_skip : nullptr;
 
     if(useSparseFPP) {
         nfi.SetSparseFPP(procsWithDataVector);
-    } else if(useDynamicSetSelection) {
+    } else if(useDynamicSetSelection && ! twoPhase && delta == nullptr) {
         nfi.SetDynamic();
     }
-    for( ; nfi.ReadyToWrite(); ++nfi) {
+    if(twoPhase) {
+        bytesWritten += VisMF::WriteTwoPhase(mf, filePrefix, *whichRD, skip);
+    }
+    for( ; ! twoPhase && nfi.ReadyToWrite(); ++nfi) {
+        if(compressed) {
+            bytesWritten += VisMF::WriteCompressed(mf, nfi.Stream(), *whichRD, localChunkEnds, skip);
+            continue;
+        }
         // ---- find the total number of bytes including fab headers if needed
         const FABio &fio = FArrayBox::getFABio();
         int whichRDBytes(whichRD->numBytes()), nFABs(0);
         Long writeDataItems(0), writeDataSize(0);
         for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if(skip != nullptr && (*skip)[mfi.index()]) {
+                continue;
+            }
             const FArrayBox &fab = mf[mfi];
             if(oldHeader) {
                 std::stringstream hss;
@@ -1012,6 +1449,9 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
         if(canCombineFABs) {
             Long writePosition(0);
             for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                if(skip != nullptr && (*skip)[mfi.index()]) {
+                    continue;
+                }
                 int hLength(0);
                 const FArrayBox &fab = mf[mfi];
                 writeDataItems = fab.box().numPts() * mf.nComp();
@@ -1051,6 +1491,9 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 
         } else {    // ---- write fabs individually
             for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                if(skip != nullptr && (*skip)[mfi.index()]) {
+                    continue;
+                }
                 int hLength(0);
                 const FArrayBox &fab = mf[mfi];
                 writeDataItems = fab.box().numPts() * mf.nComp();
@@ -1101,11 +1544,35 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
         hdr.CalculateMinMax(mf, coordinatorProc);
     }
 
+    if(compressed) {
+        VisMF::GatherChunkEnds(mf, hdr, localChunkEnds, coordinatorProc);
+    }
+
     VisMF::FindOffsets(mf, filePrefix, hdr, currentVersion, nfi,
-                       ParallelDescriptor::Communicator());
+                       ParallelDescriptor::Communicator(), skip);
+
+    if(delta != nullptr && ParallelDescriptor::MyProc() == coordinatorProc) {
+        // ---- unchanged fabs refer to where the previous write put them
+        const std::string refDir(RelativePath(VisMF::DirName(final_name),
+                                              VisMF::DirName(delta->m_name)));
+        for(int i(0); i < hdr.m_fod.size(); ++i) {
+            if(delta->m_skip[i]) {
+                hdr.m_fod[i].m_name = NormalizePath(refDir + delta->m_fod[i].m_name);
+                hdr.m_fod[i].m_head = delta->m_fod[i].m_head;
+                if(compressed) {
+                    hdr.m_chunkends[i] = delta->m_chunkends[i];
+                }
+            }
+        }
+    }
 
     bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
 
+    if(delta != nullptr && ParallelDescriptor::MyProc() == coordinatorProc) {
+        delta->m_fod       = hdr.m_fod;
+        delta->m_chunkends = hdr.m_chunkends;
+    }
+
     return bytesWritten;
 }
 
@@ -1149,7 +1616,8 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
                     const std::string &filePrefix,
                     VisMF::Header &hdr,
                     VisMF::Header::Version /*whichVersion*/,
-                    NFilesIter &nfi, MPI_Comm comm)
+                    NFilesIter &nfi, MPI_Comm comm,
+                    const Vector<int> *skip)
 {
 //    BL_PROFILE("VisMF::FindOffsets");
 
@@ -1289,10 +1757,18 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
               whichFileName   = VisMF::BaseName(NFilesIter::FileName(whichFileNumber, filePrefix));
 
               for(int i(0); i < index.size(); ++i) {
+                 if(skip != nullptr && (*skip)[index[i]]) {
+                   continue;
+                 }
                  hdr.m_fod[index[i]].m_name = whichFileName;
                  hdr.m_fod[index[i]].m_head = currentOffset[whichFileNumber];
-                 currentOffset[whichFileNumber] += mf.fabbox(index[i]).numPts() * nComps * whichRDBytes
-                                                   + fabHeaderBytes[index[i]];
+                 if(hdr.m_vers == VisMF::Header::Compressed_v1) {
+                   const Vector<Long> &chunkEnds = hdr.m_chunkends[index[i]];
+                   currentOffset[whichFileNumber] += chunkEnds.empty() ? 0 : chunkEnds.back();
+                 } else {
+                   currentOffset[whichFileNumber] += mf.fabbox(index[i]).numPts() * nComps * whichRDBytes
+                                                     + fabHeaderBytes[index[i]];
+                 }
               }
             }
           }
@@ -1363,6 +1839,13 @@ VisMF::VisMF (const std::string &fafab_name)
 
 VisMF::~VisMF ()
 {
+#ifndef _WIN32
+    for(auto const& mapped : m_mappedFiles) {
+        if(mapped.second.first != nullptr) {
+            ::munmap(mapped.second.first, mapped.second.second);
+        }
+    }
+#endif
 }
 
 
@@ -1401,7 +1884,13 @@ VisMF::readFAB (int                  idx,
           fabdata = hostfab->dataPtr();
       }
 #endif
-      if(whichComp == -1) {    // ---- read all components
+      if(hdr.m_vers == Header::Compressed_v1) {
+        if(whichComp == -1) {    // ---- read all components
+          VisMF::readCompressed(*infs, hdr, idx, fabdata, 0, hdr.m_ncomp);
+        } else {
+          VisMF::readCompressed(*infs, hdr, idx, fabdata, whichComp, 1);
+        }
+      } else if(whichComp == -1) {    // ---- read all components
         if(hdr.m_writtenRD == FPC::NativeRealDescriptor()) {
           infs->read((char *) fabdata, fab->nBytes());
         } else {
@@ -1450,7 +1939,7 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(NoFabHeader(hdr)) {
+    if(NoFabHeader(hdr) || hdr.m_vers == Header::Compressed_v1) {
       Real* fabdata = fab.dataPtr();
 #ifdef AMREX_USE_GPU
       std::unique_ptr<FArrayBox> hostfab;
@@ -1459,7 +1948,9 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
           fabdata = hostfab->dataPtr();
       }
 #endif
-      if(hdr.m_writtenRD == FPC::NativeRealDescriptor()) {
+      if(hdr.m_vers == Header::Compressed_v1) {
+        VisMF::readCompressed(*infs, hdr, idx, fabdata, 0, fab.nComp());
+      } else if(hdr.m_writtenRD == FPC::NativeRealDescriptor()) {
         infs->read((char *) fabdata, fab.nBytes());
       } else {
         Long readDataItems(fab.box().numPts() * fab.nComp());
@@ -2130,6 +2621,575 @@ bool VisMF::NoFabHeader(const VisMF::Header &hdr) {
 }
 
 
+namespace
+{
+    //
+    // The lossless codec used by VisMF::Header::Compressed_v1.  Each value is
+    // xored with the previous one and the result is split into byte planes,
+    // so the sign, exponent and leading mantissa bytes of smooth data turn
+    // into long runs of zeros.  The planes are then run-length encoded with
+    // one control byte per run:
+    //   [0,127]    a literal run of c+1 bytes follows
+    //   [128,254]  a run of c-127 zero bytes
+    //   255        a run of zero bytes, the length follows in 8 bytes
+    //
+    void PutZeroRun (std::vector<char> &out, Long run)
+    {
+        if(run <= 127) {
+            out.push_back(static_cast<char>(127 + run));
+        } else {
+            out.push_back(static_cast<char>(255));
+            for(int b(0); b < 8; ++b) {
+                out.push_back(static_cast<char>((run >> (8 * b)) & 0xff));
+            }
+        }
+    }
+
+    void CompressChunk (const char *in, Long nvals, int nbytes, std::vector<char> &out)
+    {
+        const Long n(nvals * nbytes);
+        std::vector<unsigned char> planes(n);
+        for(int k(0); k < nbytes; ++k) {
+            unsigned char *p = planes.data() + k * nvals;
+            unsigned char prev(0);
+            for(Long i(0); i < nvals; ++i) {
+                const auto c = static_cast<unsigned char>(in[i * nbytes + k]);
+                p[i] = c ^ prev;
+                prev = c;
+            }
+        }
+
+        out.clear();
+        out.reserve(n + n / 128 + 16);
+        const unsigned char *p = planes.data();
+        Long i(0);
+        while(i < n) {
+            Long z(i);
+            while(z < n && p[z] == 0) {
+                ++z;
+            }
+            if(z - i >= 2 || (z > i && z == n)) {
+                PutZeroRun(out, z - i);
+                i = z;
+                continue;
+            }
+            // ---- a literal run ends at the next pair of zeros
+            Long j(i);
+            while(j < n && j - i < 128) {
+                if(p[j] == 0 && j + 1 < n && p[j + 1] == 0) {
+                    break;
+                }
+                ++j;
+            }
+            out.push_back(static_cast<char>(j - i - 1));
+            out.insert(out.end(), p + i, p + j);
+            i = j;
+        }
+    }
+
+    bool DecompressChunk (const char *in, Long inbytes, Long nvals, int nbytes, char *out)
+    {
+        const Long n(nvals * nbytes);
+        std::vector<unsigned char> planes(n);
+        unsigned char *p = planes.data();
+        const auto *c = reinterpret_cast<const unsigned char *>(in);
+        Long ic(0), ip(0);
+        while(ic < inbytes) {
+            const unsigned char tag(c[ic++]);
+            if(tag < 128) {
+                const Long len(tag + 1);
+                if(ic + len > inbytes || ip + len > n) {
+                    return false;
+                }
+                std::memcpy(p + ip, c + ic, len);
+                ic += len;
+                ip += len;
+            } else {
+                Long len(tag - 127);
+                if(tag == 255) {
+                    if(ic + 8 > inbytes) {
+                        return false;
+                    }
+                    len = 0;
+                    for(int b(0); b < 8; ++b) {
+                        len |= static_cast<Long>(c[ic++]) << (8 * b);
+                    }
+                }
+                if(len < 0 || ip + len > n) {
+                    return false;
+                }
+                std::memset(p + ip, 0, len);
+                ip += len;
+            }
+        }
+        if(ip != n) {
+            return false;
+        }
+
+        for(int k(0); k < nbytes; ++k) {
+            const unsigned char *pk = planes.data() + k * nvals;
+            unsigned char prev(0);
+            for(Long i(0); i < nvals; ++i) {
+                prev ^= pk[i];
+                out[i * nbytes + k] = static_cast<char>(prev);
+            }
+        }
+        return true;
+    }
+}
+
+
+Long
+VisMF::WriteCompressed (const FabArray<FArrayBox> &mf,
+                        std::ostream &os,
+                        const RealDescriptor &whichRD,
+                        Vector< Vector<Long> > &localChunkEnds,
+                        const Vector<int> *skip)
+{
+    BL_PROFILE("VisMF::WriteCompressed");
+
+    const int nComp(mf.nComp());
+    const int whichRDBytes(whichRD.numBytes());
+    const bool doConvert(whichRD != FPC::NativeRealDescriptor());
+    const Long chunkSize(compressionChunkSize);
+    const Vector<int> &localIndex = mf.IndexArray();
+    const int nLocal(localIndex.size());
+
+    struct Chunk {
+        int  lfab;    // ---- local fab index
+        Long start;   // ---- first value in the fab
+        Long nvals;
+    };
+
+    Vector<Real const*> fabData(nLocal);
+#ifdef AMREX_USE_GPU
+    Vector<std::unique_ptr<FArrayBox> > hostFabs(nLocal);
+#endif
+    Vector<Chunk> chunks;
+    localChunkEnds.clear();
+    localChunkEnds.resize(nLocal);
+    for(int lf(0); lf < nLocal; ++lf) {
+        if(skip != nullptr && (*skip)[localIndex[lf]]) {
+            continue;
+        }
+        const FArrayBox &fab = mf[localIndex[lf]];
+        fabData[lf] = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+        if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+            hostFabs[lf] = std::make_unique<FArrayBox>(fab.box(), fab.nComp(),
+                                                       The_Pinned_Arena());
+            Gpu::dtoh_memcpy_async(hostFabs[lf]->dataPtr(), fab.dataPtr(),
+                                   fab.size()*sizeof(Real));
+            Gpu::streamSynchronize();
+            fabData[lf] = hostFabs[lf]->dataPtr();
+        }
+#endif
+        // ---- chunks never span components so one component can be read alone
+        const Long npts(fab.box().numPts());
+        for(int n(0); n < nComp; ++n) {
+            for(Long start(0); start < npts; start += chunkSize) {
+                chunks.push_back({lf, n * npts + start, std::min(chunkSize, npts - start)});
+            }
+        }
+    }
+
+    int nThreads(1);
+#ifdef AMREX_USE_OMP
+    nThreads = omp_get_max_threads();
+#endif
+    const int nChunks(chunks.size());
+    const int batchSize(2 * nThreads);
+    std::vector< std::vector<char> > buffers[2];
+    buffers[0].resize(batchSize);
+    buffers[1].resize(batchSize);
+    std::future<void> writing;
+    Long bytesWritten(0);
+
+    for(int b0(0); b0 < nChunks; b0 += batchSize) {
+        const int b1(std::min(nChunks, b0 + batchSize));
+        std::vector< std::vector<char> > &bufs = buffers[(b0 / batchSize) % 2];
+
+        // ---- compress this batch while the previous one is being written
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic,1)
+#endif
+        for(int ic = b0; ic < b1; ++ic) {
+            const Chunk &chunk = chunks[ic];
+            Real const* src = fabData[chunk.lfab] + chunk.start;
+            if(doConvert) {
+                std::vector<char> converted(chunk.nvals * whichRDBytes);
+                RealDescriptor::convertFromNativeFormat(converted.data(), chunk.nvals,
+                                                        src, whichRD);
+                CompressChunk(converted.data(), chunk.nvals, whichRDBytes, bufs[ic - b0]);
+            } else {
+                CompressChunk(reinterpret_cast<const char *>(src), chunk.nvals,
+                              whichRDBytes, bufs[ic - b0]);
+            }
+        }
+
+        for(int ic(b0); ic < b1; ++ic) {
+            Vector<Long> &ends = localChunkEnds[chunks[ic].lfab];
+            const Long nbytes(bufs[ic - b0].size());
+            ends.push_back((ends.empty() ? 0 : ends.back()) + nbytes);
+            bytesWritten += nbytes;
+        }
+
+        if(writing.valid()) {
+            writing.get();
+        }
+        writing = std::async(std::launch::async, [&os, &bufs, nb = b1 - b0] ()
+        {
+            for(int i(0); i < nb; ++i) {
+                os.write(bufs[i].data(), bufs[i].size());
+            }
+        });
+    }
+    if(writing.valid()) {
+        writing.get();
+    }
+    os.flush();
+
+    return bytesWritten;
+}
+
+
+void
+VisMF::GatherChunkEnds (const FabArray<FArrayBox> &mf,
+                        VisMF::Header &hdr,
+                        const Vector< Vector<Long> > &localChunkEnds,
+                        int coordinatorProc,
+                        MPI_Comm comm)
+{
+//    BL_PROFILE("VisMF::GatherChunkEnds");
+
+#ifdef BL_USE_MPI
+    const int myProc(ParallelDescriptor::MyProc(comm));
+    const int nProcs(ParallelDescriptor::NProcs(comm));
+
+    // ---- [nchunks, end_0, ..., end_n-1] for each local fab in index order
+    Vector<Long> senddata;
+    for(const auto &ends : localChunkEnds) {
+        senddata.push_back(ends.size());
+        senddata.insert(senddata.end(), ends.begin(), ends.end());
+    }
+    int nSend(senddata.size());
+    if(senddata.empty()) {
+      // Can't let senddata be empty as senddata.dataPtr() will fail.
+      senddata.resize(1);
+    }
+
+    Vector<int> nRecv(nProcs, 0), offset(nProcs, 0);
+    BL_MPI_REQUIRE( MPI_Gather(&nSend, 1, MPI_INT,
+                               nRecv.dataPtr(), 1, MPI_INT,
+                               coordinatorProc, comm) );
+
+    Long nTotal(0);
+    for(int i(0); i < nProcs; ++i) {
+        offset[i] = static_cast<int>(nTotal);
+        nTotal += nRecv[i];
+    }
+    Vector<Long> recvdata(std::max(nTotal, Long(1)));
+
+    BL_MPI_REQUIRE( MPI_Gatherv(senddata.dataPtr(),
+                                nSend,
+                                ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                recvdata.dataPtr(),
+                                nRecv.dataPtr(),
+                                offset.dataPtr(),
+                                ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                coordinatorProc,
+                                comm) );
+
+    if(myProc == coordinatorProc) {
+        const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+        for(int i(0), N(mf.size()); i < N; ++i) {
+            int &pos = offset[pmap[i]];
+            const Long nchunks(recvdata[pos++]);
+            hdr.m_chunkends[i].assign(recvdata.begin() + pos, recvdata.begin() + pos + nchunks);
+            pos += nchunks;
+        }
+    }
+#else
+    amrex::ignore_unused(coordinatorProc, comm);
+    const Vector<int> &localIndex = mf.IndexArray();
+    for(int lf(0); lf < localIndex.size(); ++lf) {
+        hdr.m_chunkends[localIndex[lf]] = localChunkEnds[lf];
+    }
+#endif
+}
+
+
+Long
+VisMF::WriteTwoPhase (const FabArray<FArrayBox> &mf,
+                      const std::string &filePrefix,
+                      const RealDescriptor &whichRD,
+                      const Vector<int> *skip,
+                      MPI_Comm comm)
+{
+    BL_PROFILE("VisMF::WriteTwoPhase");
+
+    const int myProc(ParallelDescriptor::MyProc(comm));
+    const int nProcs(ParallelDescriptor::NProcs(comm));
+    const int nFiles(NFilesIter::ActualNFiles(nOutFiles));
+    const int myFileNumber(NFilesIter::FileNumber(nFiles, myProc, groupSets));
+    const bool oldHeader(currentVersion == VisMF::Header::Version_v1);
+    const bool doConvert(whichRD != FPC::NativeRealDescriptor());
+    const FABio &fio = FArrayBox::getFABio();
+    const int whichRDBytes(whichRD.numBytes());
+
+    Long bytesWritten(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        if(skip != nullptr && (*skip)[mfi.index()]) {
+            continue;
+        }
+        const FArrayBox &fab = mf[mfi];
+        if(oldHeader) {
+            std::stringstream hss;
+            fio.write_header(hss, fab, fab.nComp());
+            bytesWritten += static_cast<std::streamoff>(hss.tellp());
+        }
+        bytesWritten += fab.box().numPts() * mf.nComp() * whichRDBytes;
+    }
+
+    // ---- hand this rank's fabs, as they appear in the file, to consume
+    auto forEachFab = [&] (const std::function<void(const char*, Long)> &consume)
+    {
+        Vector<char> cData;
+        for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if(skip != nullptr && (*skip)[mfi.index()]) {
+                continue;
+            }
+            const FArrayBox &fab = mf[mfi];
+            const Long writeDataItems(fab.box().numPts() * mf.nComp());
+            const Long writeDataSize(writeDataItems * whichRDBytes);
+            if(oldHeader) {
+                std::stringstream hss;
+                fio.write_header(hss, fab, fab.nComp());
+                const std::string tstr(hss.str());
+                consume(tstr.c_str(), tstr.size());
+            }
+            Real const* fabdata = fab.dataPtr();
+#ifdef AMREX_USE_GPU
+            std::unique_ptr<FArrayBox> hostfab;
+            if (fab.arena()->isManaged() || fab.arena()->isDevice()) {
+                hostfab = std::make_unique<FArrayBox>(fab.box(), fab.nComp(),
+                                                      The_Pinned_Arena());
+                Gpu::dtoh_memcpy_async(hostfab->dataPtr(), fab.dataPtr(),
+                                       fab.size()*sizeof(Real));
+                Gpu::streamSynchronize();
+                fabdata = hostfab->dataPtr();
+            }
+#endif
+            if(doConvert) {
+                cData.resize(writeDataSize);
+                RealDescriptor::convertFromNativeFormat(static_cast<void *> (cData.dataPtr()),
+                                                        writeDataItems, fabdata, whichRD);
+                consume(cData.dataPtr(), writeDataSize);
+            } else {
+                consume(reinterpret_cast<const char *> (fabdata), writeDataSize);
+            }
+        }
+    };
+
+    // ---- the aggregator is the lowest rank of the set writing this file
+    Vector<int> setRanks;
+    for(int i(0); i < nProcs; ++i) {
+        if(NFilesIter::FileNumber(nFiles, i, groupSets) == myFileNumber) {
+            setRanks.push_back(i);
+        }
+    }
+    const int aggregator(setRanks[0]);
+
+    // ---- messages are at most one stripe so counts fit in an int
+    const Long pieceSize(std::min(stripeSize, static_cast<Long>(std::numeric_limits<int>::max())));
+    const int sizeTag(ParallelDescriptor::SeqNum());
+    const int dataTag(ParallelDescriptor::SeqNum());
+
+    if(myProc != aggregator) {
+#ifdef BL_USE_MPI
+        // ---- phase one:  pack one piece at a time and send it to the
+        // ---- aggregator, while the next piece is packed into the other buffer
+        BL_MPI_REQUIRE( MPI_Send(&bytesWritten, 1, ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                 aggregator, sizeTag, comm) );
+        const Long bufferSize(std::max(std::min(pieceSize, bytesWritten), Long(1)));
+        std::unique_ptr<char[]> sendBuffer[2] = { std::unique_ptr<char[]>(new char[bufferSize]),
+                                                  std::unique_ptr<char[]>(new char[bufferSize]) };
+        MPI_Request req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+        Long piece(0), fill(0), nSent(0);
+        auto sendPiece = [&] ()
+        {
+            BL_MPI_REQUIRE( MPI_Isend(sendBuffer[piece % 2].get(), static_cast<int>(fill), MPI_CHAR,
+                                      aggregator, dataTag, comm, &req[piece % 2]) );
+            nSent += fill;
+            fill = 0;
+            ++piece;
+            BL_MPI_REQUIRE( MPI_Wait(&req[piece % 2], MPI_STATUS_IGNORE) );
+        };
+        forEachFab([&] (const char *data, Long nBytes)
+        {
+            while(nBytes > 0) {
+                const Long n(std::min(nBytes, pieceSize - fill));
+                std::memcpy(sendBuffer[piece % 2].get() + fill, data, n);
+                fill   += n;
+                data   += n;
+                nBytes -= n;
+                if(fill == pieceSize) {
+                    sendPiece();
+                }
+            }
+        });
+        if(fill > 0) {
+            sendPiece();
+        }
+        BL_MPI_REQUIRE( MPI_Waitall(2, req, MPI_STATUSES_IGNORE) );
+        BL_ASSERT(nSent == bytesWritten);
+#endif
+        return bytesWritten;
+    }
+
+    // ---- phase two:  stage the set's data and write whole stripes
+    std::ofstream ofs;
+    const std::string fileName(NFilesIter::FileName(myFileNumber, filePrefix));
+    ofs.open(fileName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if( ! ofs.good()) {
+        amrex::FileOpenFailed(fileName);
+    }
+
+    std::unique_ptr<char[]> stage(new char[stripeSize]);
+    Long stageFill(0);
+    auto append = [&] (const char *data, Long nBytes)
+    {
+        // ---- full stripes of the caller's data bypass the staging buffer
+        if(stageFill == 0) {
+            const Long nDirect((nBytes / stripeSize) * stripeSize);
+            if(nDirect > 0) {
+                ofs.write(data, nDirect);
+                data   += nDirect;
+                nBytes -= nDirect;
+            }
+        }
+        while(nBytes > 0) {
+            const Long n(std::min(nBytes, stripeSize - stageFill));
+            std::memcpy(stage.get() + stageFill, data, n);
+            stageFill += n;
+            data      += n;
+            nBytes    -= n;
+            if(stageFill == stripeSize) {
+                ofs.write(stage.get(), stageFill);
+                stageFill = 0;
+            }
+        }
+    };
+
+    forEachFab(append);
+
+#ifdef BL_USE_MPI
+    // ---- double buffered:  the next piece arrives while this one is written
+    std::unique_ptr<char[]> recvBuffer[2] = { std::unique_ptr<char[]>(new char[pieceSize]),
+                                              std::unique_ptr<char[]>(new char[pieceSize]) };
+    for(int ri(1); ri < setRanks.size(); ++ri) {
+        const int rank(setRanks[ri]);
+        Long nBytes(0);
+        BL_MPI_REQUIRE( MPI_Recv(&nBytes, 1, ParallelDescriptor::Mpi_typemap<Long>::type(),
+                                 rank, sizeTag, comm, MPI_STATUS_IGNORE) );
+        const Long nPieces((nBytes + pieceSize - 1) / pieceSize);
+        MPI_Request req[2];
+        auto postRecv = [&] (Long piece)
+        {
+            const int count(static_cast<int>(std::min(pieceSize, nBytes - piece * pieceSize)));
+            BL_MPI_REQUIRE( MPI_Irecv(recvBuffer[piece % 2].get(), count, MPI_CHAR,
+                                      rank, dataTag, comm, &req[piece % 2]) );
+        };
+        if(nPieces > 0) {
+            postRecv(0);
+        }
+        for(Long piece(0); piece < nPieces; ++piece) {
+            BL_MPI_REQUIRE( MPI_Wait(&req[piece % 2], MPI_STATUS_IGNORE) );
+            if(piece + 1 < nPieces) {
+                postRecv(piece + 1);
+            }
+            append(recvBuffer[piece % 2].get(),
+                   std::min(pieceSize, nBytes - piece * pieceSize));
+        }
+    }
+#else
+    amrex::ignore_unused(pieceSize, sizeTag, dataTag);
+#endif
+
+    if(stageFill > 0) {
+        ofs.write(stage.get(), stageFill);
+    }
+    ofs.close();
+    if(ofs.fail()) {
+        amrex::Error("VisMF::WriteTwoPhase:  write failed for " + fileName);
+    }
+
+    return bytesWritten;
+}
+
+void
+VisMF::readCompressed (std::istream &is,
+                       const Header &hdr,
+                       int fabIndex,
+                       Real *fabdata,
+                       int firstComp,
+                       int nComp)
+{
+//    BL_PROFILE("VisMF::readCompressed");
+
+    const Vector<Long> &ends = hdr.m_chunkends[fabIndex];
+    const Long npts(amrex::grow(hdr.m_ba[fabIndex], hdr.m_ngrow).numPts());
+    const Long chunkSize(hdr.m_chunksize);
+    const Long nPerComp((npts + chunkSize - 1) / chunkSize);
+    const Long c0(firstComp * nPerComp);
+    const Long c1((firstComp + nComp) * nPerComp);
+    if(c1 <= c0) {
+        return;
+    }
+    if(c1 > ends.size()) {
+        amrex::Error("VisMF::readCompressed:  bad chunk table in header");
+    }
+
+    // ---- the chunks of consecutive components are contiguous, read them at once
+    const Long begin(c0 > 0 ? ends[c0 - 1] : 0);
+    std::vector<char> cdata(ends[c1 - 1] - begin);
+    is.seekg(begin, std::ios::cur);
+    is.read(cdata.data(), cdata.size());
+    if( ! is.good()) {
+        amrex::Error("VisMF::readCompressed:  read failed");
+    }
+
+    const int rdBytes(hdr.m_writtenRD.numBytes());
+    const bool doConvert(hdr.m_writtenRD != FPC::NativeRealDescriptor());
+    int nBad(0);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel for schedule(dynamic,1) reduction(+:nBad)
+#endif
+    for(Long c = c0; c < c1; ++c) {
+        const Long start((c % nPerComp) * chunkSize);
+        const Long nvals(std::min(chunkSize, npts - start));
+        Real *dst = fabdata + (c / nPerComp - firstComp) * npts + start;
+        const char *src = cdata.data() + (c > 0 ? ends[c - 1] : 0) - begin;
+        const Long srcBytes(ends[c] - (c > 0 ? ends[c - 1] : 0));
+        if(doConvert) {
+            std::vector<char> raw(nvals * rdBytes);
+            if(DecompressChunk(src, srcBytes, nvals, rdBytes, raw.data())) {
+                RealDescriptor::convertToNativeFormat(dst, nvals, raw.data(), hdr.m_writtenRD);
+            } else {
+                ++nBad;
+            }
+        } else if( ! DecompressChunk(src, srcBytes, nvals, rdBytes,
+                                     reinterpret_cast<char *>(dst)))
+        {
+            ++nBad;
+        }
+    }
+    if(nBad > 0) {
+        amrex::Error("VisMF::readCompressed:  corrupt compressed chunk");
+    }
+}
+
+
 VisMF::PersistentIFStream::PersistentIFStream()
     :
     pstr(0),
@@ -2332,6 +3392,14 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
     }
 #endif
 
+    // ---- wait for room in the staging budget before making the copies
+    Long staged_bytes = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        Box bx = strip_ghost ? mfi.validbox() : mfi.fabbox();
+        staged_bytes += bx.numPts() * ncomp * sizeof(Real);
+    }
+    AsyncOut::ReserveStaging(staged_bytes);
+
     auto myfabs = std::make_shared<Vector<FArrayBox> >();
     for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
         Box bx = strip_ghost ? mfi.validbox() : mfi.fabbox();
@@ -2462,6 +3530,9 @@ VisMF::AsyncWriteDoit (const FabArray<FArrayBox>& mf, const std::string& mf_name
         }
 
         AsyncOut::Notify();  // Notify others I am done
+
+        myfabs->clear();
+        AsyncOut::ReleaseStaging(staged_bytes);
     });
 }
 
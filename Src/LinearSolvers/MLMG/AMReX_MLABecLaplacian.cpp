@@ -3,9 +3,148 @@
 #include <AMReX_MultiFabUtil.H>
 
 #include <AMReX_MLABecLap_K.H>
+#include <AMReX_LOUtil_K.H>
 
 namespace amrex {
 
+namespace {
+
+// Stencil of MLABecLaplacian::setStencilStorage, with components
+// [center, low face weights in each direction, inverse diagonal].
+template <typename FAB>
+void
+mlabeclap_build_stencil (FabArray<FAB>& sten, int nc, Real alpha, MultiFab const& acoef,
+                         Array<MultiFab,AMREX_SPACEDIM> const& bcoef,
+                         GpuArray<Real,AMREX_SPACEDIM> const& dh,
+                         BndryRegister const& undrrelxr,
+                         Array<MultiMask,2*AMREX_SPACEDIM> const& maskvals)
+{
+    using T = typename FAB::value_type;
+    sten.define(acoef.boxArray(), acoef.DistributionMap(), (AMREX_SPACEDIM+2)*nc, 1);
+    sten.setVal(T(0.0));
+
+    MultiFab coef(acoef.boxArray(), acoef.DistributionMap(), 2*nc, 0);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(sten, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& tbx = mfi.tilebox();
+        const Box& vbx = mfi.validbox();
+        const auto& s = sten.array(mfi);
+        const Array4<T> c(s, 0);
+        const Array4<T> dinv(s, (AMREX_SPACEDIM+1)*nc);
+        const auto& c0 = coef.array(mfi);
+        const Array4<Real> c1(c0, nc);
+        const auto& afab = acoef.const_array(mfi);
+        AMREX_D_TERM(const auto& bxfab = bcoef[0].const_array(mfi);,
+                     const auto& byfab = bcoef[1].const_array(mfi);,
+                     const auto& bzfab = bcoef[2].const_array(mfi););
+        AMREX_D_TERM(const Real dhx = dh[0];,
+                     const Real dhy = dh[1];,
+                     const Real dhz = dh[2];);
+        OrientationIter oitr;
+        const auto& f0 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f1 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m0 = maskvals[0].array(mfi);
+        const auto& m1 = maskvals[1].array(mfi);
+#if (AMREX_SPACEDIM > 1)
+        const auto& f2 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f3 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m2 = maskvals[2].array(mfi);
+        const auto& m3 = maskvals[3].array(mfi);
+#if (AMREX_SPACEDIM > 2)
+        const auto& f4 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f5 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m4 = maskvals[4].array(mfi);
+        const auto& m5 = maskvals[5].array(mfi);
+#endif
+#endif
+        AMREX_HOST_DEVICE_PARALLEL_FOR_4D(tbx, nc, i, j, k, n,
+        {
+            abec_gsrb_coef(i,j,k,n, c0, c1, alpha, afab,
+                           AMREX_D_DECL(dhx, dhy, dhz),
+                           AMREX_D_DECL(bxfab, byfab, bzfab),
+                           AMREX_D_DECL(m0,m2,m4),
+                           AMREX_D_DECL(m1,m3,m5),
+                           AMREX_D_DECL(f0,f2,f4),
+                           AMREX_D_DECL(f1,f3,f5),
+                           vbx);
+            mlabeclap_sten_diag(i,j,k,n, c, dinv, c0, c1);
+        });
+
+        // The weights of the high faces of the box go in the ghost cells
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            const Box& nbx = mfi.nodaltilebox(idim);
+            const Array4<T> w(s, (idim+1)*nc);
+            const auto& b = bcoef[idim].const_array(mfi);
+            const Real dhi = dh[idim];
+            AMREX_HOST_DEVICE_PARALLEL_FOR_4D(nbx, nc, i, j, k, n,
+            {
+                w(i,j,k,n) = static_cast<T>(dhi*b(i,j,k,n));
+            });
+        }
+    }
+}
+
+template <typename FAB>
+void
+mlabeclap_apply_stencil (MultiFab& out, MultiFab const& in, FabArray<FAB> const& sten, int nc)
+{
+    using T = typename FAB::value_type;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(out, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.tilebox();
+        const auto& xfab = in.const_array(mfi);
+        const auto& yfab = out.array(mfi);
+        const auto& s = sten.const_array(mfi);
+        const Array4<T const> c(s, 0);
+        AMREX_D_TERM(const Array4<T const> wx(s, nc);,
+                     const Array4<T const> wy(s, 2*nc);,
+                     const Array4<T const> wz(s, 3*nc););
+        AMREX_HOST_DEVICE_PARALLEL_FOR_4D(bx, nc, i, j, k, n,
+        {
+            mlabeclap_adotx_sten(i,j,k,n, yfab, xfab, c, AMREX_D_DECL(wx,wy,wz));
+        });
+    }
+}
+
+template <typename FAB>
+void
+mlabeclap_smooth_stencil (MultiFab& sol, MultiFab const& rhs, FabArray<FAB> const& sten,
+                          int nc, int redblack)
+{
+    using T = typename FAB::value_type;
+    MFItInfo mfi_info;
+    if (Gpu::notInLaunchRegion()) mfi_info.EnableTiling().SetDynamic(true);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+    for (MFIter mfi(sol,mfi_info); mfi.isValid(); ++mfi)
+    {
+        const Box& tbx = mfi.tilebox();
+        const auto& solnfab = sol.array(mfi);
+        const auto& rhsfab  = rhs.const_array(mfi);
+        const auto& s = sten.const_array(mfi);
+        const Array4<T const> c(s, 0);
+        AMREX_D_TERM(const Array4<T const> wx(s, nc);,
+                     const Array4<T const> wy(s, 2*nc);,
+                     const Array4<T const> wz(s, 3*nc););
+        const Array4<T const> dinv(s, (AMREX_SPACEDIM+1)*nc);
+        AMREX_HOST_DEVICE_PARALLEL_FOR_4D(tbx, nc, i, j, k, n,
+        {
+            abec_gsrb_sten(i,j,k,n, solnfab, rhsfab, c, AMREX_D_DECL(wx,wy,wz), dinv, redblack);
+        });
+    }
+}
+
+}
+
 MLABecLaplacian::MLABecLaplacian (const Vector<Geometry>& a_geom,
                                   const Vector<BoxArray>& a_grids,
                                   const Vector<DistributionMapping>& a_dmap,
@@ -216,6 +355,44 @@ MLABecLaplacian::setBCoeffs (int amrlev, Vector<Real> const& beta)
     m_needs_update = true;
 }
 
+void
+MLABecLaplacian::setFusedSmoothing (int nsweeps, IntVect const& tile_size) noexcept
+{
+    m_fused_sweeps = nsweeps;
+    m_fused_tile_size = tile_size;
+    m_fused_data.clear();
+}
+
+void
+MLABecLaplacian::setStencilStorage (StencilStorage s)
+{
+    m_stencil_storage_all = s;
+    m_stencil_storage.clear();
+    m_needs_update = true;
+}
+
+void
+MLABecLaplacian::setStencilStorage (int amrlev, int mglev, StencilStorage s)
+{
+    if (m_stencil_storage.empty()) {
+        m_stencil_storage.resize(m_num_amr_levels);
+        for (int alev = 0; alev < m_num_amr_levels; ++alev) {
+            m_stencil_storage[alev].resize(m_num_mg_levels[alev], m_stencil_storage_all);
+        }
+    }
+    m_stencil_storage[amrlev][mglev] = s;
+    m_needs_update = true;
+}
+
+void
+MLABecLaplacian::setMixedPrecision (bool flag)
+{
+    if (flag != m_mixed_precision) {
+        m_mixed_precision = flag;
+        m_needs_update = true;
+    }
+}
+
 void
 MLABecLaplacian::averageDownCoeffs ()
 {
@@ -481,9 +658,69 @@ MLABecLaplacian::prepareForSolve ()
 
     update_singular_flags();
 
+    m_fused_data.clear();
+
+    updateStencil();
+
     m_needs_update = false;
 }
 
+void
+MLABecLaplacian::updateStencil ()
+{
+    m_stencil.clear();
+    m_stencil_reduced.clear();
+
+    if (m_stencil_storage.empty() && m_stencil_storage_all == StencilStorage::none
+        && !m_mixed_precision) return;
+
+    BL_PROFILE("MLABecLaplacian::updateStencil()");
+
+    const int nc = getNComp();
+    m_stencil.resize(m_num_amr_levels);
+    m_stencil_reduced.resize(m_num_amr_levels);
+    for (int alev = 0; alev < m_num_amr_levels; ++alev)
+    {
+        m_stencil[alev].resize(m_num_mg_levels[alev]);
+        m_stencil_reduced[alev].resize(m_num_mg_levels[alev]);
+        for (int mglev = 0; mglev < m_num_mg_levels[alev]; ++mglev)
+        {
+            StencilStorage s = m_stencil_storage.empty()
+                ? m_stencil_storage_all : m_stencil_storage[alev][mglev];
+            if (m_mixed_precision) s = StencilStorage::reduced;
+            if (s == StencilStorage::none || m_overset_mask[alev][mglev]) continue;
+
+            const Real* h = m_geom[alev][mglev].CellSize();
+            GpuArray<Real,AMREX_SPACEDIM> dh{{AMREX_D_DECL(m_b_scalar/(h[0]*h[0]),
+                                                           m_b_scalar/(h[1]*h[1]),
+                                                           m_b_scalar/(h[2]*h[2]))}};
+            if (s == StencilStorage::full) {
+                mlabeclap_build_stencil(m_stencil[alev][mglev], nc, m_a_scalar,
+                                        m_a_coeffs[alev][mglev], m_b_coeffs[alev][mglev], dh,
+                                        m_undrrelxr[alev][mglev], m_maskvals[alev][mglev]);
+            } else {
+                mlabeclap_build_stencil(m_stencil_reduced[alev][mglev], nc, m_a_scalar,
+                                        m_a_coeffs[alev][mglev], m_b_coeffs[alev][mglev], dh,
+                                        m_undrrelxr[alev][mglev], m_maskvals[alev][mglev]);
+            }
+        }
+    }
+}
+
+MLABecLaplacian::StencilStorage
+MLABecLaplacian::useStencil (int amrlev, int mglev, bool smoother) const noexcept
+{
+    if (m_stencil.empty()) {
+        return StencilStorage::none;
+    } else if (!m_stencil[amrlev][mglev].empty()) {
+        return StencilStorage::full;
+    } else if (!m_stencil_reduced[amrlev][mglev].empty() && (smoother || mglev > 0 || m_correction_cycle)) {
+        return StencilStorage::reduced;
+    } else {
+        return StencilStorage::none;
+    }
+}
+
 void
 MLABecLaplacian::update_singular_flags ()
 {
@@ -518,6 +755,15 @@ MLABecLaplacian::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& i
 {
     BL_PROFILE("MLABecLaplacian::Fapply()");
 
+    const StencilStorage sten = useStencil(amrlev, mglev, false);
+    if (sten == StencilStorage::full) {
+        mlabeclap_apply_stencil(out, in, m_stencil[amrlev][mglev], getNComp());
+        return;
+    } else if (sten == StencilStorage::reduced) {
+        mlabeclap_apply_stencil(out, in, m_stencil_reduced[amrlev][mglev], getNComp());
+        return;
+    }
+
     const MultiFab& acoef = m_a_coeffs[amrlev][mglev];
     AMREX_D_TERM(const MultiFab& bxcoef = m_b_coeffs[amrlev][mglev][0];,
                  const MultiFab& bycoef = m_b_coeffs[amrlev][mglev][1];,
@@ -656,6 +902,16 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
         regular_coarsening = mg_coarsen_ratio_vec[mglev-1] == mg_coarsen_ratio;
     }
 
+    const StencilStorage sten = regular_coarsening ? useStencil(amrlev, mglev, true)
+                                                   : StencilStorage::none;
+    if (sten == StencilStorage::full) {
+        mlabeclap_smooth_stencil(sol, rhs, m_stencil[amrlev][mglev], getNComp(), redblack);
+        return;
+    } else if (sten == StencilStorage::reduced) {
+        mlabeclap_smooth_stencil(sol, rhs, m_stencil_reduced[amrlev][mglev], getNComp(), redblack);
+        return;
+    }
+
     const MultiFab& acoef = m_a_coeffs[amrlev][mglev];
     AMREX_ALWAYS_ASSERT(acoef.nGrowVect() == 0);
     AMREX_D_TERM(const MultiFab& bxcoef = m_b_coeffs[amrlev][mglev][0];,
@@ -847,6 +1103,274 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
     }
 }
 
+void
+MLABecLaplacian::smooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs,
+                         bool skip_fillboundary) const
+{
+    if (m_fused_sweeps <= 0) {
+        MLCellLinOp::smooth(amrlev, mglev, sol, rhs, skip_fillboundary);
+    } else if (getFusedSmoothData(amrlev, mglev) != nullptr) {
+        fusedSmooth(mglev, sol, rhs);
+    } else {
+        for (int i = 0; i < m_fused_sweeps; ++i) {
+            MLCellLinOp::smooth(amrlev, mglev, sol, rhs, skip_fillboundary);
+            skip_fillboundary = false;
+        }
+    }
+}
+
+MLABecLaplacian::FusedSmoothData const*
+MLABecLaplacian::getFusedSmoothData (int amrlev, int mglev) const
+{
+    if (amrlev != 0 || Gpu::inLaunchRegion()) return nullptr;
+
+    if (m_fused_data.empty()) m_fused_data.resize(m_num_mg_levels[0]);
+    if (m_fused_data[mglev]) {
+        return m_fused_data[mglev]->supported ? m_fused_data[mglev].get() : nullptr;
+    }
+
+    m_fused_data[mglev] = std::make_unique<FusedSmoothData>();
+    FusedSmoothData& fd = *m_fused_data[mglev];
+
+    const Geometry& geom = m_geom[0][mglev];
+    const Box& domain = geom.Domain();
+    const BoxArray& ba = m_grids[0][mglev];
+    const DistributionMapping& dm = m_dmap[0][mglev];
+
+    // The physical boundary conditions are applied in the ghost cells of
+    // other boxes too, so they must not depend on the box.  Without an AMR
+    // level below, the only other boundaries are those with other boxes.
+    bool supported = m_domain_covered[0] && !m_overset_mask[0][mglev] && !hasHiddenDimension()
+        && (mglev == 0 || mg_coarsen_ratio_vec[mglev-1] == mg_coarsen_ratio)
+        && maxorder <= 3;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        // The colors of periodic images must match
+        if (geom.isPeriodic(idim) && domain.length(idim) % 2 != 0) supported = false;
+    }
+    if (maxorder == 3) {
+        // Otherwise the Dirichlet extrapolation is of lower order in some boxes
+        for (int ibox = 0; ibox < ba.size() && supported; ++ibox) {
+            supported = ba[ibox].shortside() >= 2;
+        }
+    }
+    if (!supported) return nullptr;
+
+    const int nc = getNComp();
+    const int ng = 2*m_fused_sweeps;
+
+    fd.bctype.resize(nc);
+    fd.bccoef.resize(nc);
+    for (int icomp = 0; icomp < nc; ++icomp) {
+        for (OrientationIter oit; oit; ++oit) {
+            const Orientation face = oit();
+            const int idim = face.coordDir();
+            const BCType bct = face.isLow() ? m_lobc[icomp][idim] : m_hibc[icomp][idim];
+            const Real bcl = face.isLow() ? m_domain_bloc_lo[idim] : m_domain_bloc_hi[idim];
+            int& type = fd.bctype[icomp][face];
+            if (bct == BCType::Dirichlet) {
+                type = AMREX_LO_DIRICHLET;
+            } else if (bct == BCType::Neumann) {
+                type = AMREX_LO_NEUMANN;
+            } else if (bct == BCType::reflect_odd) {
+                type = AMREX_LO_REFLECT_ODD;
+            } else {
+                type = AMREX_LO_PERIODIC;
+            }
+            // Same as mllinop_apply_bc_x
+            GpuArray<Real,4> x{{-bcl * geom.InvCellSize(idim), Real(0.5), Real(1.5), Real(2.5)}};
+            poly_interp_coeff(-Real(0.5), &x[0], maxorder, &(fd.bccoef[icomp][face][0]));
+        }
+    }
+
+    const MultiFab& acoef = m_a_coeffs[0][mglev];
+    const auto& undrrelxr = m_undrrelxr[0][mglev];
+    const auto& maskvals  = m_maskvals [0][mglev];
+
+    fd.coef.define(ba, dm, 2*nc, ng);
+    fd.coef.setVal(0.0);
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        const MultiFab& b = m_b_coeffs[0][mglev][idim];
+        fd.bcoef[idim].define(b.boxArray(), dm, nc, ng);
+        fd.bcoef[idim].setVal(0.0);
+        MultiFab::Copy(fd.bcoef[idim], b, 0, 0, nc, 0);
+    }
+    fd.tmp.define(ba, dm, 2*nc, ng);
+    fd.tmp.setVal(0.0);
+
+    const Real* h = geom.CellSize();
+    AMREX_D_TERM(const Real dhx = m_b_scalar/(h[0]*h[0]);,
+                 const Real dhy = m_b_scalar/(h[1]*h[1]);,
+                 const Real dhz = m_b_scalar/(h[2]*h[2]));
+    const Real alpha = m_a_scalar;
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(fd.coef, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& tbx = mfi.tilebox();
+        const Box& vbx = mfi.validbox();
+        const auto& c0 = fd.coef.array(mfi);
+        const Array4<Real> c1(c0, nc);
+        const auto& afab = acoef.const_array(mfi);
+        AMREX_D_TERM(const auto& bxfab = m_b_coeffs[0][mglev][0].const_array(mfi);,
+                     const auto& byfab = m_b_coeffs[0][mglev][1].const_array(mfi);,
+                     const auto& bzfab = m_b_coeffs[0][mglev][2].const_array(mfi););
+        OrientationIter oitr;
+        const auto& f0 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f1 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m0 = maskvals[0].array(mfi);
+        const auto& m1 = maskvals[1].array(mfi);
+#if (AMREX_SPACEDIM > 1)
+        const auto& f2 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f3 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m2 = maskvals[2].array(mfi);
+        const auto& m3 = maskvals[3].array(mfi);
+#if (AMREX_SPACEDIM > 2)
+        const auto& f4 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& f5 = undrrelxr[oitr()].const_array(mfi); ++oitr;
+        const auto& m4 = maskvals[4].array(mfi);
+        const auto& m5 = maskvals[5].array(mfi);
+#endif
+#endif
+        amrex::LoopConcurrentOnCpu(tbx, nc, [&] (int i, int j, int k, int n) noexcept
+        {
+            abec_gsrb_coef(i,j,k,n, c0, c1, alpha, afab,
+                           AMREX_D_DECL(dhx, dhy, dhz),
+                           AMREX_D_DECL(bxfab, byfab, bzfab),
+                           AMREX_D_DECL(m0,m2,m4),
+                           AMREX_D_DECL(m1,m3,m5),
+                           AMREX_D_DECL(f0,f2,f4),
+                           AMREX_D_DECL(f1,f3,f5),
+                           vbx);
+        });
+    }
+
+    fd.coef.FillBoundary(geom.periodicity());
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        fd.bcoef[idim].FillBoundary(geom.periodicity());
+    }
+
+    fd.supported = true;
+    return &fd;
+}
+
+//
+// Each tile and the 2*nsweeps layers of cells around it are copied to a
+// buffer and smoothed there.  The region that is updated shrinks by one
+// cell after each half-sweep, so that at the end the values in the tile
+// are the same as those after nsweeps ordinary sweeps.  The physical
+// boundary conditions are applied in the buffer before each half-sweep.
+//
+void
+MLABecLaplacian::fusedSmooth (int mglev, MultiFab& sol, const MultiFab& rhs) const
+{
+    BL_PROFILE("MLABecLaplacian::fusedSmooth()");
+
+    FusedSmoothData& fd = *m_fused_data[mglev];
+
+    const int nc = getNComp();
+    const int nhalf = 2*m_fused_sweeps;
+    const Geometry& geom = m_geom[0][mglev];
+    const Box& domain = geom.Domain();
+    // Cells that are updated, including periodic images
+    const Box& active = geom.growPeriodicDomain(nhalf);
+
+    MultiFab::Copy(fd.tmp, sol, 0,  0, nc, 0);
+    MultiFab::Copy(fd.tmp, rhs, 0, nc, nc, 0);
+    fd.tmp.FillBoundary(geom.periodicity());
+
+    const Real* h = geom.CellSize();
+    AMREX_D_TERM(const Real dhx = m_b_scalar/(h[0]*h[0]);,
+                 const Real dhy = m_b_scalar/(h[1]*h[1]);,
+                 const Real dhz = m_b_scalar/(h[2]*h[2]));
+
+    const int imaxorder = maxorder;
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    {
+        FArrayBox buf;
+        for (MFIter mfi(sol, MFItInfo().EnableTiling(m_fused_tile_size).SetDynamic(true));
+             mfi.isValid(); ++mfi)
+        {
+            const Box& tbx = mfi.tilebox();
+            const Box& gbx = amrex::grow(tbx, nhalf);
+
+            buf.resize(gbx, nc);
+            const auto& phi = buf.array();
+            const auto& tmpfab = fd.tmp.const_array(mfi);
+            const Array4<Real const> rhsfab(tmpfab, nc);
+            const auto& c0 = fd.coef.const_array(mfi);
+            const Array4<Real const> c1(c0, nc);
+            AMREX_D_TERM(const auto& bxfab = fd.bcoef[0].const_array(mfi);,
+                         const auto& byfab = fd.bcoef[1].const_array(mfi);,
+                         const auto& bzfab = fd.bcoef[2].const_array(mfi););
+
+            amrex::LoopConcurrentOnCpu(gbx, nc, [&] (int i, int j, int k, int n) noexcept
+            {
+                phi(i,j,k,n) = tmpfab(i,j,k,n);
+            });
+
+            for (int ihalf = 0; ihalf < nhalf; ++ihalf)
+            {
+                const Box& bx = amrex::grow(tbx, nhalf-1-ihalf) & active;
+
+                for (OrientationIter oit; oit; ++oit) {
+                    const Orientation face = oit();
+                    const int idim = face.coordDir();
+                    if (geom.isPeriodic(idim) || bx[face] != domain[face]) continue;
+                    const Box& bbx = amrex::adjCell(bx, face);
+                    GpuArray<int,3> d{{0,0,0}};
+                    d[idim] = face.isLow() ? 1 : -1;
+                    for (int n = 0; n < nc; ++n) {
+                        const int bct = fd.bctype[n][face];
+                        const auto& coef = fd.bccoef[n][face];
+                        amrex::LoopOnCpu(bbx, [&] (int i, int j, int k) noexcept
+                        {
+                            if (bct == AMREX_LO_NEUMANN) {
+                                phi(i,j,k,n) = phi(i+d[0],j+d[1],k+d[2],n);
+                            } else if (bct == AMREX_LO_REFLECT_ODD) {
+                                phi(i,j,k,n) = -phi(i+d[0],j+d[1],k+d[2],n);
+                            } else if (bct == AMREX_LO_DIRICHLET) {
+                                Real tmp = Real(0.0);
+                                for (int m = 1; m < imaxorder; ++m) {
+                                    tmp += phi(i+m*d[0],j+m*d[1],k+m*d[2],n) * coef[m];
+                                }
+                                phi(i,j,k,n) = tmp;
+                            }
+                        });
+                    }
+                }
+
+                // Only the cells of one color, i+j+k+redblack even.  The
+                // indices may be negative.
+                const int redblack = ihalf % 2;
+                const auto lo = amrex::lbound(bx);
+                const auto hi = amrex::ubound(bx);
+                for (int n = 0; n < nc; ++n) {
+                for (int k = lo.z; k <= hi.z; ++k) {
+                for (int j = lo.y; j <= hi.y; ++j) {
+                    const int ilo = lo.x + ((lo.x+j+k+redblack) & 1);
+                    AMREX_PRAGMA_SIMD
+                    for (int i = ilo; i <= hi.x; i += 2) {
+                        abec_gsrb_fused(i,j,k,n, phi, rhsfab, c0, c1,
+                                        AMREX_D_DECL(dhx, dhy, dhz),
+                                        AMREX_D_DECL(bxfab, byfab, bzfab));
+                    }
+                }}}
+            }
+
+            const auto& solfab = sol.array(mfi);
+            amrex::LoopConcurrentOnCpu(tbx, nc, [&] (int i, int j, int k, int n) noexcept
+            {
+                solfab(i,j,k,n) = phi(i,j,k,n);
+            });
+        }
+    }
+}
+
 void
 MLABecLaplacian::FFlux (int amrlev, const MFIter& mfi,
                         const Array<FArrayBox*,AMREX_SPACEDIM>& flux,
@@ -947,6 +1471,10 @@ MLABecLaplacian::update ()
 
     update_singular_flags();
 
+    m_fused_data.clear();
+
+    updateStencil();
+
     m_needs_update = false;
 }
 
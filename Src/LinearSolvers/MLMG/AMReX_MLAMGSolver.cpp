@@ -0,0 +1,996 @@
+
+#include <AMReX_MLAMGSolver.H>
+#include <AMReX_Loop.H>
+#include <AMReX_ParallelContext.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+
+namespace amrex {
+
+namespace {
+
+using CSR = MLAMGSolver::CSR;
+
+constexpr int nsten = AMREX_D_TERM(3,*3,*3);
+
+// Offset of stencil entry n in {-1,0,1}^AMREX_SPACEDIM
+AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+IntVect sten_offset (int n) noexcept
+{
+    return IntVect(AMREX_D_DECL(n%3-1, (n/3)%3-1, (n/9)%3-1));
+}
+
+// Color of iv in a coloring that repeats with the given period
+AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+int probe_color (IntVect const& iv, IntVect const& lo, IntVect const& period) noexcept
+{
+    int c = 0;
+    int stride = 1;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        int r = (iv[idim] - lo[idim]) % period[idim];
+        if (r < 0) { r += period[idim]; }
+        c += r*stride;
+        stride *= period[idim];
+    }
+    return c;
+}
+
+Real tolerance () noexcept
+{
+    return std::sqrt(std::numeric_limits<Real>::epsilon());
+}
+
+// y = A x
+void spmv (CSR const& A, Real const* x, Real* y)
+{
+    for (int i = 0; i < A.nrows; ++i) {
+        Real s = 0;
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            s += A.val[p]*x[A.col[p]];
+        }
+        y[i] = s;
+    }
+}
+
+// r = b - A x
+void residual (CSR const& A, Real const* x, Real const* b, Real* r)
+{
+    for (int i = 0; i < A.nrows; ++i) {
+        Real s = b[i];
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            s -= A.val[p]*x[A.col[p]];
+        }
+        r[i] = s;
+    }
+}
+
+Real dot (Vector<Real> const& x, Vector<Real> const& y)
+{
+    return std::inner_product(x.begin(), x.end(), y.begin(), Real(0.));
+}
+
+Real norm_inf (Vector<Real> const& x)
+{
+    Real r = 0;
+    for (auto v : x) { r = std::max(r, std::abs(v)); }
+    return r;
+}
+
+CSR transpose (CSR const& A, int ncols)
+{
+    CSR T;
+    T.nrows = ncols;
+    T.ptr.assign(ncols+1, 0);
+    const Long nnz = A.ptr[A.nrows];
+    for (Long p = 0; p < nnz; ++p) {
+        ++T.ptr[A.col[p]+1];
+    }
+    std::partial_sum(T.ptr.begin(), T.ptr.end(), T.ptr.begin());
+    T.col.resize(nnz);
+    T.val.resize(nnz);
+    Vector<Long> next(T.ptr.begin(), T.ptr.end()-1);
+    for (int i = 0; i < A.nrows; ++i) {
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            const Long q = next[A.col[p]]++;
+            T.col[q] = i;
+            T.val[q] = A.val[p];
+        }
+    }
+    return T;
+}
+
+// C = A B, where B has ncols columns
+CSR matmul (CSR const& A, CSR const& B, int ncols)
+{
+    CSR C;
+    C.nrows = A.nrows;
+    C.ptr.resize(A.nrows+1);
+    C.ptr[0] = 0;
+    Vector<int> marker(ncols, -1);
+    Vector<Real> acc(ncols);
+    Vector<int> cols;
+    for (int i = 0; i < A.nrows; ++i) {
+        cols.clear();
+        for (Long pa = A.ptr[i]; pa < A.ptr[i+1]; ++pa) {
+            const int k = A.col[pa];
+            const Real a = A.val[pa];
+            for (Long pb = B.ptr[k]; pb < B.ptr[k+1]; ++pb) {
+                const int j = B.col[pb];
+                if (marker[j] != i) {
+                    marker[j] = i;
+                    acc[j] = a*B.val[pb];
+                    cols.push_back(j);
+                } else {
+                    acc[j] += a*B.val[pb];
+                }
+            }
+        }
+        std::sort(cols.begin(), cols.end());
+        for (int j : cols) {
+            C.col.push_back(j);
+            C.val.push_back(acc[j]);
+        }
+        C.ptr[i+1] = C.col.size();
+    }
+    return C;
+}
+
+Vector<Real> diagonal (CSR const& A)
+{
+    Vector<Real> d(A.nrows, Real(0.));
+    for (int i = 0; i < A.nrows; ++i) {
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            if (A.col[p] == i) { d[i] = A.val[p]; }
+        }
+    }
+    return d;
+}
+
+// Max norm of A - A^T relative to the max norm of A
+Real asymmetry (CSR const& A)
+{
+    CSR T = transpose(A, A.nrows);
+    Real amax = 0, dmax = 0;
+    for (int i = 0; i < A.nrows; ++i) {
+        Long p = A.ptr[i], q = T.ptr[i];
+        while (p < A.ptr[i+1] || q < T.ptr[i+1]) {
+            if (q == T.ptr[i+1] || (p < A.ptr[i+1] && A.col[p] < T.col[q])) {
+                dmax = std::max(dmax, std::abs(A.val[p]));
+                amax = std::max(amax, std::abs(A.val[p]));
+                ++p;
+            } else if (p == A.ptr[i+1] || T.col[q] < A.col[p]) {
+                dmax = std::max(dmax, std::abs(T.val[q]));
+                ++q;
+            } else {
+                dmax = std::max(dmax, std::abs(A.val[p]-T.val[q]));
+                amax = std::max(amax, std::abs(A.val[p]));
+                ++p; ++q;
+            }
+        }
+    }
+    return (amax > 0) ? dmax/amax : Real(0.);
+}
+
+// Estimate of the spectral radius of D^{-1} A by power iteration
+Real spectral_radius (CSR const& A, Vector<Real> const& diag)
+{
+    const int n = A.nrows;
+    Vector<Real> v(n), w(n);
+    for (int i = 0; i < n; ++i) {
+        v[i] = Real(1.0) + Real(0.1)*(i%7);
+    }
+    Real nv = std::sqrt(dot(v,v));
+    for (auto& x : v) { x /= nv; }
+    Real rho = 0;
+    for (int it = 0; it < 15; ++it) {
+        spmv(A, v.data(), w.data());
+        for (int i = 0; i < n; ++i) {
+            w[i] = (diag[i] != Real(0.)) ? w[i]/diag[i] : Real(0.);
+        }
+        nv = std::sqrt(dot(w,w));
+        if (nv == Real(0.)) { break; }
+        rho = std::max(rho, nv);
+        for (int i = 0; i < n; ++i) { v[i] = w[i]/nv; }
+    }
+    return rho;
+}
+
+//
+// Greedy aggregation (Vanek, Mandel & Brezina, 1996) on the graph of
+// strong connections |a_ij| >= theta max_{k!=i} |a_ik|.  Returns the
+// number of aggregates.  Points without strong connections are left out
+// (agg = -1), the smoother takes care of them.
+//
+int aggregate (CSR const& A, Real theta, Vector<int>& agg)
+{
+    const int n = A.nrows;
+    Vector<Long> sptr(n+1, 0);
+    Vector<int> scol;
+    Vector<Real> sval;
+    for (int i = 0; i < n; ++i) {
+        Real amax = 0;
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            if (A.col[p] != i) { amax = std::max(amax, std::abs(A.val[p])); }
+        }
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            const int j = A.col[p];
+            const Real a = std::abs(A.val[p]);
+            if (j != i && a > Real(0.) && a >= theta*amax) {
+                scol.push_back(j);
+                sval.push_back(a);
+            }
+        }
+        sptr[i+1] = scol.size();
+    }
+
+    agg.assign(n, -1);
+    int nagg = 0;
+
+    // Roots whose strong neighborhoods are all free
+    for (int i = 0; i < n; ++i) {
+        if (agg[i] != -1 || sptr[i] == sptr[i+1]) { continue; }
+        bool free = true;
+        for (Long p = sptr[i]; p < sptr[i+1] && free; ++p) {
+            free = agg[scol[p]] == -1;
+        }
+        if (free) {
+            agg[i] = nagg;
+            for (Long p = sptr[i]; p < sptr[i+1]; ++p) {
+                agg[scol[p]] = nagg;
+            }
+            ++nagg;
+        }
+    }
+
+    // Join the aggregate of the most strongly connected neighbor
+    const Vector<int> agg1 = agg;
+    for (int i = 0; i < n; ++i) {
+        if (agg[i] != -1) { continue; }
+        Real vmax = 0;
+        for (Long p = sptr[i]; p < sptr[i+1]; ++p) {
+            if (agg1[scol[p]] != -1 && sval[p] > vmax) {
+                vmax = sval[p];
+                agg[i] = agg1[scol[p]];
+            }
+        }
+    }
+
+    // The rest form aggregates with their free neighbors
+    for (int i = 0; i < n; ++i) {
+        if (agg[i] != -1 || sptr[i] == sptr[i+1]) { continue; }
+        agg[i] = nagg;
+        for (Long p = sptr[i]; p < sptr[i+1]; ++p) {
+            if (agg[scol[p]] == -1) { agg[scol[p]] = nagg; }
+        }
+        ++nagg;
+    }
+
+    return nagg;
+}
+
+// P = (I - omega D^{-1} A) T, where T is the tentative prolongation of
+// the constant vector over the aggregates.
+CSR smoothed_prolongation (CSR const& A, Vector<Real> const& diag,
+                           Vector<int> const& agg, int nagg)
+{
+    const int n = A.nrows;
+
+    Vector<int> size(nagg, 0);
+    for (int i = 0; i < n; ++i) {
+        if (agg[i] >= 0) { ++size[agg[i]]; }
+    }
+
+    CSR T;
+    T.nrows = n;
+    T.ptr.resize(n+1);
+    T.ptr[0] = 0;
+    for (int i = 0; i < n; ++i) {
+        if (agg[i] >= 0) {
+            T.col.push_back(agg[i]);
+            T.val.push_back(Real(1.0)/std::sqrt(Real(size[agg[i]])));
+        }
+        T.ptr[i+1] = T.col.size();
+    }
+
+    const Real rho = spectral_radius(A, diag);
+    const Real omega = (rho > Real(0.)) ? Real(4./3.)/rho : Real(0.);
+
+    CSR AT = matmul(A, T, nagg);
+
+    CSR P;
+    P.nrows = n;
+    P.ptr.resize(n+1);
+    P.ptr[0] = 0;
+    for (int i = 0; i < n; ++i) {
+        const Real f = (diag[i] != Real(0.)) ? omega/diag[i] : Real(0.);
+        Long q = T.ptr[i];
+        for (Long p = AT.ptr[i]; p < AT.ptr[i+1]; ++p) {
+            const int j = AT.col[p];
+            Real v = -f*AT.val[p];
+            if (q < T.ptr[i+1] && T.col[q] < j) {
+                P.col.push_back(T.col[q]);
+                P.val.push_back(T.val[q]);
+                ++q;
+            }
+            if (q < T.ptr[i+1] && T.col[q] == j) {
+                v += T.val[q];
+                ++q;
+            }
+            if (v != Real(0.)) {
+                P.col.push_back(j);
+                P.val.push_back(v);
+            }
+        }
+        for (; q < T.ptr[i+1]; ++q) {
+            P.col.push_back(T.col[q]);
+            P.val.push_back(T.val[q]);
+        }
+        P.ptr[i+1] = P.col.size();
+    }
+    return P;
+}
+
+}
+
+MLAMGSolver::MLAMGSolver (MLLinOp& a_lp)
+    : Lp(a_lp),
+      amrlev(0),
+      mglev(a_lp.NMGLevels(0)-1)
+{}
+
+MLAMGSolver::~MLAMGSolver ()
+{}
+
+bool
+MLAMGSolver::setup (const MultiFab& x)
+{
+    BL_PROFILE("MLAMGSolver::setup()");
+
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(x.nComp() == 1, "MLAMGSolver doesn't work with ncomp > 1");
+
+    bool ok = assemble(x) && verify(x);
+
+    if (ok && m_is_root) {
+        buildHierarchy();
+    }
+
+    return ok;
+}
+
+bool
+MLAMGSolver::assemble (const MultiFab& x)
+{
+    BL_PROFILE("MLAMGSolver::assemble()");
+
+    const BoxArray& ba = x.boxArray();
+    const DistributionMapping& dm = x.DistributionMap();
+    const Geometry& geom = Lp.m_geom[amrlev][mglev];
+    const Box& domain = geom.Domain();
+    const IntVect dlo = domain.smallEnd();
+
+    // Color so that the points in the 3^AMREX_SPACEDIM neighborhood of any
+    // point have distinct colors, also across periodic boundaries.  Then
+    // A(i,j) is the value at i of A applied to the indicator of j's color.
+    IntVect period(3);
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        if (geom.isPeriodic(idim)) {
+            const int len = domain.length(idim);
+            period[idim] = len;
+            for (int m = 3; m < len; ++m) {
+                if (len % m == 0) {
+                    period[idim] = m;
+                    break;
+                }
+            }
+        }
+    }
+    const int ncolors = AMREX_D_TERM(period[0],*period[1],*period[2]);
+
+    MultiFab sten(ba, dm, nsten, 0);
+    MultiFab in(ba, dm, 1, x.nGrowVect(), MFInfo(), x.Factory());
+    MultiFab out(ba, dm, 1, 0, MFInfo(), x.Factory());
+    sten.setVal(0.0);
+
+    for (int c = 0; c < ncolors; ++c)
+    {
+        in.setVal(0.0);
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(in,TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+            Array4<Real> const& a = in.array(mfi);
+            AMREX_HOST_DEVICE_PARALLEL_FOR_3D(bx, i, j, k,
+            {
+                if (probe_color(IntVect(AMREX_D_DECL(i,j,k)), dlo, period) == c) {
+                    a(i,j,k) = 1.0;
+                }
+            });
+        }
+
+        Lp.apply(amrlev, mglev, out, in, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(sten,TilingIfNotGPU()); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+            Array4<Real> const& s = sten.array(mfi);
+            Array4<Real const> const& o = out.const_array(mfi);
+            AMREX_HOST_DEVICE_PARALLEL_FOR_3D(bx, i, j, k,
+            {
+                const IntVect iv(AMREX_D_DECL(i,j,k));
+                // If two neighbors have the same color, they are periodic
+                // images of the same point, so only one gets the entry.
+                for (int n = 0; n < nsten; ++n) {
+                    if (probe_color(iv+sten_offset(n), dlo, period) == c) {
+                        s(i,j,k,n) = o(i,j,k);
+                        break;
+                    }
+                }
+            });
+        }
+    }
+
+    // Everything else happens on the first rank of the bottom communicator.
+    m_is_root = ParallelContext::MyProcSub() == 0;
+    m_dm_root = DistributionMapping(Vector<int>(ba.size(), ParallelContext::local_to_global_rank(0)));
+
+    MultiFab sten_root(ba, m_dm_root, nsten, 0, MFInfo().SetArena(The_Pinned_Arena()));
+    sten_root.ParallelCopy(sten, 0, 0, nsten);
+
+    m_id.define(ba, m_dm_root, 1, 1, MFInfo().SetArena(The_Pinned_Arena()));
+    m_id.setVal(-1);
+    if (!x.ixType().cellCentered()) {
+        auto owner = amrex::OwnerMask(m_id, geom.periodicity());
+        m_owner = std::make_unique<iMultiFab>(ba, m_dm_root, 1, 0,
+                                              MFInfo().SetArena(The_Pinned_Arena()));
+        iMultiFab::Copy(*m_owner, *owner, 0, 0, 1, 0);
+    }
+    Gpu::streamSynchronize();
+
+    int nrows = 0;
+    for (MFIter mfi(m_id); mfi.isValid(); ++mfi)
+    {
+        Array4<int> const& id = m_id.array(mfi);
+        Array4<int const> const& owner = m_owner ? m_owner->const_array(mfi) : Array4<int const>{};
+        amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+        {
+            if (!owner || owner(i,j,k)) {
+                id(i,j,k) = nrows++;
+            }
+        });
+    }
+
+    if (m_owner) {
+        amrex::OverrideSync(m_id, *m_owner, geom.periodicity());
+    }
+    m_id.setBndry(-1);
+    m_id.FillBoundary(geom.periodicity());
+    Gpu::streamSynchronize();
+
+    int ok = 1;
+    if (m_is_root)
+    {
+        m_levels.clear();
+        m_levels.resize(1);
+        CSR& A = m_levels[0].A;
+        A.nrows = nrows;
+        A.ptr.reserve(nrows+1);
+        A.ptr.push_back(0);
+        m_inactive.assign(nrows, 0);
+
+        Vector<std::pair<int,Real> > row;
+        for (MFIter mfi(m_id); mfi.isValid(); ++mfi)
+        {
+            Array4<int const> const& id = m_id.const_array(mfi);
+            Array4<Real const> const& s = sten_root.const_array(mfi);
+            Array4<int const> const& owner = m_owner ? m_owner->const_array(mfi) : Array4<int const>{};
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+            {
+                if (owner && !owner(i,j,k)) { return; }
+                const IntVect iv(AMREX_D_DECL(i,j,k));
+                row.clear();
+                for (int n = 0; n < nsten; ++n) {
+                    const Real v = s(iv,n);
+                    const int col = id(iv+sten_offset(n));
+                    // Couplings outside the domain have been folded into the
+                    // stencil by the boundary conditions.
+                    if (v != Real(0.) && col >= 0) {
+                        row.emplace_back(col, v);
+                    }
+                }
+                const int r = id(iv);
+                if (row.empty()) {
+                    // e.g., a Dirichlet node, which stays zero
+                    m_inactive[r] = 1;
+                    row.emplace_back(r, Real(1.));
+                }
+                std::sort(row.begin(), row.end(),
+                          [] (std::pair<int,Real> const& a, std::pair<int,Real> const& b)
+                          { return a.first < b.first; });
+                bool has_diag = false;
+                for (Long m = 0; m < Long(row.size()); ++m) {
+                    if (m > 0 && row[m].first == row[m-1].first) {
+                        A.val.back() += row[m].second;
+                    } else {
+                        A.col.push_back(row[m].first);
+                        A.val.push_back(row[m].second);
+                    }
+                    has_diag = has_diag || (row[m].first == r);
+                }
+                if (!has_diag) { ok = 0; }
+                A.ptr.push_back(A.col.size());
+            });
+        }
+
+        // Decouple the inactive rows, whose solution is zero.
+        Long nnz = 0;
+        for (int i = 0; i < A.nrows; ++i) {
+            const Long p0 = A.ptr[i];
+            A.ptr[i] = nnz;
+            for (Long p = p0; p < A.ptr[i+1]; ++p) {
+                if (!m_inactive[A.col[p]] || A.col[p] == i) {
+                    A.col[nnz] = A.col[p];
+                    A.val[nnz] = A.val[p];
+                    ++nnz;
+                }
+            }
+        }
+        A.ptr[A.nrows] = nnz;
+        A.col.resize(nnz);
+        A.val.resize(nnz);
+    }
+
+    ParallelDescriptor::Bcast(&ok, 1, 0, ParallelContext::CommunicatorSub());
+
+    return ok;
+}
+
+bool
+MLAMGSolver::verify (const MultiFab& x)
+{
+    BL_PROFILE("MLAMGSolver::verify()");
+
+    const BoxArray& ba = x.boxArray();
+    const DistributionMapping& dm = x.DistributionMap();
+
+    MultiFab v_root(ba, m_dm_root, 1, 0, MFInfo().SetArena(The_Pinned_Arena()));
+    MultiFab av_root(ba, m_dm_root, 1, 0, MFInfo().SetArena(The_Pinned_Arena()));
+
+    Vector<Real> vv;
+    if (m_is_root)
+    {
+        const CSR& A = m_levels[0].A;
+        vv.resize(A.nrows);
+        // A local engine with a fixed seed, so that the check neither
+        // depends on nor disturbs the state of amrex::Random.
+        std::mt19937 gen(A.nrows);
+        std::uniform_real_distribution<Real> dist(Real(-1.), Real(1.));
+        for (int i = 0; i < A.nrows; ++i) {
+            vv[i] = m_inactive[i] ? Real(0.) : dist(gen);
+        }
+        for (MFIter mfi(v_root); mfi.isValid(); ++mfi)
+        {
+            Array4<Real> const& v = v_root.array(mfi);
+            Array4<int const> const& id = m_id.const_array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+            {
+                v(i,j,k) = (id(i,j,k) >= 0) ? vv[id(i,j,k)] : Real(0.);
+            });
+        }
+    }
+
+    MultiFab v(ba, dm, 1, x.nGrowVect(), MFInfo(), x.Factory());
+    MultiFab av(ba, dm, 1, 0, MFInfo(), x.Factory());
+    v.setVal(0.0);
+    v.ParallelCopy(v_root, 0, 0, 1);
+    Lp.apply(amrlev, mglev, av, v, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+    av_root.ParallelCopy(av, 0, 0, 1);
+    Gpu::streamSynchronize();
+
+    int ok = 1;
+    if (m_is_root)
+    {
+        const CSR& A = m_levels[0].A;
+        Vector<Real> y(A.nrows);
+        spmv(A, vv.data(), y.data());
+        Real err = 0, ymax = 0;
+        for (MFIter mfi(av_root); mfi.isValid(); ++mfi)
+        {
+            Array4<Real const> const& a = av_root.const_array(mfi);
+            Array4<int const> const& id = m_id.const_array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+            {
+                const int r = id(i,j,k);
+                if (r >= 0 && !m_inactive[r]) {
+                    err = std::max(err, std::abs(a(i,j,k)-y[r]));
+                    ymax = std::max(ymax, std::abs(a(i,j,k)));
+                }
+            });
+        }
+        const Real relerr = (ymax > 0) ? err/ymax : err;
+        ok = relerr <= tolerance();
+        if (verbose > 0) {
+            amrex::Print() << "MLAMGSolver: " << A.nrows << " rows, " << A.ptr[A.nrows]
+                           << " nonzeros, rel. err. of assembled operator " << relerr << "\n";
+        }
+    }
+
+    ParallelDescriptor::Bcast(&ok, 1, 0, ParallelContext::CommunicatorSub());
+
+    return ok;
+}
+
+void
+MLAMGSolver::buildHierarchy ()
+{
+    BL_PROFILE("MLAMGSolver::buildHierarchy()");
+
+    m_symmetric = asymmetry(m_levels[0].A) <= tolerance();
+
+    constexpr int max_levels = 25;
+    for (int lev = 0; ; ++lev)
+    {
+        m_levels[lev].diag = diagonal(m_levels[lev].A);
+
+        const CSR& A = m_levels[lev].A;
+        if (A.nrows <= max_coarse_size || lev+1 == max_levels) { break; }
+
+        Vector<int> agg;
+        const int nagg = aggregate(A, strong_threshold, agg);
+        if (nagg == 0 || nagg >= A.nrows) { break; }
+
+        CSR P = smoothed_prolongation(A, m_levels[lev].diag, agg, nagg);
+        CSR R = transpose(P, nagg);
+        CSR AP = matmul(A, P, nagg);
+        CSR Ac = matmul(R, AP, nagg);
+
+        m_levels[lev].P = std::move(P);
+        m_levels[lev].R = std::move(R);
+        m_levels.emplace_back();
+        m_levels[lev+1].A = std::move(Ac);
+    }
+    m_nlevels = m_levels.size();
+
+    for (auto& L : m_levels) {
+        L.x.resize(L.A.nrows);
+        L.b.resize(L.A.nrows);
+        L.r.resize(L.A.nrows);
+    }
+
+    buildCoarseSolver();
+
+    if (verbose > 0) {
+        Long nnz = 0;
+        amrex::Print() << "MLAMGSolver: " << m_nlevels << " levels with";
+        for (auto const& L : m_levels) {
+            amrex::Print() << " " << L.A.nrows;
+            nnz += L.A.ptr[L.A.nrows];
+        }
+        amrex::Print() << " rows, operator complexity "
+                       << Real(nnz)/Real(m_levels[0].A.ptr[m_levels[0].A.nrows])
+                       << (m_symmetric ? ", symmetric" : ", nonsymmetric")
+                       << (m_coarse_direct ? ", direct" : ", smoothed") << " coarse solve\n";
+    }
+}
+
+void
+MLAMGSolver::buildCoarseSolver ()
+{
+    const CSR& A = m_levels.back().A;
+    const int n = A.nrows;
+
+    m_coarse_direct = n <= std::max(max_coarse_size, 1000);
+    if (!m_coarse_direct) { return; }
+
+    // Dense LU with partial pivoting
+    m_lu.assign(Long(n)*n, Real(0.));
+    m_piv.resize(n);
+    Real amax = 0;
+    for (int i = 0; i < n; ++i) {
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            m_lu[Long(i)*n+A.col[p]] = A.val[p];
+            amax = std::max(amax, std::abs(A.val[p]));
+        }
+    }
+
+    // For singular problems, the unknowns of tiny pivots are set to zero.
+    const Real tiny = Lp.isBottomSingular() ? tolerance()*amax : Real(0.);
+
+    auto lu = [&] (int i, int j) -> Real& { return m_lu[Long(i)*n+j]; };
+    for (int k = 0; k < n; ++k) {
+        int ip = k;
+        for (int i = k+1; i < n; ++i) {
+            if (std::abs(lu(i,k)) > std::abs(lu(ip,k))) { ip = i; }
+        }
+        m_piv[k] = ip;
+        if (ip != k) {
+            for (int j = 0; j < n; ++j) { std::swap(lu(k,j), lu(ip,j)); }
+        }
+        const Real d = lu(k,k);
+        if (std::abs(d) <= tiny) {
+            lu(k,k) = 0;
+            for (int i = k+1; i < n; ++i) { lu(i,k) = 0; }
+            continue;
+        }
+        for (int i = k+1; i < n; ++i) {
+            const Real l = lu(i,k) /= d;
+            if (l != Real(0.)) {
+                for (int j = k+1; j < n; ++j) { lu(i,j) -= l*lu(k,j); }
+            }
+        }
+    }
+}
+
+void
+MLAMGSolver::coarseSolve ()
+{
+    Level& L = m_levels.back();
+    const int n = L.A.nrows;
+
+    if (m_coarse_direct)
+    {
+        Vector<Real>& x = L.x;
+        x = L.b;
+        for (int k = 0; k < n; ++k) {
+            std::swap(x[k], x[m_piv[k]]);
+        }
+        for (int i = 0; i < n; ++i) {
+            Real s = x[i];
+            for (int k = 0; k < i; ++k) { s -= m_lu[Long(i)*n+k]*x[k]; }
+            x[i] = s;
+        }
+        for (int i = n-1; i >= 0; --i) {
+            const Real d = m_lu[Long(i)*n+i];
+            if (d == Real(0.)) {
+                x[i] = 0;
+            } else {
+                Real s = x[i];
+                for (int j = i+1; j < n; ++j) { s -= m_lu[Long(i)*n+j]*x[j]; }
+                x[i] = s/d;
+            }
+        }
+    }
+    else
+    {
+        std::fill(L.x.begin(), L.x.end(), Real(0.));
+        for (int i = 0; i < 10; ++i) {
+            smooth(m_nlevels-1, true);
+            smooth(m_nlevels-1, false);
+        }
+    }
+}
+
+void
+MLAMGSolver::smooth (int lev, bool forward)
+{
+    Level& L = m_levels[lev];
+    const CSR& A = L.A;
+    const int n = A.nrows;
+
+    auto gs = [&] (int i)
+    {
+        if (L.diag[i] == Real(0.)) { return; }
+        Real s = L.b[i];
+        for (Long p = A.ptr[i]; p < A.ptr[i+1]; ++p) {
+            if (A.col[p] != i) { s -= A.val[p]*L.x[A.col[p]]; }
+        }
+        L.x[i] = s/L.diag[i];
+    };
+
+    for (int sweep = 0; sweep < num_sweeps; ++sweep) {
+        if (forward) {
+            for (int i = 0; i < n; ++i) { gs(i); }
+        } else {
+            for (int i = n-1; i >= 0; --i) { gs(i); }
+        }
+    }
+}
+
+void
+MLAMGSolver::vcycle (int lev)
+{
+    if (lev == m_nlevels-1) {
+        coarseSolve();
+        return;
+    }
+
+    Level& L = m_levels[lev];
+    Level& C = m_levels[lev+1];
+
+    std::fill(L.x.begin(), L.x.end(), Real(0.));
+    smooth(lev, true);
+
+    residual(L.A, L.x.data(), L.b.data(), L.r.data());
+    spmv(L.R, L.r.data(), C.b.data());
+
+    vcycle(lev+1);
+
+    for (int i = 0; i < L.A.nrows; ++i) {
+        Real s = 0;
+        for (Long p = L.P.ptr[i]; p < L.P.ptr[i+1]; ++p) {
+            s += L.P.val[p]*C.x[L.P.col[p]];
+        }
+        L.x[i] += s;
+    }
+
+    // Backward sweeps keep the V-cycle symmetric for CG.
+    smooth(lev, false);
+}
+
+int
+MLAMGSolver::solveOnRoot (Vector<Real>& x, Vector<Real> const& b, Real eps_rel, Real eps_abs)
+{
+    Level& L0 = m_levels[0];
+    const CSR& A = L0.A;
+    const int n = A.nrows;
+
+    x.assign(n, Real(0.));
+
+    Real rnorm = norm_inf(b);
+    const Real rnorm0 = rnorm;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLAMGSolver: Initial error (error0) =        " << rnorm0 << '\n';
+    }
+
+    int ret = 0;
+    iter = 0;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs ) { return ret; }
+
+    Vector<Real> r = b;
+
+    if (m_symmetric)
+    {
+        Vector<Real> p(n), q(n);
+        L0.b = r;
+        vcycle(0);
+        p = L0.x;
+        Real rho = dot(r, L0.x);
+
+        for (iter = 1; iter <= maxiter; ++iter)
+        {
+            spmv(A, p.data(), q.data());
+            const Real pq = dot(p, q);
+            if ( pq == Real(0.) )
+            {
+                ret = 1; break;
+            }
+            const Real alpha = rho/pq;
+            for (int i = 0; i < n; ++i) {
+                x[i] += alpha*p[i];
+                r[i] -= alpha*q[i];
+            }
+            rnorm = norm_inf(r);
+
+            if ( verbose > 2 )
+            {
+                amrex::Print() << "MLAMGSolver: Iteration "
+                               << std::setw(4) << iter
+                               << " rel. err. "
+                               << rnorm/(rnorm0) << '\n';
+            }
+
+            if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+
+            L0.b = r;
+            vcycle(0);
+            const Real rho_new = dot(r, L0.x);
+            if ( rho_new == Real(0.) )
+            {
+                ret = 1; break;
+            }
+            const Real beta = rho_new/rho;
+            for (int i = 0; i < n; ++i) {
+                p[i] = L0.x[i] + beta*p[i];
+            }
+            rho = rho_new;
+        }
+    }
+    else
+    {
+        for (iter = 1; iter <= maxiter; ++iter)
+        {
+            L0.b = r;
+            vcycle(0);
+            for (int i = 0; i < n; ++i) {
+                x[i] += L0.x[i];
+            }
+            residual(A, x.data(), b.data(), r.data());
+            rnorm = norm_inf(r);
+
+            if ( verbose > 2 )
+            {
+                amrex::Print() << "MLAMGSolver: Iteration "
+                               << std::setw(4) << iter
+                               << " rel. err. "
+                               << rnorm/(rnorm0) << '\n';
+            }
+
+            if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+        }
+    }
+
+    iter = std::min(iter, maxiter);
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLAMGSolver: Final: Iteration "
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 && rnorm > eps_rel*rnorm0 && rnorm > eps_abs )
+    {
+        if ( verbose > 0 )
+            amrex::Warning("MLAMGSolver: failed to converge!");
+        ret = 8;
+    }
+
+    return ret;
+}
+
+int
+MLAMGSolver::solve (MultiFab& x, const MultiFab& b, Real eps_rel, Real eps_abs)
+{
+    BL_PROFILE("MLAMGSolver::solve()");
+
+    const BoxArray& ba = x.boxArray();
+
+    MultiFab b_root(ba, m_dm_root, 1, 0, MFInfo().SetArena(The_Pinned_Arena()));
+    MultiFab x_root(ba, m_dm_root, 1, 0, MFInfo().SetArena(The_Pinned_Arena()));
+    b_root.ParallelCopy(b, 0, 0, 1);
+    Gpu::streamSynchronize();
+
+    int ret_iter[2] = {0, 0};
+    if (m_is_root)
+    {
+        Vector<Real> xv, bv(m_levels[0].A.nrows, Real(0.));
+        for (MFIter mfi(b_root); mfi.isValid(); ++mfi)
+        {
+            Array4<Real const> const& bfab = b_root.const_array(mfi);
+            Array4<int const> const& id = m_id.const_array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+            {
+                const int r = id(i,j,k);
+                if (r >= 0 && !m_inactive[r]) { bv[r] = bfab(i,j,k); }
+            });
+        }
+
+        ret_iter[0] = solveOnRoot(xv, bv, eps_rel, eps_abs);
+        ret_iter[1] = iter;
+
+        for (MFIter mfi(x_root); mfi.isValid(); ++mfi)
+        {
+            Array4<Real> const& xfab = x_root.array(mfi);
+            Array4<int const> const& id = m_id.const_array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [&] (int i, int j, int k) noexcept
+            {
+                const int r = id(i,j,k);
+                xfab(i,j,k) = (r >= 0) ? xv[r] : Real(0.);
+            });
+        }
+    }
+
+    ParallelDescriptor::Bcast(ret_iter, 2, 0, ParallelContext::CommunicatorSub());
+    iter = ret_iter[1];
+
+    x.ParallelCopy(x_root, 0, 0, 1);
+
+    return ret_iter[0];
+}
+
+}
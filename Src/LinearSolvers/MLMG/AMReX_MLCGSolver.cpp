@@ -49,6 +49,99 @@ sxay (MultiFab&       ss,
     sxay(ss,xx,a,yy,0,nghost);
 }
 
+#ifdef BL_USE_MPI
+//
+// The reduction operator of PipelinedReduce.  An element is the whole
+// buffer:  the number of sums, the sums and then the maxima.
+//
+void
+pipelined_sum_max (void* invec, void* inoutvec, int* len, MPI_Datatype* datatype)
+{
+    int nbytes;
+    MPI_Type_size(*datatype, &nbytes);
+    const int n = nbytes / static_cast<int>(sizeof(Real));
+    auto const* in = static_cast<Real const*>(invec);
+    auto* inout = static_cast<Real*>(inoutvec);
+    for (int l = 0; l < *len; ++l, in += n, inout += n) {
+        const int nsums = static_cast<int>(in[0]);
+        for (int i = 1; i <= nsums; ++i) {
+            inout[i] += in[i];
+        }
+        for (int i = nsums+1; i < n; ++i) {
+            inout[i] = std::max(inout[i], in[i]);
+        }
+    }
+}
+#endif
+
+//
+// Non-blocking reduction of the local sums and maxima of a pipelined
+// iteration, so that it can be overlapped with an application of the
+// operator.  Both are reduced by a single MPI_Iallreduce with a user
+// defined operator.  The results are copied back by wait().
+//
+class PipelinedReduce
+{
+public:
+    PipelinedReduce () = default;
+    PipelinedReduce (const PipelinedReduce&) = delete;
+    PipelinedReduce& operator= (const PipelinedReduce&) = delete;
+
+    ~PipelinedReduce ()
+    {
+#ifdef BL_USE_MPI
+        if (m_op != MPI_OP_NULL) {
+            MPI_Op_free(&m_op);
+        }
+#endif
+    }
+
+    void start (Real* sums, int nsums, Real* maxs, int nmaxs, MPI_Comm comm)
+    {
+#ifdef BL_USE_MPI
+        m_sums = sums;
+        m_nsums = nsums;
+        m_maxs = maxs;
+        m_buf.resize(1+nsums+nmaxs);
+        m_buf[0] = Real(nsums);
+        std::copy(sums, sums+nsums, m_buf.begin()+1);
+        std::copy(maxs, maxs+nmaxs, m_buf.begin()+1+nsums);
+        if (m_op == MPI_OP_NULL) {
+            MPI_Op_create(pipelined_sum_max, 1, &m_op);
+        }
+        // A single element, so that MPI does not split the buffer.
+        MPI_Type_contiguous(static_cast<int>(m_buf.size()),
+                            ParallelDescriptor::Mpi_typemap<Real>::type(), &m_type);
+        MPI_Type_commit(&m_type);
+        MPI_Iallreduce(MPI_IN_PLACE, m_buf.data(), 1, m_type, m_op, comm, &m_req);
+#else
+        amrex::ignore_unused(sums,nsums,maxs,nmaxs,comm);
+#endif
+    }
+
+    void wait ()
+    {
+#ifdef BL_USE_MPI
+        BL_PROFILE("MLCGSolver::ParallelAllReduce");
+        MPI_Wait(&m_req, MPI_STATUS_IGNORE);
+        MPI_Type_free(&m_type);
+        std::copy(m_buf.begin()+1, m_buf.begin()+1+m_nsums, m_sums);
+        std::copy(m_buf.begin()+1+m_nsums, m_buf.end(), m_maxs);
+#endif
+    }
+
+private:
+#ifdef BL_USE_MPI
+    Vector<Real> m_buf;
+    Real* m_sums = nullptr;
+    Real* m_maxs = nullptr;
+    int m_nsums = 0;
+    MPI_Op m_op = MPI_OP_NULL;
+    MPI_Datatype m_type = MPI_DATATYPE_NULL;
+    MPI_Request m_req = MPI_REQUEST_NULL;
+#endif
+};
+
 }
 
 MLCGSolver::MLCGSolver (MLMG* a_mlmg, MLLinOp& _lp, Type _typ)
@@ -73,6 +166,10 @@ MLCGSolver::solve (MultiFab&       sol,
 {
     if (solver_type == Type::BiCGStab) {
         return solve_bicgstab(sol,rhs,eps_rel,eps_abs);
+    } else if (solver_type == Type::PipelinedBiCGStab) {
+        return solve_pipelined_bicgstab(sol,rhs,eps_rel,eps_abs);
+    } else if (solver_type == Type::PipelinedCG) {
+        return solve_pipelined_cg(sol,rhs,eps_rel,eps_abs);
     } else {
         return solve_cg(sol,rhs,eps_rel,eps_abs);
     }
@@ -396,6 +493,470 @@ MLCGSolver::solve_cg (MultiFab&       sol,
     return ret;
 }
 
+int
+MLCGSolver::solve_pipelined_bicgstab (MultiFab&       sol,
+                                      const MultiFab& rhs,
+                                      Real            eps_rel,
+                                      Real            eps_abs)
+{
+    BL_PROFILE("MLCGSolver::pipelined_bicgstab");
+
+    const int ncomp = sol.nComp();
+
+    const BoxArray& ba = sol.boxArray();
+    const DistributionMapping& dm = sol.DistributionMap();
+    const auto& factory = sol.Factory();
+
+    // r, w and z are operands of Lp.apply, and so are p and s when the
+    // residual is replaced, so they need ghost cells.
+    MultiFab r(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab w(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab z(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab p(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab s(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    r.setVal(0.0);
+    w.setVal(0.0);
+    z.setVal(0.0);
+    p.setVal(0.0);
+    s.setVal(0.0);
+
+    MultiFab sorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab rh   (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab t    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab v    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab q    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab y    (ba, dm, ncomp, nghost, MFInfo(), factory);
+
+    Lp.correctionResidual(amrlev, mglev, r, sol, rhs, MLLinOp::BCMode::Homogeneous);
+    Lp.normalize(amrlev, mglev, r);
+
+    MultiFab::Copy(sorig,sol,0,0,ncomp,nghost);
+    MultiFab::Copy(rh,   r,  0,0,ncomp,nghost);
+
+    sol.setVal(0);
+
+    Real rnorm = norm_inf(r);
+    const Real rnorm0   = rnorm;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PBiCGStab: Initial error (error0) =        " << rnorm0 << '\n';
+    }
+    int ret = 0;
+    iter = 1;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs )
+    {
+        if ( verbose > 0 )
+        {
+            amrex::Print() << "MLCGSolver_PBiCGStab: niter = 0,"
+                           << ", rnorm = " << rnorm
+                           << ", eps_abs = " << eps_abs << std::endl;
+        }
+        return ret;
+    }
+
+    const MPI_Comm comm = Lp.BottomCommunicator();
+    PipelinedReduce reduce;
+
+    // w = A r and t = A w, with (rh,r) and (rh,w) reduced during the second apply.
+    Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+    Lp.normalize(amrlev, mglev, w);
+
+    // The recurrences for r, w, s, z and v accumulate rounding errors, so
+    // the updated r drifts away from the true residual and the solver
+    // stalls.  Every replace_interval iterations, and before accepting
+    // convergence, the vectors are recomputed from their definitions:
+    // r = rh - A sol, since rh is the initial residual, w = A r, s = A p,
+    // z = A s and v = A z.
+    constexpr int replace_interval = 50;
+    bool replaced = true;
+    auto true_residual = [&] ()
+    {
+        Lp.apply(amrlev, mglev, r, sol, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, r);
+        MultiFab::Xpay(r, Real(-1.0), rh, 0, 0, ncomp, nghost);
+    };
+    auto replace_residual = [&] ()
+    {
+        true_residual();
+        Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, w);
+        Lp.apply(amrlev, mglev, s, p, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, s);
+        Lp.apply(amrlev, mglev, z, s, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, z);
+        Lp.apply(amrlev, mglev, v, z, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, v);
+        replaced = true;
+    };
+
+    Real rho, alpha = 0, beta = 0, omega = 0;
+    {
+        Real sums[2] = { dotxy(rh,r,true), dotxy(rh,w,true) };
+        reduce.start(sums, 2, nullptr, 0, comm);
+        Lp.apply(amrlev, mglev, t, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, t);
+        reduce.wait();
+
+        rho = sums[0];
+        if ( sums[1] != Real(0.0) )
+        {
+            alpha = rho/sums[1];
+        }
+        else
+        {
+            ret = 2;
+        }
+    }
+
+    for (; ret == 0 && iter <= maxiter; ++iter)
+    {
+        if ( iter == 1 )
+        {
+            MultiFab::Copy(p,r,0,0,ncomp,nghost);
+            MultiFab::Copy(s,w,0,0,ncomp,nghost);
+            MultiFab::Copy(z,t,0,0,ncomp,nghost);
+        }
+        else
+        {
+            sxay(p, p, -omega, s, nghost);
+            sxay(p, r,   beta, p, nghost);
+            sxay(s, s, -omega, z, nghost);
+            sxay(s, w,   beta, s, nghost);
+            sxay(z, z, -omega, v, nghost);
+            sxay(z, t,   beta, z, nghost);
+        }
+        sxay(q, r, -alpha, s, nghost);
+        sxay(y, w, -alpha, z, nghost);
+
+        // v = A z, overlapped with the reduction of (q,y), (y,y) and |q|.
+        Real sums1[2] = { dotxy(q,y,true), dotxy(y,y,true) };
+        Real qnorm = norm_inf(q,true);
+        reduce.start(sums1, 2, &qnorm, 1, comm);
+        Lp.apply(amrlev, mglev, v, z, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.normalize(amrlev, mglev, v);
+        reduce.wait();
+
+        rnorm = qnorm;
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_PBiCGStab: Half Iter "
+                           << std::setw(11) << iter
+                           << " rel. err. "
+                           << rnorm/(rnorm0) << '\n';
+        }
+
+        sxay(sol, sol, alpha, p, nghost);
+
+        // q is the updated residual of the half step.  Stop only if the
+        // true residual has converged too, otherwise finish the iteration
+        // and replace the residual at its end.
+        bool replace_now = (iter % replace_interval == 0);
+        if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs )
+        {
+            true_residual();
+            rnorm = norm_inf(r);
+            if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+            replace_now = true;
+        }
+
+        if ( sums1[1] != Real(0.0) )
+        {
+            omega = sums1[0]/sums1[1];
+        }
+        else
+        {
+            ret = 3; break;
+        }
+
+        sxay(sol, sol, omega, q, nghost);
+        sxay(r, q, -omega, y, nghost);
+        // w = y - omega*(t - alpha*v).  t is recomputed from w below.
+        sxay(t, t, -alpha, v, nghost);
+        sxay(w, y, -omega, t, nghost);
+
+        replaced = false;
+        if ( replace_now ) {
+            replace_residual();
+        }
+
+        // t = A w, overlapped with the reduction of the inner products
+        // with rh and |r|.  If the updated residual has converged, the
+        // residual is replaced and the reduction redone before stopping.
+        Real sums2[4];
+        for (;;)
+        {
+            sums2[0] = dotxy(rh,r,true);
+            sums2[1] = dotxy(rh,w,true);
+            sums2[2] = dotxy(rh,s,true);
+            sums2[3] = dotxy(rh,z,true);
+            Real rnorm_local = norm_inf(r,true);
+            reduce.start(sums2, 4, &rnorm_local, 1, comm);
+            Lp.apply(amrlev, mglev, t, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+            Lp.normalize(amrlev, mglev, t);
+            reduce.wait();
+
+            rnorm = rnorm_local;
+            if ( (rnorm < eps_rel*rnorm0 || rnorm < eps_abs) && !replaced ) {
+                replace_residual();
+            } else {
+                break;
+            }
+        }
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_PBiCGStab: Iteration "
+                           << std::setw(11) << iter
+                           << " rel. err. "
+                           << rnorm/(rnorm0) << '\n';
+        }
+
+        if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+
+        if ( omega == 0 )
+        {
+            ret = 4; break;
+        }
+
+        const Real rho_new = sums2[0];
+        if ( rho_new == 0 )
+        {
+            ret = 1; break;
+        }
+        beta = (alpha/omega)*(rho_new/rho);
+        const Real denom = sums2[1] + beta*sums2[2] - beta*omega*sums2[3];
+        if ( denom != Real(0.0) )
+        {
+            alpha = rho_new/denom;
+        }
+        else
+        {
+            ret = 2; break;
+        }
+        rho = rho_new;
+    }
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PBiCGStab: Final: Iteration "
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 && rnorm > eps_rel*rnorm0 && rnorm > eps_abs)
+    {
+        if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
+            amrex::Warning("MLCGSolver_PBiCGStab:: failed to converge!");
+        ret = 8;
+    }
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+
+    return ret;
+}
+
+int
+MLCGSolver::solve_pipelined_cg (MultiFab&       sol,
+                                const MultiFab& rhs,
+                                Real            eps_rel,
+                                Real            eps_abs)
+{
+    BL_PROFILE("MLCGSolver::pipelined_cg");
+
+    const int ncomp = sol.nComp();
+
+    const BoxArray& ba = sol.boxArray();
+    const DistributionMapping& dm = sol.DistributionMap();
+    const auto& factory = sol.Factory();
+
+    // r, w, p and s are operands of Lp.apply, so they need ghost cells.
+    MultiFab r(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab w(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab p(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    MultiFab s(ba, dm, ncomp, sol.nGrowVect(), MFInfo(), factory);
+    r.setVal(0.0);
+    w.setVal(0.0);
+    p.setVal(0.0);
+    s.setVal(0.0);
+
+    MultiFab sorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab rorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab z    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab q    (ba, dm, ncomp, nghost, MFInfo(), factory);
+
+    MultiFab::Copy(sorig,sol,0,0,ncomp,nghost);
+
+    Lp.correctionResidual(amrlev, mglev, r, sol, rhs, MLLinOp::BCMode::Homogeneous);
+
+    MultiFab::Copy(rorig,r,0,0,ncomp,nghost);
+
+    sol.setVal(0);
+
+    Real       rnorm    = norm_inf(r);
+    const Real rnorm0   = rnorm;
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_PCG: Initial error (error0) :        " << rnorm0 << '\n';
+    }
+
+    Real gamma_1 = 0, alpha_1 = 0;
+    int  ret = 0;
+    iter = 0;
+
+    if ( rnorm0 == 0 || rnorm0 < eps_abs )
+    {
+        if ( verbose > 0 ) {
+            amrex::Print() << "MLCGSolver_PCG: niter = 0,"
+                           << ", rnorm = " << rnorm
+                           << ", eps_abs = " << eps_abs << std::endl;
+        }
+        return ret;
+    }
+
+    const MPI_Comm comm = Lp.BottomCommunicator();
+    PipelinedReduce reduce;
+
+    Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+    // The recurrences for r, w, s and z accumulate rounding errors, so the
+    // updated r drifts away from the true residual and the solver stalls.
+    // Every replace_interval iterations, and before accepting convergence,
+    // the vectors are recomputed from their definitions: r = rorig - A sol,
+    // w = A r, s = A p and z = A s.
+    constexpr int replace_interval = 50;
+    bool replaced = true;
+    auto replace_residual = [&] ()
+    {
+        Lp.apply(amrlev, mglev, r, sol, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        MultiFab::Xpay(r, Real(-1.0), rorig, 0, 0, ncomp, nghost);
+        Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.apply(amrlev, mglev, s, p, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        Lp.apply(amrlev, mglev, z, s, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        replaced = true;
+    };
+
+    // iter counts the completed iterations.  The norm of the residual
+    // is reduced with the inner products, so it is checked at the top of
+    // the next iteration.
+    for (;;)
+    {
+        // q = A w, overlapped with the reduction of (r,r), (w,r) and |r|.
+        Real sums[2] = { dotxy(r,r,true), dotxy(w,r,true) };
+        Real rnorm_local = norm_inf(r,true);
+        reduce.start(sums, 2, &rnorm_local, 1, comm);
+        Lp.apply(amrlev, mglev, q, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+        reduce.wait();
+
+        rnorm = rnorm_local;
+
+        if ( verbose > 2 && iter > 0 )
+        {
+            amrex::Print() << "MLCGSolver_pcg:       Iteration"
+                           << std::setw(4) << iter
+                           << " rel. err. "
+                           << rnorm/(rnorm0) << '\n';
+        }
+
+        const bool converged = rnorm < eps_rel*rnorm0 || rnorm < eps_abs;
+        if ( converged && !replaced )
+        {
+            // Check the true residual before stopping.
+            replace_residual();
+            continue;
+        }
+
+        if ( converged || iter == maxiter ) break;
+
+        ++iter;
+
+        const Real gamma = sums[0];
+        const Real delta = sums[1];
+        Real beta = 0, denom = delta;
+        if ( iter > 1 )
+        {
+            beta = gamma/gamma_1;
+            denom -= beta*gamma/alpha_1;
+        }
+        if ( denom == Real(0.0) )
+        {
+            ret = 1; break;
+        }
+        const Real alpha = gamma/denom;
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_pcg:"
+                           << " iter " << iter
+                           << " gamma " << gamma
+                           << " alpha " << alpha << '\n';
+        }
+
+        if ( iter == 1 )
+        {
+            MultiFab::Copy(z,q,0,0,ncomp,nghost);
+            MultiFab::Copy(s,w,0,0,ncomp,nghost);
+            MultiFab::Copy(p,r,0,0,ncomp,nghost);
+        }
+        else
+        {
+            sxay(z, q, beta, z, nghost);
+            sxay(s, w, beta, s, nghost);
+            sxay(p, r, beta, p, nghost);
+        }
+        sxay(sol, sol, alpha, p, nghost);
+        sxay(  r,   r,-alpha, s, nghost);
+        sxay(  w,   w,-alpha, z, nghost);
+
+        gamma_1 = gamma;
+        alpha_1 = alpha;
+
+        replaced = false;
+        if ( iter % replace_interval == 0 ) {
+            replace_residual();
+        }
+    }
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_pcg: Final Iteration"
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 &&  rnorm > eps_rel*rnorm0 && rnorm > eps_abs )
+    {
+        if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
+            amrex::Warning("MLCGSolver_pcg: failed to converge!");
+        ret = 8;
+    }
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+
+    return ret;
+}
+
 Real
 MLCGSolver::dotxy (const MultiFab& r, const MultiFab& z, bool local)
 {
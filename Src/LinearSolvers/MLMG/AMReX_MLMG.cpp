@@ -62,7 +62,8 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
         bottom_solver = linop.getDefaultBottomSolver();
     }
 
-    if (bottom_solver == BottomSolver::hypre || bottom_solver == BottomSolver::petsc) {
+    if (bottom_solver == BottomSolver::hypre || bottom_solver == BottomSolver::petsc ||
+        bottom_solver == BottomSolver::amg) {
         int mo = linop.getMaxOrder();
         if (a_sol[0]->hasEBFabFactory()) {
             linop.setMaxOrder(2);
@@ -71,6 +72,8 @@ MLMG::solve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab const*>& a_rh
         }
     }
 
+    linop.setMixedPrecision(mixed_precision);
+
     bool is_nsolve = linop.m_parent;
 
     auto solve_start_time = amrex::second();
@@ -233,6 +236,8 @@ void MLMG::oneIter (int iter)
     int nghost = 0;
     if (cf_strategy == CFStrategy::ghostnodes) nghost = linop.getNGrow();
 
+    if (mixed_precision) linop.setCorrectionCycle(true);
+
     for (int alev = finest_amr_lev; alev > 0; --alev)
     {
         if (cf_strategy == CFStrategy::ghostnodes) nghost = linop.getNGrow(alev);
@@ -291,6 +296,8 @@ void MLMG::oneIter (int iter)
     }
 
     averageDownAndSync();
+
+    if (mixed_precision) linop.setCorrectionCycle(false);
 }
 
 // Compute multi-level Residual (res) up to amrlevmax.
@@ -351,7 +358,10 @@ MLMG::computeResWithCrseSolFineCor (int calev, int falev)
     if (calev > 0) {
         crse_bcdata = sol[calev-1];
     }
+    // The residual of the solution is computed with the exact operator
+    if (mixed_precision) linop.setCorrectionCycle(false);
     linop.solutionResidual(calev, crse_res, crse_sol, crse_rhs, crse_bcdata);
+    if (mixed_precision) linop.setCorrectionCycle(true);
 
     linop.correctionResidual(falev, 0, fine_rescor, fine_cor, fine_res, BCMode::Homogeneous);
     MultiFab::Copy(fine_res, fine_rescor, 0, 0, ncomp, nghost);
@@ -961,12 +971,28 @@ MLMG::actualBottomSolve ()
         {
             bottomSolveWithPETSc(x, *bottom_b);
         }
+        else if (bottom_solver == BottomSolver::amg)
+        {
+            int ret = bottomSolveWithAMG(x, *bottom_b);
+            // If the AMG solve failed then set the correction to zero
+            if (ret != 0) {
+                cor[amrlev][mglev]->setVal(0.0);
+            }
+            const int n = (ret==0) ? nub : nuf;
+            for (int i = 0; i < n; ++i) {
+                linop.smooth(amrlev, mglev, x, b);
+            }
+        }
         else
         {
             MLCGSolver::Type cg_type;
             if (bottom_solver == BottomSolver::cg ||
                 bottom_solver == BottomSolver::cgbicg) {
                 cg_type = MLCGSolver::Type::CG;
+            } else if (bottom_solver == BottomSolver::pcg) {
+                cg_type = MLCGSolver::Type::PipelinedCG;
+            } else if (bottom_solver == BottomSolver::pbicgstab) {
+                cg_type = MLCGSolver::Type::PipelinedBiCGStab;
             } else {
                 cg_type = MLCGSolver::Type::BiCGStab;
             }
@@ -1022,6 +1048,49 @@ MLMG::bottomSolveWithCG (MultiFab& x, const MultiFab& b, MLCGSolver::Type type)
     return ret;
 }
 
+int
+MLMG::bottomSolveWithAMG (MultiFab& x, const MultiFab& b)
+{
+    const int amrlev = 0;
+    const int mglev  = linop.NMGLevels(amrlev) - 1;
+
+    const int ncomp = linop.getNComp();
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(ncomp == 1, "bottomSolveWithAMG doesn't work with ncomp > 1");
+
+    if (amg_solver == nullptr)  // We should reuse the setup
+    {
+        amg_solver = std::make_unique<MLAMGSolver>(linop);
+        amg_solver->setVerbose(bottom_verbose);
+        amg_solver->setStrongThreshold(amg_strong_threshold);
+        amg_solver->setNumSweeps(amg_num_sweeps);
+        amg_solver->setMaxCoarseSize(amg_max_coarse_size);
+        if (!amg_solver->setup(x)) {
+            if (verbose > 0) {
+                amrex::Print() << "MLMG: The bottom operator cannot be assembled for amg."
+                               << " Switching to bicgstab.\n";
+            }
+            amg_solver.reset();
+            bottom_solver = BottomSolver::bicgstab;
+            return bottomSolveWithCG(x, b, MLCGSolver::Type::BiCGStab);
+        }
+    }
+
+    amg_solver->setMaxIter(bottom_maxiter);
+    int ret = amg_solver->solve(x, b, bottom_reltol, bottom_abstol);
+    if (ret != 0 && verbose > 1) {
+        amrex::Print() << "MLMG: Bottom solve failed.\n";
+    }
+    m_niters_cg.push_back(amg_solver->getNumIters());
+
+    // For singular problems, enforce that the average of the correction is 0
+    if (linop.isSingular(amrlev) && linop.getEnforceSingularSolvable())
+    {
+        makeSolvable(amrlev, mglev, x);
+    }
+
+    return ret;
+}
+
 // Compute single-level masked inf-norm of Residual (res).
 Real
 MLMG::ResNormInf (int alev, bool local)
@@ -1158,6 +1227,8 @@ MLMG::prepareForSolve (const Vector<MultiFab*>& a_sol, const Vector<MultiFab con
     } else if (linop.needsUpdate()) {
         linop.update();
 
+        amg_solver.reset();
+
 #if defined(AMREX_USE_HYPRE) && (AMREX_SPACEDIM > 1)
         hypre_solver.reset();
         hypre_bndry.reset();
@@ -0,0 +1,118 @@
+//
+// Check that a run restarted from a checkpoint ends bitwise identical to
+// the run that wrote the checkpoint.  The run does max_step steps with a
+// checkpoint after every step.  Then a new Amr restarts in the same process
+// from the checkpoint of step restart_step and also runs to max_step.
+// This is meant for the options that change how checkpoints are written
+// and how the state is kept, e.g.,
+//
+//     amr.spill_old_data = 1       (old time data in the spill arena)
+//     amrex.async_out = 1          (asynchronous checkpoints)
+//     amr.checkpoint_delta = 1     (delta checkpoints)
+//
+// Runtime parameters:
+//     max_step     : number of coarse steps of both runs
+//     restart_step : step of the checkpoint to restart from
+//     stop_time    : time to stop at
+//     amr.check_file : root name of the checkpoints (default chk)
+//
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
+
+using namespace amrex;
+
+amrex::LevelBld* getLevelBld ();
+
+namespace {
+
+void run (Amr& amr, int max_step, Real stop_time)
+{
+    while ( amr.okToContinue() &&
+             amr.levelSteps(0) < max_step &&
+           (amr.cumTime() < stop_time || stop_time < 0.0) )
+    {
+        amr.coarseTimeStep(stop_time);
+    }
+}
+
+}
+
+int
+main (int   argc,
+      char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int  max_step = 4;
+        int  restart_step = 2;
+        Real stop_time = -1.0;
+        std::string check_file = "chk";
+        {
+            ParmParse pp;
+            pp.query("max_step",max_step);
+            pp.query("restart_step",restart_step);
+            pp.query("stop_time",stop_time);
+            ParmParse ppa("amr");
+            ppa.query("check_file",check_file);
+        }
+        AMREX_ALWAYS_ASSERT(0 < restart_step && restart_step < max_step);
+
+        Vector<MultiFab> expected;
+        {
+            Amr amr(getLevelBld());
+            amr.init(0.0,stop_time);
+            run(amr, max_step, stop_time);
+            for (int lev = 0; lev <= amr.finestLevel(); ++lev) {
+                MultiFab const& s = amr.getLevel(lev).get_new_data(0);
+                expected.emplace_back(s.boxArray(), s.DistributionMap(), s.nComp(), 0);
+                MultiFab::Copy(expected.back(), s, 0, 0, s.nComp(), 0);
+            }
+        }
+
+        // Every checkpoint is complete, with nothing left in a temporary directory.
+        for (int step = 1; step <= max_step; ++step) {
+            const std::string chk = amrex::Concatenate(check_file, step);
+            if (!amrex::FileExists(chk + "/Header") || amrex::FileExists(chk + ".temp")) {
+                amrex::Abort("Restart: checkpoint " + chk + " is incomplete");
+            }
+        }
+
+        {
+            ParmParse pp("amr");
+            pp.add("restart", amrex::Concatenate(check_file, restart_step));
+        }
+        {
+            Amr amr(getLevelBld());
+            amr.init(0.0,stop_time);
+            if (amr.levelSteps(0) != restart_step) {
+                amrex::Abort("Restart: did not restart from step " + std::to_string(restart_step));
+            }
+            run(amr, max_step, stop_time);
+
+            if (amr.finestLevel()+1 != static_cast<int>(expected.size())) {
+                amrex::Abort("Restart: the restarted run has a different number of levels");
+            }
+            for (int lev = 0; lev <= amr.finestLevel(); ++lev) {
+                MultiFab const& s = amr.getLevel(lev).get_new_data(0);
+                if (s.boxArray() != expected[lev].boxArray()) {
+                    amrex::Abort("Restart: the restarted run has different grids");
+                }
+                MultiFab diff(s.boxArray(), s.DistributionMap(), s.nComp(), 0);
+                diff.ParallelCopy(expected[lev]);
+                MultiFab::Subtract(diff, s, 0, 0, s.nComp(), 0);
+                const Real err = diff.norm0(0, s.nComp(), IntVect(0));
+                amrex::Print() << "Level " << lev << ": max difference from the run without restart = "
+                               << err << "\n";
+                if (err != 0.0) {
+                    amrex::Abort("Restart: the restarted run differs from the run without restart");
+                }
+            }
+        }
+    }
+    amrex::Finalize();
+
+    return 0;
+}
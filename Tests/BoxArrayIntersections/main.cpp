@@ -0,0 +1,219 @@
+//
+// Compare the hash and the BVH spatial indices used by BoxArray::intersections,
+// after checking the results of both against a brute force search, also with
+// ghost cells, for complementIn and for a coarsened and converted BoxArray.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 1024)
+//     max_grid_size : max_grid_size used to chop the domain (default 32)
+//     keep_fraction : fraction of the chopped boxes kept, to mimic an AMR level (default 0.5)
+//     nbuild        : number of times each index is rebuilt (default 10)
+//     nquery        : number of point and box queries (default 1000000)
+//     query_size    : size of the query boxes (default 48)
+//
+#include <AMReX.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Random.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+
+using namespace amrex;
+
+namespace {
+
+BoxArray make_boxarray (int n_cell, int max_grid_size, Real keep_fraction)
+{
+    Box domain(IntVect(0), IntVect(n_cell-1));
+    BoxArray chopped(domain);
+    chopped.maxSize(max_grid_size);
+
+    BoxList bl;
+    for (int i = 0, N = chopped.size(); i < N; ++i) {
+        if (amrex::Random() < keep_fraction) {
+            bl.push_back(chopped[i]);
+        }
+    }
+    return BoxArray(std::move(bl));
+}
+
+Vector<Box> make_queries (int nquery, int n_cell, int query_size)
+{
+    Vector<Box> queries(nquery);
+    for (auto& q : queries) {
+        IntVect lo(AMREX_D_DECL(static_cast<int>(amrex::Random_int(n_cell)),
+                                static_cast<int>(amrex::Random_int(n_cell)),
+                                static_cast<int>(amrex::Random_int(n_cell))));
+        q = Box(lo, lo + (query_size-1));
+    }
+    return queries;
+}
+
+// Returns the time per build.
+double time_build (const BoxArray& ba, int nbuild)
+{
+    std::vector< std::pair<int,Box> > isects;
+    double t = amrex::second();
+    for (int i = 0; i < nbuild; ++i) {
+        ba.clear_hash_bin();
+        ba.intersections(ba[0], isects);
+    }
+    return (amrex::second() - t) / nbuild;
+}
+
+// Returns the time per query.  The number of intersections found is returned in nfound.
+double time_query (const BoxArray& ba, const Vector<Box>& queries, Long& nfound)
+{
+    std::vector< std::pair<int,Box> > isects;
+    nfound = 0;
+    double t = amrex::second();
+    for (const auto& q : queries) {
+        ba.intersections(q, isects);
+        nfound += isects.size();
+    }
+    return (amrex::second() - t) / queries.size();
+}
+
+// Brute force intersections of a query with every box grown by ng.
+void brute_force (const BoxArray& ba, const Box& q, std::vector< std::pair<int,Box> >& isects,
+                  int ng = 0)
+{
+    isects.clear();
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        Box isect = amrex::grow(ba[i],ng) & q;
+        if (isect.ok()) {
+            isects.emplace_back(i, isect);
+        }
+    }
+}
+
+// Brute force complement of the BoxArray in a query.
+BoxList brute_force_complement (const BoxArray& ba, const Box& q)
+{
+    BoxList bl(q);
+    std::vector< std::pair<int,Box> > isects;
+    brute_force(ba, q, isects);
+    for (auto const& is : isects) {
+        BoxList diff(q.ixType());
+        for (const Box& b : bl) {
+            diff.join(amrex::boxDiff(b, is.second));
+        }
+        bl = std::move(diff);
+    }
+    return bl;
+}
+
+Long num_pts (const BoxList& bl)
+{
+    Long n = 0;
+    for (const Box& b : bl) { n += b.numPts(); }
+    return n;
+}
+
+// Aborts unless both indices find exactly the brute force intersections
+// with the boxes grown by ng, and the brute force complement.
+void check (const BoxArray& ba, const Vector<Box>& queries, int ng, const std::string& name)
+{
+    std::vector< std::pair<int,Box> > expected, a;
+    auto cmp = [] (std::pair<int,Box> const& x, std::pair<int,Box> const& y) -> bool
+               { return x.first < y.first; };
+    BoxArray::IntersectIndex indices[] = {BoxArray::HASH, BoxArray::BVH};
+    const char* names[] = {"hash", "BVH"};
+    for (int m = 0; m < 2; ++m) {
+        const std::string msg = std::string("BoxArrayIntersections: ") + names[m]
+            + " and brute force results differ for " + name + " with ng = "
+            + std::to_string(ng) + ": ";
+        BoxArray::intersectIndex(indices[m]);
+        ba.clear_hash_bin();
+        for (const auto& q : queries) {
+            const Box qt = amrex::convert(q, ba.ixType());
+            brute_force(ba, qt, expected, ng);
+            ba.intersections(qt, a, false, ng);
+            std::sort(a.begin(), a.end(), cmp);
+            if (a != expected) {
+                amrex::Abort(msg + "intersections at " + std::to_string(q.smallEnd(0)));
+            }
+            if (ba.intersects(qt, ng) != !expected.empty()) {
+                amrex::Abort(msg + "intersects()");
+            }
+            if (ng == 0) {
+                BoxList c = ba.complementIn(qt);
+                if (num_pts(c) != num_pts(brute_force_complement(ba, qt))) {
+                    amrex::Abort(msg + "complementIn() size");
+                }
+                for (const Box& b : c) {
+                    if (ba.intersects(b) || !qt.contains(b)) {
+                        amrex::Abort(msg + "complementIn() box");
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 1024;
+        int max_grid_size = 32;
+        Real keep_fraction = 0.5;
+        int nbuild = 10;
+        int nquery = 1000000;
+        int query_size = 48;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("keep_fraction", keep_fraction);
+            pp.query("nbuild", nbuild);
+            pp.query("nquery", nquery);
+            pp.query("query_size", query_size);
+        }
+
+        BoxArray ba = make_boxarray(n_cell, max_grid_size, keep_fraction);
+        amrex::Print() << "BoxArray with " << ba.size() << " boxes\n";
+
+        Vector<Box> points = make_queries(nquery, n_cell, 1);
+        Vector<Box> boxes  = make_queries(nquery, n_cell, query_size);
+
+        const int ncheck = std::min(nquery,10000);
+        const Vector<Box> check_points(points.begin(), points.begin()+ncheck);
+        const Vector<Box> check_boxes(boxes.begin(), boxes.begin()+ncheck);
+        for (int ng : {0, 2}) {
+            check(ba, check_points, ng, "points");
+            check(ba, check_boxes, ng, "boxes");
+        }
+
+        // The indices of a coarsened and converted BoxArray are built from
+        // the boxes of the original one.
+        {
+            BoxArray cba = amrex::convert(amrex::coarsen(ba,2), IntVect(1));
+            Vector<Box> cqueries(check_boxes);
+            for (auto& q : cqueries) { q.coarsen(2); }
+            for (int ng : {0, 1}) {
+                check(cba, cqueries, ng, "coarsened nodal boxes");
+            }
+        }
+
+        BoxArray::IntersectIndex indices[] = {BoxArray::HASH, BoxArray::BVH};
+        const char* names[] = {"hash", "bvh "};
+        for (int m = 0; m < 2; ++m)
+        {
+            BoxArray::intersectIndex(indices[m]);
+            Long npoint, nbox;
+            double tb = time_build(ba, nbuild);
+            double tp = time_query(ba, points, npoint);
+            double tq = time_query(ba, boxes, nbox);
+            amrex::Print() << names[m] << ": build " << tb*1.e3 << " ms"
+                           << ", point query " << tp*1.e9 << " ns"
+                           << ", box query " << tq*1.e9 << " ns"
+                           << " (" << npoint << " and " << nbox << " intersections)\n";
+        }
+    }
+    amrex::Finalize();
+}
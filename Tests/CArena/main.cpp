@@ -0,0 +1,267 @@
+//
+// Check the per-thread caches of CArena:  blocks handed out concurrently
+// never overlap, and blocks freed by another thread go back to the cache
+// of the thread that allocated them.  With amrex.the_arena_thread_cache=1,
+// also check that The_Arena and The_Cpu_Arena use the thread caches.
+//
+// Check the segregated fit free lists of CArena:  freed blocks are
+// coalesced with their free neighbors and reused, also together with the
+// thread caches.  With amrex.the_arena_segregated_fit=1, also check that
+// The_Arena uses them.
+//
+// Runtime parameters:
+//     nthreads : number of threads (default 4)
+//     nrounds  : number of alloc/free rounds of each thread (default 20000)
+//     amrex.the_arena_thread_cache : see above (default 0)
+//     amrex.the_arena_segregated_fit : see above (default 0)
+//
+#include <AMReX.H>
+#include <AMReX_CArena.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace amrex;
+
+namespace {
+
+// Fill a block with a pattern that tells which thread and block it belongs to.
+void fill (void* p, std::size_t nbytes, unsigned char tag)
+{
+    std::memset(p, tag, nbytes);
+}
+
+bool check (void const* p, std::size_t nbytes, unsigned char tag)
+{
+    auto const* c = static_cast<unsigned char const*>(p);
+    for (std::size_t i = 0; i < nbytes; ++i) {
+        if (c[i] != tag) { return false; }
+    }
+    return true;
+}
+
+// Each thread keeps up to 64 live blocks of random sizes, up to twice the
+// largest size served by the caches, and checks that no other thread
+// wrote to them before freeing them.
+void alloc_free (CArena& arena, int ithread, int nrounds, std::atomic<int>& nerrors)
+{
+    std::mt19937 gen(ithread+1);
+    std::uniform_int_distribution<std::size_t> small(1, 4096);
+    std::uniform_int_distribution<std::size_t> large(1, 2*CArena::ThreadCacheMaxSize);
+    std::vector<std::pair<void*,std::size_t> > live;
+    for (int iround = 0; iround < nrounds; ++iround) {
+        if (live.size() < 64 && (live.empty() || gen() % 2 == 0)) {
+            const std::size_t nbytes = (gen() % 64 == 0) ? large(gen) : small(gen);
+            void* p = arena.alloc(nbytes);
+            fill(p, nbytes, static_cast<unsigned char>(ithread*64 + live.size()));
+            live.emplace_back(p, nbytes);
+        } else {
+            const std::size_t i = gen() % live.size();
+            if (!check(live[i].first, live[i].second, static_cast<unsigned char>(ithread*64 + i))) {
+                ++nerrors;
+            }
+            arena.free(live[i].first);
+            // Keep the tags of the other blocks valid.
+            live[i] = live.back();
+            live.pop_back();
+            if (i < live.size()) {
+                fill(live[i].first, live[i].second, static_cast<unsigned char>(ithread*64 + i));
+            }
+        }
+    }
+    for (auto const& b : live) {
+        arena.free(b.first);
+    }
+}
+
+
+// Aborts unless arena is a CArena whose thread cache serves a small request.
+void check_thread_cache (Arena* arena, std::string const& name)
+{
+    auto* carena = dynamic_cast<CArena*>(arena);
+    if (carena == nullptr) {
+        amrex::Abort("CArena thread cache: " + name + " is not a CArena");
+    }
+    Long nhits0, nmisses0, nremote0;
+    carena->ThreadCacheStats(nhits0, nmisses0, nremote0);
+    void* p = carena->alloc(256);
+    carena->free(p);
+    Long nhits1, nmisses1, nremote1;
+    carena->ThreadCacheStats(nhits1, nmisses1, nremote1);
+    if (nhits1 + nmisses1 == nhits0 + nmisses0) {
+        amrex::Abort("CArena thread cache: " + name + " does not use the thread cache");
+    }
+}
+
+// Blocks of many sizes, freed in an interleaved order, must be coalesced
+// back into a single free block, and freed space must be reused.
+void check_segregated_fit (CArena& arena, std::string const& name)
+{
+    const std::size_t hunk = CArena::DefaultHunkSize;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> size(1, 20000);
+    std::vector<void*> blocks;
+    std::size_t total = 0;
+    while (true) {
+        const std::size_t nbytes = size(gen);
+        if (total + 2*nbytes > hunk/2) { break; }
+        blocks.push_back(arena.alloc(nbytes));
+        total += nbytes;
+    }
+    const std::size_t used = arena.heap_space_used();
+
+    // Free every other block.  None of them can be merged.
+    for (std::size_t i = 0; i < blocks.size(); i += 2) {
+        arena.free(blocks[i]);
+    }
+    Long nblocks;
+    std::size_t largest;
+    arena.FreeBlockStats(nblocks, largest);
+    if (nblocks < Long(blocks.size()/2)) {
+        amrex::Abort("CArena segregated fit: " + name + " merged blocks that are not neighbors");
+    }
+
+    // Allocate them again in a different order.  They fit in the free space.
+    for (std::size_t i = 0; i < blocks.size(); i += 2) {
+        blocks[i] = arena.alloc(size(gen) / 2 + 1);
+    }
+    if (arena.heap_space_used() != used) {
+        amrex::Abort("CArena segregated fit: " + name + " did not reuse the free blocks");
+    }
+
+    // Free everything, from the back.  It all coalesces into one block.
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        arena.free(*it);
+    }
+    arena.FreeBlockStats(nblocks, largest);
+    if (nblocks != 1 || largest != arena.heap_space_used()) {
+        amrex::Abort("CArena segregated fit: " + name + " did not coalesce the free blocks");
+    }
+    if (arena.heap_space_actually_used() != 0) {
+        amrex::Abort("CArena segregated fit: " + name + " has memory in use after all blocks were freed");
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int nthreads = 4;
+        int nrounds = 20000;
+        {
+            ParmParse pp;
+            pp.query("nthreads", nthreads);
+            pp.query("nrounds", nrounds);
+        }
+
+        bool the_arena_thread_cache = false;
+        bool the_arena_segregated_fit = false;
+        {
+            ParmParse pp("amrex");
+            pp.query("the_arena_thread_cache", the_arena_thread_cache);
+            pp.query("the_arena_segregated_fit", the_arena_segregated_fit);
+        }
+        if (the_arena_thread_cache) {
+#ifndef AMREX_USE_GPU
+            check_thread_cache(The_Arena(), "The_Arena");
+#endif
+            check_thread_cache(The_Cpu_Arena(), "The_Cpu_Arena");
+        }
+
+#ifndef AMREX_USE_GPU
+        if (the_arena_segregated_fit) {
+            if (dynamic_cast<CArena*>(The_Arena()) == nullptr) {
+                amrex::Abort("CArena segregated fit: The_Arena is not a CArena");
+            }
+        }
+#endif
+
+        {
+            CArena sf_arena(0, ArenaInfo{}.SetCpuMemory().SetSegregatedFit());
+            check_segregated_fit(sf_arena, "a new arena");
+            // Again, now that the arena has free blocks.
+            check_segregated_fit(sf_arena, "a used arena");
+        }
+
+        // Concurrent allocations and frees with both the thread caches and
+        // segregated fit
+        {
+            CArena tc_sf_arena(0, ArenaInfo{}.SetCpuMemory().SetThreadCache().SetSegregatedFit());
+            std::atomic<int> nerrors{0};
+            std::vector<std::thread> threads;
+            for (int ithread = 0; ithread < nthreads; ++ithread) {
+                threads.emplace_back(alloc_free, std::ref(tc_sf_arena), ithread, nrounds, std::ref(nerrors));
+            }
+            for (auto& t : threads) { t.join(); }
+            if (nerrors > 0) {
+                amrex::Abort("CArena segregated fit: a block was overwritten while in use");
+            }
+            if (tc_sf_arena.heap_space_actually_used() != 0) {
+                amrex::Abort("CArena segregated fit: memory in use after all blocks were freed");
+            }
+        }
+
+        CArena arena(0, ArenaInfo{}.SetCpuMemory().SetThreadCache());
+
+        // Concurrent allocations and frees
+        std::atomic<int> nerrors{0};
+        {
+            std::vector<std::thread> threads;
+            for (int ithread = 0; ithread < nthreads; ++ithread) {
+                threads.emplace_back(alloc_free, std::ref(arena), ithread, nrounds, std::ref(nerrors));
+            }
+            for (auto& t : threads) { t.join(); }
+        }
+        if (nerrors > 0) {
+            amrex::Abort("CArena thread cache: a block was overwritten while in use");
+        }
+        if (arena.heap_space_actually_used() != 0) {
+            amrex::Abort("CArena thread cache: memory in use after all blocks were freed");
+        }
+
+        // Blocks allocated by this thread and freed by another one
+        const int nremote_blocks = 100;
+        std::vector<void*> blocks;
+        for (int i = 0; i < nremote_blocks; ++i) {
+            blocks.push_back(arena.alloc(256));
+        }
+        Long nhits0, nmisses0, nremote0;
+        arena.ThreadCacheStats(nhits0, nmisses0, nremote0);
+        std::thread([&] () {
+            for (void* p : blocks) { arena.free(p); }
+        }).join();
+        Long nhits1, nmisses1, nremote1;
+        arena.ThreadCacheStats(nhits1, nmisses1, nremote1);
+        if (nremote1 - nremote0 != nremote_blocks) {
+            amrex::Abort("CArena thread cache: remote frees were not counted");
+        }
+
+        // The owner picks them up again without refilling its cache.
+        std::vector<void*> blocks2;
+        for (int i = 0; i < nremote_blocks; ++i) {
+            blocks2.push_back(arena.alloc(256));
+        }
+        Long nhits2, nmisses2, nremote2;
+        arena.ThreadCacheStats(nhits2, nmisses2, nremote2);
+        for (void* p : blocks2) { arena.free(p); }
+        if (nmisses2 != nmisses1 || nhits2 - nhits1 != nremote_blocks) {
+            amrex::Abort("CArena thread cache: remotely freed blocks were not reused by their owner");
+        }
+        if (arena.heap_space_actually_used() != 0) {
+            amrex::Abort("CArena thread cache: memory in use after all blocks were freed");
+        }
+
+        amrex::Print() << "CArena thread cache: " << nhits2 << " hits, " << nmisses2
+                       << " misses, " << nremote2 << " remote frees\n";
+    }
+    amrex::Finalize();
+}
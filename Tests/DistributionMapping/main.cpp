@@ -0,0 +1,180 @@
+//
+// Check the SFC distribution with the Morton and Hilbert curves, the GRAPH
+// strategy and the incremental rebalancing of
+// DistributionMapping::makeIncremental:
+//   - the mappings are deterministic and the same on all processes,
+//   - a GRAPH mapping is valid and is the same when it is built again by
+//     one process only,
+//   - makeIncremental returns the original mapping if the costs are balanced,
+//   - it never makes the most loaded process worse, and
+//   - the number of boxes it moves is bounded.  Each move of a box of cost c
+//     from a process of load La to one of load Lb reduces the sum of the
+//     squared loads by 2c(La-Lb-c), which is at least 2*gain^2, where gain is
+//     larger than threshold times the max load.  So the number of moves is
+//     less than sum_p (L_p - mean)^2 / (2 (threshold*mean)^2).
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 64)
+//     max_grid_size : max_grid_size used to chop the domain (default 8)
+//     threshold     : threshold of makeIncremental (default 0.01)
+//     perturbation  : relative change of the costs between two calls (default 0.1)
+//
+#include <AMReX.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_DistributionMapping.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace amrex;
+
+namespace {
+
+// Aborts unless dm is the same on all processes.
+void check_same_on_all (const DistributionMapping& dm, const std::string& name)
+{
+    Vector<int> pmap = dm.ProcessorMap();
+    ParallelDescriptor::Bcast(pmap.data(), pmap.size(), ParallelDescriptor::IOProcessorNumber());
+    int same = (pmap == dm.ProcessorMap());
+    ParallelDescriptor::ReduceIntMin(same);
+    if (!same) {
+        amrex::Abort("DistributionMapping: " + name + " differs between processes");
+    }
+}
+
+Vector<Real> loads (const DistributionMapping& dm, const Vector<Real>& cost)
+{
+    Vector<Real> load(ParallelDescriptor::NProcs(), 0.0_rt);
+    for (int i = 0, N = cost.size(); i < N; ++i) {
+        load[dm[i]] += cost[i];
+    }
+    return load;
+}
+
+void check_incremental (const DistributionMapping& dm, const Vector<Real>& cost,
+                        Real threshold, const std::string& name)
+{
+    Real eff_cur, eff_new;
+    DistributionMapping r = DistributionMapping::makeIncremental(dm, cost, eff_cur, eff_new, threshold);
+    DistributionMapping r2 = DistributionMapping::makeIncremental(dm, cost, eff_cur, eff_new, threshold);
+    if (r.ProcessorMap() != r2.ProcessorMap()) {
+        amrex::Abort("DistributionMapping: makeIncremental is not deterministic for " + name);
+    }
+    check_same_on_all(r, "makeIncremental for " + name);
+
+    Vector<Real> load = loads(dm, cost);
+    Vector<Real> new_load = loads(r, cost);
+    const Real lmax = *std::max_element(load.begin(), load.end());
+    const Real new_lmax = *std::max_element(new_load.begin(), new_load.end());
+    Real mean = 0.0_rt;
+    for (Real l : load) { mean += l; }
+    mean /= load.size();
+    Real var = 0.0_rt;
+    for (Real l : load) { var += (l-mean)*(l-mean); }
+    const Real max_moves = var / (2.0_rt*(threshold*mean)*(threshold*mean));
+
+    int nmoved = 0;
+    for (int i = 0, N = cost.size(); i < N; ++i) {
+        if (r[i] != dm[i]) { ++nmoved; }
+    }
+
+    amrex::Print() << name << ": moved " << nmoved << " of " << cost.size()
+                   << " boxes (bound " << max_moves << "), max load "
+                   << lmax << " -> " << new_lmax << ", efficiency "
+                   << eff_cur << " -> " << eff_new << "\n";
+
+    if (new_lmax > lmax) {
+        amrex::Abort("DistributionMapping: makeIncremental increased the max load for " + name);
+    }
+    if (nmoved > 0 && Real(nmoved) >= max_moves) {
+        amrex::Abort("DistributionMapping: makeIncremental moved too many boxes for " + name);
+    }
+    if (nmoved == 0 && !(r == dm)) {
+        amrex::Abort("DistributionMapping: makeIncremental did not return the original mapping for " + name);
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 8;
+        Real threshold = 0.01_rt;
+        Real perturbation = 0.1_rt;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("threshold", threshold);
+            pp.query("perturbation", perturbation);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        const int nboxes = ba.size();
+
+        Vector<Real> cost(nboxes);
+        Vector<Real> new_cost(nboxes);
+        for (int i = 0; i < nboxes; ++i) {
+            cost[i] = 1.0_rt + 0.5_rt*std::sin(Real(i));
+            new_cost[i] = cost[i] * (1.0_rt + perturbation*std::cos(Real(3*i)));
+        }
+
+        for (auto curve : {DistributionMapping::MORTON, DistributionMapping::HILBERT})
+        {
+            DistributionMapping::SFC_Curve(curve);
+            const std::string name = (curve == DistributionMapping::MORTON) ? "Morton" : "Hilbert";
+
+            DistributionMapping dm(ba);
+            DistributionMapping dm2(ba);
+            if (dm.ProcessorMap() != dm2.ProcessorMap()) {
+                amrex::Abort("DistributionMapping: " + name + " SFC is not deterministic");
+            }
+            check_same_on_all(dm, name + " SFC");
+
+            DistributionMapping dmc = DistributionMapping::makeSFC(cost, ba);
+            check_same_on_all(dmc, name + " makeSFC");
+
+            // Balanced boxes of equal costs need no moves.
+            check_incremental(dm, Vector<Real>(nboxes, 1.0_rt), threshold, name + " equal costs");
+            check_incremental(dmc, cost, threshold, name + " SFC costs");
+            check_incremental(dmc, new_cost, threshold, name + " perturbed costs");
+        }
+
+        {
+            const auto how = DistributionMapping::strategy();
+            DistributionMapping::strategy(DistributionMapping::GRAPH);
+
+            DistributionMapping dm(ba);
+            DistributionMapping dm2(ba);
+            if (dm.ProcessorMap() != dm2.ProcessorMap()) {
+                amrex::Abort("DistributionMapping: GRAPH is not deterministic");
+            }
+            for (int i = 0; i < nboxes; ++i) {
+                if (dm[i] < 0 || dm[i] >= ParallelDescriptor::NProcs()) {
+                    amrex::Abort("DistributionMapping: GRAPH maps a box to an invalid process");
+                }
+            }
+            check_same_on_all(dm, "GRAPH");
+
+            // The node IDs are cached, so a mapping built by a subset of
+            // the processes must not wait for the others.
+            if (ParallelDescriptor::IOProcessor()) {
+                DistributionMapping dm3(ba);
+                if (dm3.ProcessorMap() != dm.ProcessorMap()) {
+                    amrex::Abort("DistributionMapping: GRAPH on one process differs");
+                }
+            }
+            ParallelDescriptor::Barrier();
+
+            DistributionMapping::strategy(how);
+            amrex::Print() << "GRAPH: " << nboxes << " boxes mapped\n";
+        }
+    }
+    amrex::Finalize();
+}
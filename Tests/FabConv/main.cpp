@@ -0,0 +1,129 @@
+//
+// Measure the throughput of RealDescriptor::convertFromNativeFormat and
+// convertToNativeFormat between the native Real and each IEEE format, e.g.,
+//
+//     OMP_NUM_THREADS=8 main3d.gnu.OMP.ex nitems=100000000
+//
+// The IEEE 32 and 64-bit formats in either byte order have fast paths.
+// The IEEE 32-bit format with the {2,1,4,3} byte order does not, it shows
+// the speed of the generic conversion.  The fast paths are also checked
+// against a cast with a byte swap.
+//
+// Runtime parameters:
+//     nitems  : number of Reals converted (default 16777216)
+//     nrepeat : number of timed conversions in each direction (default 5)
+//
+#include <AMReX.H>
+#include <AMReX_FabConv.H>
+#include <AMReX_FPC.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Random.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace amrex;
+
+namespace {
+
+// The value of x in format rd, computed with a cast and a byte permutation.
+void reference (char* out, Real x, const RealDescriptor& rd)
+{
+    char buf[8];
+    const int nb = rd.numBytes();
+    if (nb == 4) {
+        float f = static_cast<float>(x);
+        std::memcpy(buf, &f, 4);
+    } else {
+        double d = static_cast<double>(x);
+        std::memcpy(buf, &d, 8);
+    }
+    // The order arrays give the position of each byte, most significant first.
+    const int* native = (nb == 4) ? FPC::Native32RealDescriptor().order()
+                                  : FPC::Native64RealDescriptor().order();
+    const int* ord = rd.order();
+    for (int i = 0; i < nb; ++i) {
+        out[ord[i]-1] = buf[native[i]-1];
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        Long nitems = 16777216;
+        int nrepeat = 5;
+        {
+            ParmParse pp;
+            pp.query("nitems", nitems);
+            pp.query("nrepeat", nrepeat);
+        }
+
+        Vector<Real> native(nitems);
+        for (Long i = 0; i < nitems; ++i) {
+            native[i] = static_cast<Real>((amrex::Random() - 0.5) * 1.e3);
+        }
+        Vector<Real> back(nitems);
+        Vector<char> buffer(nitems * 8);
+
+        struct Format {
+            std::string name;
+            RealDescriptor rd;
+            bool check;  // The generic conversion truncates, so it is not checked.
+        };
+        Vector<Format> formats{
+            {"IEEE32 normal order ", RealDescriptor(FPC::ieee_float,  FPC::normal_float_order,    4), true},
+            {"IEEE32 reverse order", RealDescriptor(FPC::ieee_float,  FPC::reverse_float_order,   4), true},
+            {"IEEE64 normal order ", RealDescriptor(FPC::ieee_double, FPC::normal_double_order,   8), true},
+            {"IEEE64 reverse order", RealDescriptor(FPC::ieee_double, FPC::reverse_double_order,  8), true},
+            {"IEEE32 2143 (generic)", RealDescriptor(FPC::ieee_float,  FPC::reverse_float_order_2, 4), false}};
+
+        amrex::Print() << "\nConverting " << nitems << " Reals, "
+                       << (FPC::NativeRealDescriptor() == FPC::Native64RealDescriptor() ? "double" : "float")
+                       << " is native\n"
+                       << "    format                 from native (GB/s)   to native (GB/s)\n";
+
+        for (auto const& f : formats) {
+            const RealDescriptor& rd = f.rd;
+            // Bytes of Reals moved, so the numbers are comparable across formats.
+            const double gb = static_cast<double>(nitems) * sizeof(Real) / (1024.*1024.*1024.);
+
+            double tfrom = 1.e200;
+            for (int r = 0; r < nrepeat; ++r) {
+                double t0 = amrex::second();
+                RealDescriptor::convertFromNativeFormat(buffer.data(), nitems, native.data(), rd);
+                tfrom = std::min(tfrom, amrex::second() - t0);
+            }
+
+            double tto = 1.e200;
+            for (int r = 0; r < nrepeat; ++r) {
+                double t0 = amrex::second();
+                RealDescriptor::convertToNativeFormat(back.data(), nitems, buffer.data(), rd);
+                tto = std::min(tto, amrex::second() - t0);
+            }
+
+            Long nbad = 0;
+            const int nb = rd.numBytes();
+            for (Long i = 0; f.check && i < nitems; ++i) {
+                char expect[8];
+                reference(expect, native[i], rd);
+                if (std::memcmp(expect, buffer.data() + i*nb, nb) != 0) { ++nbad; }
+                Real roundtrip = (nb == 4) ? static_cast<Real>(static_cast<float>(native[i])) : native[i];
+                if (roundtrip != back[i]) { ++nbad; }
+            }
+
+            amrex::Print() << "    " << f.name << "   " << gb/tfrom << "   " << gb/tto
+                           << (nbad > 0 ? "   MISMATCHES: " + std::to_string(nbad) : std::string()) << "\n";
+
+            if (nbad > 0) {
+                amrex::Abort("FabConv: " + f.name + " does not match the reference conversion");
+            }
+        }
+    }
+    amrex::Finalize();
+}
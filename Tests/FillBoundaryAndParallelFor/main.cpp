@@ -0,0 +1,176 @@
+//
+// Check that FillBoundaryAndParallelFor, which overlaps the ghost cell
+// exchange with the computation on the interior of the boxes, gives the
+// same result as FillBoundary followed by ParallelFor, and that it visits
+// every valid cell exactly once.  This is also checked for a loop over the
+// nodes of the boxes, with a stencil reading the cells around each node.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 16)
+//     ncomp         : number of components (default 2)
+//     nghost        : width of the stencil and number of ghost cells (default 1)
+//
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <FillBoundaryInit.H>
+
+using namespace amrex;
+using FillBoundaryTest::init;
+
+namespace {
+
+// A stencil that reads every ghost cell within ng of the cell in each direction
+AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+Real stencil (Array4<Real const> const& a, int i, int j, int k, int n, int ng) noexcept
+{
+    Real r = Real(2*AMREX_SPACEDIM*ng+1) * a(i,j,k,n);
+    for (int m = 1; m <= ng; ++m) {
+        AMREX_D_TERM(r -= a(i-m,j,k,n) + a(i+m,j,k,n);,
+                     r -= a(i,j-m,k,n) + a(i,j+m,k,n);,
+                     r -= a(i,j,k-m,n) + a(i,j,k+m,n);)
+    }
+    return r;
+}
+
+// A stencil on the nodes that reads the cells within ng of the node
+AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE
+Real node_stencil (Array4<Real const> const& a, int i, int j, int k, int n, int ng) noexcept
+{
+    Real r = 0.0;
+    for (int m = 1; m <= ng; ++m) {
+        AMREX_D_TERM(r += a(i-m,j,k,n) - a(i+m-1,j,k,n);,
+                     r += Real(2.0)*(a(i,j-m,k,n) - a(i,j+m-1,k,n));,
+                     r += Real(3.0)*(a(i,j,k-m,n) - a(i,j,k+m-1,n));)
+    }
+    return r;
+}
+
+void check (MultiFab& result, MultiFab const& expected, std::string const& name)
+{
+    MultiFab::Subtract(result, expected, 0, 0, result.nComp(), 0);
+    Real const err = result.norm0(0, result.nComp(), IntVect(0));
+    amrex::Print() << name << ": max difference = " << err << "\n";
+    if (err != 0.0) {
+        amrex::Abort("FillBoundaryAndParallelFor: " + name + " differs from FillBoundary and ParallelFor");
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        int ncomp = 2;
+        int nghost = 1;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ncomp", ncomp);
+            pp.query("nghost", nghost);
+        }
+
+        Box const domain(IntVect(0), IntVect(n_cell-1));
+        RealBox const rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> const is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry const geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab phi(ba, dm, ncomp, nghost);
+        MultiFab expected(ba, dm, ncomp, 0);
+        MultiFab result(ba, dm, ncomp, 0);
+        iMultiFab count(ba, dm, 1, 0);
+        BoxArray const nba = amrex::convert(ba, IntVect(1));
+        MultiFab expected_nd(nba, dm, ncomp, 0);
+        MultiFab result_nd(nba, dm, ncomp, 0);
+        iMultiFab count_nd(nba, dm, 1, 0);
+
+        int const ng = nghost;
+        IntVect const ngv(nghost);
+
+        for (auto const& period : {geom.periodicity(), Periodicity::NonPeriodic()})
+        {
+            init(phi);
+            phi.FillBoundary(period);
+            auto const& pa = phi.const_arrays();
+            auto const& ea = expected.arrays();
+            amrex::ParallelFor(expected, IntVect(0), ncomp,
+            [=] AMREX_GPU_DEVICE (int b, int i, int j, int k, int n) noexcept
+            {
+                ea[b](i,j,k,n) = stencil(pa[b],i,j,k,n,ng);
+            });
+
+            // 4D version
+            init(phi);
+            result.setVal(0.0);
+            auto const& ra = result.arrays();
+            experimental::FillBoundaryAndParallelFor(phi, ngv, period, result, ncomp,
+            [=] AMREX_GPU_DEVICE (int b, int i, int j, int k, int n) noexcept
+            {
+                ra[b](i,j,k,n) = stencil(pa[b],i,j,k,n,ng);
+            });
+            Gpu::streamSynchronize();
+            check(result, expected, period.isAnyPeriodic() ? "periodic 4D" : "non-periodic 4D");
+
+            // 3D version, which also counts the visits of each cell
+            init(phi);
+            result.setVal(0.0);
+            count.setVal(0);
+            auto const& ca = count.arrays();
+            experimental::FillBoundaryAndParallelFor(phi, ngv, period, result,
+            [=] AMREX_GPU_DEVICE (int b, int i, int j, int k) noexcept
+            {
+                for (int n = 0; n < ncomp; ++n) {
+                    ra[b](i,j,k,n) = stencil(pa[b],i,j,k,n,ng);
+                }
+                ++ca[b](i,j,k);
+            });
+            Gpu::streamSynchronize();
+            check(result, expected, period.isAnyPeriodic() ? "periodic 3D" : "non-periodic 3D");
+            if (count.min(0) != 1 || count.max(0) != 1) {
+                amrex::Abort("FillBoundaryAndParallelFor: a cell is not visited exactly once");
+            }
+
+            // Nodal iteration space with cell-centered ghost cells
+            auto const& ena = expected_nd.arrays();
+            phi.FillBoundary(period);
+            amrex::ParallelFor(expected_nd, IntVect(0), ncomp,
+            [=] AMREX_GPU_DEVICE (int b, int i, int j, int k, int n) noexcept
+            {
+                ena[b](i,j,k,n) = node_stencil(pa[b],i,j,k,n,ng);
+            });
+
+            init(phi);
+            result_nd.setVal(0.0);
+            count_nd.setVal(0);
+            auto const& rna = result_nd.arrays();
+            auto const& cna = count_nd.arrays();
+            experimental::FillBoundaryAndParallelFor(phi, ngv, period, result_nd,
+            [=] AMREX_GPU_DEVICE (int b, int i, int j, int k) noexcept
+            {
+                for (int n = 0; n < ncomp; ++n) {
+                    rna[b](i,j,k,n) = node_stencil(pa[b],i,j,k,n,ng);
+                }
+                ++cna[b](i,j,k);
+            });
+            Gpu::streamSynchronize();
+            check(result_nd, expected_nd, period.isAnyPeriodic() ? "periodic nodal" : "non-periodic nodal");
+            if (count_nd.min(0) != 1 || count_nd.max(0) != 1) {
+                amrex::Abort("FillBoundaryAndParallelFor: a node is not visited exactly once");
+            }
+        }
+    }
+    amrex::Finalize();
+}
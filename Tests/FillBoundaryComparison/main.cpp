@@ -2,15 +2,20 @@
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_MultiFab.H>
 #include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
 
 #include <algorithm>
+#include <array>
 #include <fstream>
 
 #ifdef AMREX_USE_OMP
 #include <omp.h>
 #endif
 
+#include <FillBoundaryInit.H>
+
 using namespace amrex;
+using FillBoundaryTest::init;
 
 int
 main (int argc, char* argv[])
@@ -93,12 +98,10 @@ main (int argc, char* argv[])
             }
         }
 
-        if (ParallelDescriptor::IOProcessor()) {
-            std::cout << "min length = " << bsmin << std::endl;
-            std::cout << "num Pts    = " << ba.numPts() << std::endl;
-            std::cout << "num boxes  = " << ba.size() << std::endl;
-            std::cout << "num levels = " << nlevels << std::endl;
-        }
+        amrex::Print() << "min length = " << bsmin << "\n"
+                       << "num Pts    = " << ba.numPts() << "\n"
+                       << "num boxes  = " << ba.size() << "\n"
+                       << "num levels = " << nlevels << "\n";
     }
 
     ParallelDescriptor::Barrier();
@@ -119,9 +122,7 @@ main (int argc, char* argv[])
     Vector<Real> points(nlevels);
     for (int lev=0; lev<nlevels; ++lev) {
         points[lev] = mfs[lev]->norm1();
-        if (ParallelDescriptor::IOProcessor()) {
-            std::cout << points[lev] << " points on level " << lev << std::endl;
-        }
+        amrex::Print() << points[lev] << " points on level " << lev << "\n";
     }
 
     int nrounds = 1000;
@@ -130,37 +131,73 @@ main (int argc, char* argv[])
         pp.query("nrounds", nrounds);
     }
 
-    Real err = 0.0;
+    // Compare the point-to-point path with the neighborhood collectives
+    // and the persistent requests.
+    constexpr int ncomms = 3;
+    std::array<std::string,ncomms> const comm_names{"point-to-point", "neighbor collective",
+                                                    "persistent requests"};
+    std::array<double,ncomms> comm_times{0.,0.,0.};
+
+    // The reference ghost cells are filled by ParallelCopy, which does not
+    // go through the FillBoundary communication at all.
+    Vector<std::unique_ptr<MultiFab> > expected(nlevels);
+    for (int lev = 0; lev < nlevels; ++lev) {
+        MultiFab src(bas[lev], dm, 1, 0);
+        init(src);
+        expected[lev] = std::make_unique<MultiFab>(bas[lev], dm, 1, 1);
+        expected[lev]->setVal(-1.0);
+        expected[lev]->ParallelCopy(src, 0, 0, 1, IntVect(0), IntVect(1));
+    }
 
-    ParallelDescriptor::Barrier();
-    auto wt0 = ParallelDescriptor::second();
+    for (int icomm = 0; icomm < ncomms; ++icomm) {
+
+        FabArrayBase::fb_neighbor_comm = (icomm == 1);
+        FabArrayBase::fb_persistent_comm = (icomm == 2);
 
-    for (int iround = 0; iround < nrounds; ++iround) {
-        for (int c=0; c<2; ++c) {
-            for (int lev = 0; lev < nlevels; ++lev) {
-                mfs[lev]->FillBoundary_nowait();
-                mfs[lev]->FillBoundary_finish();
+        // Build the metadata, graph communicators and persistent requests
+        // outside the timer.
+        for (int lev = 0; lev < nlevels; ++lev) {
+            mfs[lev]->FillBoundary();
+        }
+
+        ParallelDescriptor::Barrier();
+        auto wt0 = ParallelDescriptor::second();
+
+        for (int iround = 0; iround < nrounds; ++iround) {
+            for (int c=0; c<2; ++c) {
+                for (int lev = 0; lev < nlevels; ++lev) {
+                    mfs[lev]->FillBoundary_nowait();
+                    mfs[lev]->FillBoundary_finish();
+                }
+                for (int lev = nlevels-1; lev >= 0; --lev) {
+                    mfs[lev]->FillBoundary_nowait();
+                    mfs[lev]->FillBoundary_finish();
+                }
             }
-            for (int lev = nlevels-1; lev >= 0; --lev) {
-                mfs[lev]->FillBoundary_nowait();
-                mfs[lev]->FillBoundary_finish();
+        }
+
+        ParallelDescriptor::Barrier();
+        auto wt1 = ParallelDescriptor::second();
+        comm_times[icomm] = wt1-wt0;
+
+        for (int lev = 0; lev < nlevels; ++lev) {
+            init(*mfs[lev]);
+            mfs[lev]->FillBoundary();
+            MultiFab::Subtract(*mfs[lev], *expected[lev], 0, 0, 1, 1);
+            const Real diff = mfs[lev]->norm0(0, 1);
+            if (diff != 0.0) {
+                amrex::Abort("FillBoundary (" + comm_names[icomm] + ") gave wrong ghost cells on level "
+                             + std::to_string(lev));
             }
         }
-        Real e = double(iround+ParallelDescriptor::MyProc());
-        ParallelDescriptor::ReduceRealMax(e);
-        err += e;
     }
 
-    ParallelDescriptor::Barrier();
-    auto wt1 = ParallelDescriptor::second();
-
-    if (ParallelDescriptor::IOProcessor()) {
-        std::cout << "Using MPI" << std::endl;
-        std::cout << "----------------------------------------------" << std::endl;
-        std::cout << "Fill Boundary Time: " << wt1-wt0 << std::endl;
-        std::cout << "----------------------------------------------" << std::endl;
-        std::cout << "ignore this line " << err << std::endl;
+    amrex::Print() << "----------------------------------------------\n";
+    for (int icomm = 0; icomm < ncomms; ++icomm) {
+        amrex::Print() << "Fill Boundary Time (" << comm_names[icomm] << "): "
+                       << comm_times[icomm] << "\n";
     }
+    amrex::Print() << "----------------------------------------------\n";
 
     //
     // When MPI3 shared memory is used, the dtor of MultiFab calls MPI
@@ -169,6 +206,7 @@ main (int argc, char* argv[])
     // destroy these MultiFabs by hand now.
     //
     mfs.clear();
+    expected.clear();
 
     }
     amrex::Finalize();
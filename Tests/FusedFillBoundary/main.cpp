@@ -0,0 +1,163 @@
+//
+// Check that the fused FillBoundary of several MultiFabs with different
+// numbers of components and ghost cells gives the same result as calling
+// FillBoundary on each of them.  Also check FabArrays of complex numbers,
+// whose stores are not atomic.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 8)
+//
+#include <AMReX.H>
+#include <AMReX_FabArray.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_GpuComplex.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <FillBoundaryInit.H>
+
+using namespace amrex;
+using FillBoundaryTest::init;
+
+namespace {
+
+using CFab = BaseFab<GpuComplex<Real> >;
+
+void init (FabArray<CFab>& fa)
+{
+    FillBoundaryTest::CellNumber const cell_number(fa.boxArray());
+    FillBoundaryTest::init(fa, GpuComplex<Real>(-1.0,-1.0),
+    [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+    {
+        Real const x = cell_number(i,j,k);
+        return GpuComplex<Real>(x, Real(n)*0.125 - x);
+    });
+}
+
+// Returns the number of cells, including ghost cells, where a and b differ.
+Long count_diff (FabArray<CFab> const& a, FabArray<CFab> const& b)
+{
+    Long ndiff = 0;
+    for (MFIter mfi(a); mfi.isValid(); ++mfi) {
+        auto const& aa = a.const_array(mfi);
+        auto const& ba = b.const_array(mfi);
+        ndiff += amrex::Reduce::Sum<Long>(mfi.fabbox().numPts()*a.nComp(),
+        [=] AMREX_GPU_DEVICE (Long idx) noexcept -> Long
+        {
+            auto const nc = static_cast<Long>(aa.nComp());
+            Box const bx(aa);
+            int const n = static_cast<int>(idx % nc);
+            IntVect const iv = bx.atOffset(idx / nc);
+            auto const x = aa(iv,n);
+            auto const y = ba(iv,n);
+            return (x.real() != y.real() || x.imag() != y.imag()) ? 1 : 0;
+        });
+    }
+    ParallelDescriptor::ReduceLongSum(ndiff);
+    return ndiff;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box const domain(IntVect(0), IntVect(n_cell-1));
+        RealBox const rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> const is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry const geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        // MultiFabs with different types, numbers of components and ghost
+        // cells, and one that only has some of its components filled.
+        Vector<MultiFab> mfs;
+        Vector<int> scomp, ncomp;
+        Vector<IntVect> nghost;
+        Vector<Periodicity> period;
+
+        auto add = [&] (IndexType typ, int nc, IntVect const& ng, int sc, int nc_fill,
+                        IntVect const& ng_fill, Periodicity const& p)
+        {
+            mfs.emplace_back(amrex::convert(ba,typ), dm, nc, ng);
+            scomp.push_back(sc);
+            ncomp.push_back(nc_fill);
+            nghost.push_back(ng_fill);
+            period.push_back(p);
+        };
+        add(IndexType::TheCellType(), 1, IntVect(1), 0, 1, IntVect(1), geom.periodicity());
+        add(IndexType::TheCellType(), 3, IntVect(2), 1, 2, IntVect(2), geom.periodicity());
+        add(IndexType::TheCellType(), 2, IntVect(2), 0, 2, IntVect(1), Periodicity::NonPeriodic());
+        add(IndexType::TheNodeType(), 1, IntVect(1), 0, 1, IntVect(1), geom.periodicity());
+        add(IndexType::TheCellType(), 1, IntVect(0), 0, 1, IntVect(0), geom.periodicity());
+        add(IndexType(IntVect(AMREX_D_DECL(1,0,0))), 2,
+            IntVect(AMREX_D_DECL(2,1,1)), 0, 2, IntVect(AMREX_D_DECL(2,1,1)), geom.periodicity());
+
+        const int nmfs = mfs.size();
+
+        Vector<MultiFab> expected(nmfs);
+        Vector<MultiFab*> pmfs(nmfs);
+        for (int imf = 0; imf < nmfs; ++imf) {
+            init(mfs[imf]);
+            expected[imf].define(mfs[imf].boxArray(), dm, mfs[imf].nComp(), mfs[imf].nGrowVect());
+            init(expected[imf]);
+            expected[imf].FillBoundary(scomp[imf], ncomp[imf], nghost[imf], period[imf]);
+            pmfs[imf] = &mfs[imf];
+        }
+
+        amrex::FillBoundary(pmfs, scomp, ncomp, nghost, period);
+
+        for (int imf = 0; imf < nmfs; ++imf) {
+            MultiFab::Subtract(mfs[imf], expected[imf], 0, 0, mfs[imf].nComp(),
+                               mfs[imf].nGrowVect());
+            Real const err = mfs[imf].norm0(0, mfs[imf].nComp(), mfs[imf].nGrowVect());
+            amrex::Print() << "MultiFab " << imf << ": max difference = " << err << "\n";
+            if (err != 0.0) {
+                amrex::Abort("Fused FillBoundary differs from FillBoundary");
+            }
+        }
+
+        {
+            Vector<FabArray<CFab> > cfas(2);
+            Vector<FabArray<CFab> > cexpected(2);
+            Vector<FabArray<CFab>*> pcfas(2);
+            Vector<int> const cscomp{0, 0};
+            Vector<int> const cncomp{1, 2};
+            Vector<IntVect> const cnghost{IntVect(1), IntVect(2)};
+            Vector<Periodicity> const cperiod(2, geom.periodicity());
+            for (int imf = 0; imf < 2; ++imf) {
+                cfas[imf].define(ba, dm, cncomp[imf], cnghost[imf]);
+                cexpected[imf].define(ba, dm, cncomp[imf], cnghost[imf]);
+                init(cfas[imf]);
+                init(cexpected[imf]);
+                cexpected[imf].FillBoundary(cperiod[imf]);
+                pcfas[imf] = &cfas[imf];
+            }
+
+            amrex::FillBoundary(pcfas, cscomp, cncomp, cnghost, cperiod);
+
+            for (int imf = 0; imf < 2; ++imf) {
+                Long const ndiff = count_diff(cfas[imf], cexpected[imf]);
+                amrex::Print() << "Complex FabArray " << imf << ": " << ndiff
+                               << " differences\n";
+                if (ndiff != 0) {
+                    amrex::Abort("Fused FillBoundary differs from FillBoundary for complex data");
+                }
+            }
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,97 @@
+//
+// Measure the STREAM-like bandwidth of MultiFab::LinComb to compare the
+// huge page and NUMA policies of the arenas, e.g.,
+//
+//     main3d.gnu.OMP.ex amrex.the_arena_huge_pages=transparent amrex.the_arena_numa=interleave
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 256)
+//     max_grid_size : max_grid_size used to chop the domain (default 64)
+//     ncomp         : number of components (default 4)
+//     nrepeat       : number of LinComb calls that are timed (default 20)
+//     serial_init   : if true, the data are first touched by a single thread (default false)
+//
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+void init (MultiFab& mf, Real v, bool serial_init)
+{
+    if (serial_init) {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::LoopOnCpu(mfi.fabbox(), mf.nComp(), [=] (int i, int j, int k, int n) noexcept
+            {
+                a(i,j,k,n) = v;
+            });
+        }
+    } else {
+        mf.setVal(v);
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 256;
+        int max_grid_size = 64;
+        int ncomp = 4;
+        int nrepeat = 20;
+        bool serial_init = false;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ncomp", ncomp);
+            pp.query("nrepeat", nrepeat);
+            pp.query("serial_init", serial_init);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        double t_alloc = amrex::second();
+        MultiFab x(ba, dm, ncomp, 0);
+        MultiFab y(ba, dm, ncomp, 0);
+        MultiFab z(ba, dm, ncomp, 0);
+        init(x, 1.0, serial_init);
+        init(y, 2.0, serial_init);
+        init(z, 0.0, serial_init);
+        t_alloc = amrex::second() - t_alloc;
+
+        // Warm up
+        MultiFab::LinComb(z, 0.5, x, 0, 0.25, y, 0, 0, ncomp, 0);
+
+        double t = amrex::second();
+        for (int i = 0; i < nrepeat; ++i) {
+            MultiFab::LinComb(z, 0.5, x, 0, 0.25, y, 0, 0, ncomp, 0);
+        }
+        t = amrex::second() - t;
+        ParallelDescriptor::ReduceRealMax(t);
+        ParallelDescriptor::ReduceRealMax(t_alloc);
+
+        // Two loads and a store per point.  Write-allocate traffic is not counted.
+        const double bytes = 3.0 * double(ba.numPts()) * ncomp * sizeof(Real) * nrepeat;
+
+        const Real zmin = z.min(0);
+        const Real zmax = z.max(0);
+        if (zmin != 1.0 || zmax != 1.0) {
+            amrex::Abort("LinComb gave wrong results");
+        }
+
+        amrex::Print() << "MultiFab size (MB) : " << double(ba.numPts())*ncomp*sizeof(Real)/(1024.*1024.) << "\n"
+                       << "Allocate and init  : " << t_alloc << " s\n"
+                       << "LinComb time       : " << t/nrepeat << " s per call\n"
+                       << "LinComb bandwidth  : " << bytes/t*1.e-9 << " GB/s\n";
+    }
+    amrex::Finalize();
+}
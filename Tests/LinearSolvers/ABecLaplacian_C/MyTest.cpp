@@ -5,6 +5,9 @@
 #include <AMReX_ParmParse.H>
 #include <AMReX_MultiFabUtil.H>
 
+#include <iomanip>
+#include <limits>
+
 using namespace amrex;
 
 MyTest::MyTest ()
@@ -19,7 +22,13 @@ MyTest::solve ()
     if (prob_type == 1) {
         solvePoisson();
     } else if (prob_type == 2) {
-        solveABecLaplacian();
+        if (benchmark_stencil_storage) {
+            benchmarkStencilStorage();
+        } else if (compare_with_default) {
+            compareWithDefault();
+        } else {
+            solveABecLaplacian();
+        }
     } else if (prob_type == 3) {
         solveABecLaplacianInhomNeumann();
     } else {
@@ -65,6 +74,7 @@ MyTest::solvePoisson ()
         mlmg.setMaxFmgIter(max_fmg_iter);
         mlmg.setVerbose(verbose);
         mlmg.setBottomVerbose(bottom_verbose);
+        mlmg.setBottomSolver(bottom_solver);
 #ifdef AMREX_USE_HYPRE
         if (use_hypre) {
             mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -106,6 +116,7 @@ MyTest::solvePoisson ()
             mlmg.setMaxFmgIter(max_fmg_iter);
             mlmg.setVerbose(verbose);
             mlmg.setBottomVerbose(bottom_verbose);
+            mlmg.setBottomSolver(bottom_solver);
 #ifdef AMREX_USE_HYPRE
             if (use_hypre) {
                 mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -144,14 +155,12 @@ MyTest::solveABecLaplacian ()
         MLABecLaplacian mlabec(geom, grids, dmap, info);
 
         mlabec.setMaxOrder(linop_maxorder);
+        mlabec.setFusedSmoothing(fused_sweeps);
+        mlabec.setStencilStorage(stencil_storage);
 
-        // This is a 3d problem with homogeneous Neumann BC
-        mlabec.setDomainBC({AMREX_D_DECL(LinOpBCType::Neumann,
-                                         LinOpBCType::Neumann,
-                                         LinOpBCType::Neumann)},
-                           {AMREX_D_DECL(LinOpBCType::Neumann,
-                                         LinOpBCType::Neumann,
-                                         LinOpBCType::Neumann)});
+        // This is a 3d problem with homogeneous Neumann BC by default
+        mlabec.setDomainBC({AMREX_D_DECL(domainBC(),domainBC(),domainBC())},
+                           {AMREX_D_DECL(domainBC(),domainBC(),domainBC())});
 
         for (int ilev = 0; ilev < nlevels; ++ilev)
         {
@@ -182,6 +191,10 @@ MyTest::solveABecLaplacian ()
         mlmg.setMaxFmgIter(max_fmg_iter);
         mlmg.setVerbose(verbose);
         mlmg.setBottomVerbose(bottom_verbose);
+        mlmg.setBottomSolver(bottom_solver);
+        mlmg.setMixedPrecision(mixed_precision);
+        mlmg.setPreSmooth(nsmooth);
+        mlmg.setPostSmooth(nsmooth);
 #ifdef AMREX_USE_HYPRE
         if (use_hypre) {
             mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -195,22 +208,22 @@ MyTest::solveABecLaplacian ()
 #endif
 
         mlmg.solve(GetVecOfPtrs(solution), GetVecOfConstPtrs(rhs), tol_rel, tol_abs);
+        num_iters = mlmg.getNumIters();
     }
     else
     {
+        num_iters = 0;
         for (int ilev = 0; ilev < nlevels; ++ilev)
         {
             MLABecLaplacian mlabec({geom[ilev]}, {grids[ilev]}, {dmap[ilev]}, info);
 
             mlabec.setMaxOrder(linop_maxorder);
+            mlabec.setFusedSmoothing(fused_sweeps);
+            mlabec.setStencilStorage(stencil_storage);
 
-            // This is a 3d problem with homogeneous Neumann BC
-            mlabec.setDomainBC({AMREX_D_DECL(LinOpBCType::Neumann,
-                                             LinOpBCType::Neumann,
-                                             LinOpBCType::Neumann)},
-                               {AMREX_D_DECL(LinOpBCType::Neumann,
-                                             LinOpBCType::Neumann,
-                                             LinOpBCType::Neumann)});
+            // This is a 3d problem with homogeneous Neumann BC by default
+            mlabec.setDomainBC({AMREX_D_DECL(domainBC(),domainBC(),domainBC())},
+                               {AMREX_D_DECL(domainBC(),domainBC(),domainBC())});
 
             if (ilev > 0) {
                 mlabec.setCoarseFineBC(&solution[ilev-1], ref_ratio);
@@ -239,6 +252,10 @@ MyTest::solveABecLaplacian ()
             mlmg.setMaxFmgIter(max_fmg_iter);
             mlmg.setVerbose(verbose);
             mlmg.setBottomVerbose(bottom_verbose);
+            mlmg.setBottomSolver(bottom_solver);
+            mlmg.setMixedPrecision(mixed_precision);
+            mlmg.setPreSmooth(nsmooth);
+            mlmg.setPostSmooth(nsmooth);
 #ifdef AMREX_USE_HYPRE
             if (use_hypre) {
                 mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -252,12 +269,14 @@ MyTest::solveABecLaplacian ()
 #endif
 
             mlmg.solve({&solution[ilev]}, {&rhs[ilev]}, tol_rel, tol_abs);
+            num_iters += mlmg.getNumIters();
         }
     }
 
     // Since this problem has Neumann BC, solution + constant is also a
     // solution.  So we are going to shift the solution by a constant
     // for comparison with the "exact solution".
+    if (bc_type != "neumann") return;
     const Real npts = grids[0].d_numPts();
     const Real avg1 = exact_solution[0].sum();
     const Real avg2 = solution[0].sum();
@@ -267,6 +286,122 @@ MyTest::solveABecLaplacian ()
     }
 }
 
+void
+MyTest::benchmarkStencilStorage ()
+{
+    using StencilStorage = MLABecLaplacian::StencilStorage;
+    struct Mode {
+        StencilStorage storage;
+        bool mixed_precision;
+        std::string name;
+    };
+    const Vector<Mode> modes{{StencilStorage::none, false, "none"},
+                             {StencilStorage::full, false, "full"},
+                             {StencilStorage::reduced, false, "reduced"},
+                             {StencilStorage::none, true, "mixed"}};
+    const int nrepeat = 3;
+    Vector<double> times;
+    Vector<int> iters;
+    Vector<Real> errors;
+    for (auto const& mode : modes)
+    {
+        stencil_storage = mode.storage;
+        mixed_precision = mode.mixed_precision;
+        double tmin = std::numeric_limits<double>::max();
+        for (int i = 0; i < nrepeat; ++i)
+        {
+            for (auto& mf : solution) {
+                mf.setVal(0.0);
+            }
+            ParallelDescriptor::Barrier();
+            double t0 = amrex::second();
+            solveABecLaplacian();
+            double t = amrex::second() - t0;
+            ParallelDescriptor::ReduceRealMax(t);
+            tmin = std::min(tmin, t);
+        }
+        times.push_back(tmin);
+        iters.push_back(num_iters);
+
+        Real error = 0.0;
+        for (int ilev = 0; ilev < static_cast<int>(geom.size()); ++ilev) {
+            MultiFab diff(grids[ilev], dmap[ilev], 1, 0);
+            MultiFab::Copy(diff, solution[ilev], 0, 0, 1, 0);
+            MultiFab::Subtract(diff, exact_solution[ilev], 0, 0, 1, 0);
+            error = std::max(error, diff.norm0());
+        }
+        errors.push_back(error);
+    }
+
+    amrex::Print() << "\nStencil storage   solve time (s)   speedup   iterations   max error\n";
+    for (int m = 0; m < static_cast<int>(modes.size()); ++m) {
+        amrex::Print() << "    " << std::setw(8) << std::left << modes[m].name << std::right
+                       << std::fixed << std::setprecision(4) << std::setw(15) << times[m]
+                       << std::setprecision(3) << std::setw(13) << times[0]/times[m]
+                       << std::setw(13) << iters[m]
+                       << std::scientific << std::setprecision(6) << std::setw(15) << errors[m]
+                       << "\n";
+    }
+}
+
+void
+MyTest::compareWithDefault ()
+{
+    solveABecLaplacian();
+    const int iters = num_iters;
+
+    const int nlevels = geom.size();
+    Vector<MultiFab> diff(nlevels);
+    for (int ilev = 0; ilev < nlevels; ++ilev) {
+        diff[ilev].define(grids[ilev], dmap[ilev], 1, 0);
+        MultiFab::Copy(diff[ilev], solution[ilev], 0, 0, 1, 0);
+        solution[ilev].setVal(0.0);
+    }
+
+    // Solve again with the default solver settings, and as many
+    // smoothing sweeps as the fused ones.
+    const int fused_sweeps_save = fused_sweeps;
+    const int nsmooth_save = nsmooth;
+    const auto stencil_storage_save = stencil_storage;
+    const bool mixed_precision_save = mixed_precision;
+    const auto bottom_solver_save = bottom_solver;
+    fused_sweeps = 0;
+    nsmooth = nsmooth_save * std::max(fused_sweeps_save, 1);
+    stencil_storage = MLABecLaplacian::StencilStorage::none;
+    mixed_precision = false;
+    bottom_solver = BottomSolver::Default;
+
+    solveABecLaplacian();
+
+    fused_sweeps = fused_sweeps_save;
+    nsmooth = nsmooth_save;
+    stencil_storage = stencil_storage_save;
+    mixed_precision = mixed_precision_save;
+    bottom_solver = bottom_solver_save;
+
+    Real max_diff = 0.0;
+    Real max_sol = 0.0;
+    for (int ilev = 0; ilev < nlevels; ++ilev) {
+        MultiFab::Subtract(diff[ilev], solution[ilev], 0, 0, 1, 0);
+        max_diff = std::max(max_diff, diff[ilev].norm0());
+        max_sol = std::max(max_sol, solution[ilev].norm0());
+    }
+
+    amrex::Print() << "\nIterations: " << iters << " (default: " << num_iters << ")"
+                   << ", max difference from the default solve: " << max_diff << "\n";
+
+    if (compare_with_default == 2) {
+        if (max_diff != 0.0) {
+            amrex::Abort("The solution is not bit-identical to the default solve");
+        }
+    } else if (max_diff > 1.e-6*max_sol) {
+        amrex::Abort("The solution differs from the default solve");
+    }
+    if (iters > 2*num_iters) {
+        amrex::Abort("The solve took more than twice the iterations of the default solve");
+    }
+}
+
 void
 MyTest::solveABecLaplacianInhomNeumann ()
 {
@@ -286,6 +421,8 @@ MyTest::solveABecLaplacianInhomNeumann ()
         MLABecLaplacian mlabec(geom, grids, dmap, info);
 
         mlabec.setMaxOrder(linop_maxorder);
+        mlabec.setFusedSmoothing(fused_sweeps);
+        mlabec.setStencilStorage(stencil_storage);
 
         // This is a 3d problem with inhomogeneous Neumann BC
         mlabec.setDomainBC({AMREX_D_DECL(LinOpBCType::inhomogNeumann,
@@ -324,6 +461,10 @@ MyTest::solveABecLaplacianInhomNeumann ()
         mlmg.setMaxFmgIter(max_fmg_iter);
         mlmg.setVerbose(verbose);
         mlmg.setBottomVerbose(bottom_verbose);
+        mlmg.setBottomSolver(bottom_solver);
+        mlmg.setMixedPrecision(mixed_precision);
+        mlmg.setPreSmooth(nsmooth);
+        mlmg.setPostSmooth(nsmooth);
 #ifdef AMREX_USE_HYPRE
         if (use_hypre) {
             mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -345,6 +486,8 @@ MyTest::solveABecLaplacianInhomNeumann ()
             MLABecLaplacian mlabec({geom[ilev]}, {grids[ilev]}, {dmap[ilev]}, info);
 
             mlabec.setMaxOrder(linop_maxorder);
+            mlabec.setFusedSmoothing(fused_sweeps);
+            mlabec.setStencilStorage(stencil_storage);
 
             // This is a 3d problem with inhomogeneous Neumann BC
             mlabec.setDomainBC({AMREX_D_DECL(LinOpBCType::inhomogNeumann,
@@ -381,6 +524,10 @@ MyTest::solveABecLaplacianInhomNeumann ()
             mlmg.setMaxFmgIter(max_fmg_iter);
             mlmg.setVerbose(verbose);
             mlmg.setBottomVerbose(bottom_verbose);
+            mlmg.setBottomSolver(bottom_solver);
+            mlmg.setMixedPrecision(mixed_precision);
+            mlmg.setPreSmooth(nsmooth);
+            mlmg.setPostSmooth(nsmooth);
 #ifdef AMREX_USE_HYPRE
             if (use_hypre) {
                 mlmg.setBottomSolver(MLMG::BottomSolver::hypre);
@@ -409,6 +556,18 @@ MyTest::solveABecLaplacianInhomNeumann ()
     }
 }
 
+LinOpBCType
+MyTest::domainBC () const
+{
+    if (bc_type == "dirichlet") {
+        return LinOpBCType::Dirichlet;
+    } else if (bc_type == "periodic") {
+        return LinOpBCType::Periodic;
+    } else {
+        return LinOpBCType::Neumann;
+    }
+}
+
 void
 MyTest::readParameters ()
 {
@@ -421,6 +580,10 @@ MyTest::readParameters ()
     pp.query("composite_solve", composite_solve);
 
     pp.query("prob_type", prob_type);
+    pp.query("bc_type", bc_type);
+    if (bc_type != "neumann" && bc_type != "dirichlet" && bc_type != "periodic") {
+        amrex::Abort("Unknown bc_type: " + bc_type);
+    }
 
     pp.query("verbose", verbose);
     pp.query("bottom_verbose", bottom_verbose);
@@ -432,6 +595,41 @@ MyTest::readParameters ()
     pp.query("semicoarsening", semicoarsening);
     pp.query("max_coarsening_level", max_coarsening_level);
     pp.query("max_semicoarsening_level", max_semicoarsening_level);
+    pp.query("fused_sweeps", fused_sweeps);
+    pp.query("nsmooth", nsmooth);
+    {
+        std::string stencil_storage_s;
+        pp.query("stencil_storage", stencil_storage_s);
+        if (stencil_storage_s == "full") {
+            stencil_storage = MLABecLaplacian::StencilStorage::full;
+        } else if (stencil_storage_s == "reduced") {
+            stencil_storage = MLABecLaplacian::StencilStorage::reduced;
+        } else if (!stencil_storage_s.empty() && stencil_storage_s != "none") {
+            amrex::Abort("Unknown stencil_storage: " + stencil_storage_s);
+        }
+    }
+    pp.query("mixed_precision", mixed_precision);
+    pp.query("benchmark_stencil_storage", benchmark_stencil_storage);
+    pp.query("compare_with_default", compare_with_default);
+    {
+        std::string bottom_solver_s;
+        pp.query("bottom_solver", bottom_solver_s);
+        if (bottom_solver_s == "smoother") {
+            bottom_solver = BottomSolver::smoother;
+        } else if (bottom_solver_s == "bicgstab") {
+            bottom_solver = BottomSolver::bicgstab;
+        } else if (bottom_solver_s == "cg") {
+            bottom_solver = BottomSolver::cg;
+        } else if (bottom_solver_s == "pbicgstab") {
+            bottom_solver = BottomSolver::pbicgstab;
+        } else if (bottom_solver_s == "pcg") {
+            bottom_solver = BottomSolver::pcg;
+        } else if (bottom_solver_s == "amg") {
+            bottom_solver = BottomSolver::amg;
+        } else if (!bottom_solver_s.empty()) {
+            amrex::Abort("Unknown bottom_solver: " + bottom_solver_s);
+        }
+    }
 
 #ifdef AMREX_USE_HYPRE
     pp.query("use_hypre", use_hypre);
@@ -469,7 +667,8 @@ MyTest::initData ()
     }
 
     RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
-    Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(0,0,0)};
+    const int periodic = (prob_type == 2 && bc_type == "periodic");
+    Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(periodic,periodic,periodic)};
     Geometry::Setup(&rb, 0, is_periodic.data());
     Box domain0(IntVect{AMREX_D_DECL(0,0,0)}, IntVect{AMREX_D_DECL(n_cell-1,n_cell-1,n_cell-1)});
     Box domain = domain0;
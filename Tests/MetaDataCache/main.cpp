@@ -0,0 +1,148 @@
+//
+// Check the FillBoundary metadata cache with a memory budget: the least
+// recently used items are evicted first, the hits, misses and evictions
+// are counted, and the recorded size of an item grows when its persistent
+// buffers or its graph communicator are built.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 16)
+//
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+void require (bool cond, std::string const& what)
+{
+    if (!cond) {
+        amrex::Abort("MetaDataCache: " + what);
+    }
+}
+
+// Fill the ghost cells with each communication path, and check that the
+// recorded size of the FB grows by at least the size of the buffers or
+// the graph communicator.
+void check_comm_bytes (MultiFab& mf, Periodicity const& period)
+{
+#ifdef AMREX_USE_MPI
+    bool const persistent_comm = FabArrayBase::fb_persistent_comm;
+    bool const neighbor_comm = FabArrayBase::fb_neighbor_comm;
+
+    for (int icomm = 0; icomm < 2; ++icomm) {
+        FabArrayBase::flushFBCache();
+        FabArrayBase::fb_persistent_comm = (icomm == 0);
+        FabArrayBase::fb_neighbor_comm = (icomm == 1);
+
+        auto const& fb = mf.getFB(mf.nGrowVect(), period);
+        Long const before = FabArrayBase::m_TheFBCache.bytes();
+        require(before == fb.bytes(), "the size of the new FB is not recorded");
+
+        mf.FillBoundary(period);
+
+        Long const after = FabArrayBase::m_TheFBCache.bytes();
+        require(after == fb.bytes(), "the size of the FB is not updated");
+        if (icomm == 0 && fb.m_pcomm) {
+            Long nbuf = 0;
+            for (auto n : fb.m_pcomm->recv_size) { nbuf += n; }
+            for (auto n : fb.m_pcomm->send_size) { nbuf += n; }
+            require(after >= before + nbuf, "the persistent buffers are not counted");
+        }
+        if (icomm == 1 && ParallelDescriptor::NProcs() > 1) {
+            require(fb.m_ncomm && after > before, "the graph communicator is not counted");
+        }
+        amrex::Print() << (icomm == 0 ? "persistent requests" : "neighbor collective")
+                       << ": FB size " << before << " -> " << after << " bytes\n";
+    }
+
+    FabArrayBase::flushFBCache();
+    FabArrayBase::fb_persistent_comm = persistent_comm;
+    FabArrayBase::fb_neighbor_comm = neighbor_comm;
+#else
+    amrex::ignore_unused(mf, period);
+#endif
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box const domain(IntVect(0), IntVect(n_cell-1));
+        RealBox const rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> const is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry const geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, 1, 3);
+        mf.setVal(0.0);
+
+        bool const persistent_comm = FabArrayBase::fb_persistent_comm;
+        bool const neighbor_comm = FabArrayBase::fb_neighbor_comm;
+        Long const max_bytes = FabArrayBase::metadata_cache_max_bytes;
+        FabArrayBase::fb_persistent_comm = false;
+        FabArrayBase::fb_neighbor_comm = false;
+
+        auto getFB = [&] (int ng) -> FabArrayBase::FB const& {
+            return mf.getFB(IntVect(ng), geom.periodicity());
+        };
+
+        // The sizes of the FBs for 1, 2 and 3 ghost cells
+        FabArrayBase::metadata_cache_max_bytes = 0;
+        FabArrayBase::flushFBCache();
+        Long maxbytes = 0;
+        for (int ng = 1; ng <= 3; ++ng) {
+            maxbytes = std::max(maxbytes, getFB(ng).bytes());
+        }
+        FabArrayBase::flushFBCache();
+
+        // Any two of them exceed the budget, so that inserting an item
+        // leaves only the most recently used one of the others.
+        FabArrayBase::metadata_cache_max_bytes = maxbytes;
+        auto const& stats = FabArrayBase::m_FBC_stats;
+        Long const nhit0 = stats.nhit;
+        Long const nmiss0 = stats.nmiss;
+        Long const nevict0 = stats.nevict;
+
+        FabArrayBase::FB const* fb1 = &getFB(1);  // miss: {1}
+        getFB(2);                                 // miss: {2,1}
+        require(&getFB(1) == fb1, "FB 1 was not kept");  // hit: {1,2}
+        getFB(3);                                 // miss, evicts 2: {3,1}
+        require(&getFB(1) == fb1, "the most recently used FB was evicted");  // hit: {1,3}
+        getFB(2);                                 // miss, evicts 3: {2,1}
+        require(&getFB(1) == fb1, "FB 1 was evicted instead of FB 3");  // hit: {1,2}
+
+        Long const nhit = stats.nhit - nhit0;
+        Long const nmiss = stats.nmiss - nmiss0;
+        Long const nevict = stats.nevict - nevict0;
+        amrex::Print() << "hits " << nhit << ", misses " << nmiss << ", evictions " << nevict
+                       << ", size " << FabArrayBase::m_TheFBCache.size() << "\n";
+        require(nhit == 3 && nmiss == 4 && nevict == 2, "wrong cache statistics");
+        require(FabArrayBase::m_TheFBCache.size() == 2, "wrong number of cached FBs");
+
+        FabArrayBase::metadata_cache_max_bytes = 0;
+        check_comm_bytes(mf, geom.periodicity());
+
+        FabArrayBase::fb_persistent_comm = persistent_comm;
+        FabArrayBase::fb_neighbor_comm = neighbor_comm;
+        FabArrayBase::metadata_cache_max_bytes = max_bytes;
+    }
+    amrex::Finalize();
+}
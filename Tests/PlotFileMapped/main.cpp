@@ -0,0 +1,115 @@
+//
+// Check that the memory-mapped plotfile reader gives bitwise the same data as
+// PlotFileData::get, with and without the sparse access hint, for all
+// components, for a single variable, and for single FABs with mapFab.  Both
+// a header version with FAB headers and one without are checked; without FAB
+// headers every FAB must be mappable.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 16)
+//
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_PlotFileUtil.H>
+#include <AMReX_Print.H>
+#include <AMReX_VisMF.H>
+
+#include <cstring>
+
+using namespace amrex;
+
+namespace {
+
+// Returns the number of local FABs of b that differ from those of a.
+int compare (const MultiFab& a, const MultiFab& b)
+{
+    int nbad = 0;
+    for (MFIter mfi(a); mfi.isValid(); ++mfi) {
+        if (a[mfi].box() != b[mfi].box() || a[mfi].nComp() != b[mfi].nComp() ||
+            std::memcmp(a[mfi].dataPtr(), b[mfi].dataPtr(), a[mfi].nBytes()) != 0) {
+            ++nbad;
+        }
+    }
+    return nbad;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        Box const domain(IntVect(0), IntVect(n_cell-1));
+        RealBox const rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry const geom(domain, rb, CoordSys::cartesian, {AMREX_D_DECL(0,0,0)});
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        MultiFab mf(ba, dm, ncomp, 0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::ParallelFor(mfi.validbox(), ncomp,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+            {
+                a(i,j,k,n) = std::sin(Real(AMREX_D_TERM(i, + 3*j, + 7*k) + 11*n));
+            });
+        }
+        const Vector<std::string> varnames{"a", "b", "c"};
+
+        for (auto version : {VisMF::Header::Version_v1, VisMF::Header::NoFabHeader_v1})
+        {
+            VisMF::SetHeaderVersion(version);
+            const std::string name = "plt_mapped_v" + std::to_string(static_cast<int>(version));
+            WriteSingleLevelPlotfile(name, mf, varnames, geom, 0.0, 0);
+
+            int nbad = 0;
+            {
+                PlotFileData pf(name);
+                MultiFab all = pf.get(0);
+                nbad += compare(all, pf.getMapped(0));
+                nbad += compare(all, pf.getMapped(0, true));
+
+                for (int n = 0; n < ncomp; ++n) {
+                    MultiFab var = pf.get(0, varnames[n]);
+                    nbad += compare(var, pf.getMapped(0, varnames[n]));
+                    nbad += compare(var, pf.getMapped(0, varnames[n], true));
+                }
+
+                // The text FAB headers of Version_v1 usually leave the data
+                // unaligned in the file, in which case mapFab returns null.
+                const bool may_be_null = (version == VisMF::Header::Version_v1);
+                for (MFIter mfi(all); mfi.isValid(); ++mfi) {
+                    Array4<Real const> const& m = pf.mapFab(0, mfi.index());
+                    FArrayBox const& fab = all[mfi];
+                    if (m.p == nullptr) {
+                        if (!may_be_null) { ++nbad; }
+                    } else if (Box(m) != fab.box() || m.ncomp != fab.nComp() ||
+                               std::memcmp(m.p, fab.dataPtr(), fab.nBytes()) != 0) {
+                        ++nbad;
+                    }
+                }
+            }
+
+            ParallelDescriptor::ReduceIntSum(nbad);
+            amrex::Print() << "Header version " << static_cast<int>(version)
+                           << ": " << nbad << " mismatches\n";
+            if (nbad > 0) {
+                amrex::Abort("PlotFileMapped: the mapped data differ from the data read");
+            }
+        }
+    }
+    amrex::Finalize();
+}
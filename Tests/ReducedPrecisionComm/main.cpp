@@ -0,0 +1,177 @@
+//
+// Check that FillBoundary<float> and ParallelCopy<float> round the data
+// sent to other processes to single precision, and copy the data within a
+// process exactly.  FillBoundary is checked with point-to-point messages
+// and with persistent requests, twice each so that the persistent buffers
+// are reused.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 8)
+//     ncomp         : number of components (default 2)
+//     nghost        : number of ghost cells (default 2)
+//
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+// Every valid cell gets a value unique to the cell and the component that
+// float cannot represent exactly, and every ghost cell gets -1.
+void init (MultiFab& mf, int n_cell)
+{
+    mf.setVal(-1.0);
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        auto const& a = mf.array(mfi);
+        amrex::ParallelFor(mfi.validbox(), mf.nComp(),
+        [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+        {
+            amrex::ignore_unused(j,k);
+            Long const m = n_cell + 1;
+            a(i,j,k,n) = (Real(AMREX_D_TERM(Long(i), + m*Long(j), + m*m*Long(k)))
+                          + Real(n)*0.125 + 1.0) / 3.0;
+        });
+    }
+}
+
+// Every valid cell gets the rank that owns it, and every ghost cell gets -1.
+void init_owner (MultiFab& owner)
+{
+    owner.setVal(-1.0);
+    owner.setVal(Real(ParallelDescriptor::MyProc()), 0, 1, 0);
+}
+
+// The data of result must be those of ref, rounded to float if they come
+// from another process according to owner, and exact otherwise.  Returns
+// the number of cells that are wrong, and the number of rounded cells that
+// differ from ref in nrounded.
+Long check (MultiFab const& result, MultiFab const& ref, MultiFab const& owner,
+            IntVect const& nghost, Long& nrounded)
+{
+    const int myproc = ParallelDescriptor::MyProc();
+    const int ncomp = result.nComp();
+    Real const nbad = amrex::ReduceSum(result, ref, owner, nghost,
+        [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& r,
+                                   Array4<Real const> const& e, Array4<Real const> const& o)
+        -> Real
+        {
+            Real s = 0.0;
+            AMREX_LOOP_4D(bx, ncomp, i, j, k, n,
+            {
+                const bool remote = o(i,j,k) >= 0.0 && static_cast<int>(o(i,j,k)) != myproc;
+                Real const expected = remote ? static_cast<Real>(static_cast<float>(e(i,j,k,n)))
+                                             : e(i,j,k,n);
+                if (r(i,j,k,n) != expected) { s += 1.0; }
+            });
+            return s;
+        });
+    Real const nr = amrex::ReduceSum(result, ref, nghost,
+        [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& r,
+                                   Array4<Real const> const& e) -> Real
+        {
+            Real s = 0.0;
+            AMREX_LOOP_4D(bx, ncomp, i, j, k, n,
+            {
+                if (r(i,j,k,n) != e(i,j,k,n)) { s += 1.0; }
+            });
+            return s;
+        });
+    Long nb = static_cast<Long>(nbad);
+    nrounded = static_cast<Long>(nr);
+    ParallelDescriptor::ReduceLongSum(nb);
+    ParallelDescriptor::ReduceLongSum(nrounded);
+    return nb;
+}
+
+void report (std::string const& name, Long nbad, Long nrounded)
+{
+    amrex::Print() << name << ": " << nbad << " wrong values, "
+                   << nrounded << " rounded values\n";
+    if (nbad != 0) {
+        amrex::Abort("ReducedPrecisionComm: " + name + " did not round the data sent to other processes only");
+    }
+    if (ParallelDescriptor::NProcs() > 1 && nrounded == 0) {
+        amrex::Abort("ReducedPrecisionComm: " + name + " did not round any data");
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        int ncomp = 2;
+        int nghost = 2;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ncomp", ncomp);
+            pp.query("nghost", nghost);
+        }
+
+        Box const domain(IntVect(0), IntVect(n_cell-1));
+        RealBox const rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> const is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry const geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        IntVect const ngv(nghost);
+
+        MultiFab ref(ba, dm, ncomp, nghost);
+        init(ref, n_cell);
+        ref.FillBoundary(geom.periodicity());
+
+        MultiFab owner(ba, dm, 1, nghost);
+        init_owner(owner);
+        owner.FillBoundary(geom.periodicity());
+
+        MultiFab mf(ba, dm, ncomp, nghost);
+        bool const persistent_comm = FabArrayBase::fb_persistent_comm;
+        for (bool persistent : {false, true}) {
+            FabArrayBase::fb_persistent_comm = persistent;
+            for (int i = 0; i < 2; ++i) {
+                init(mf, n_cell);
+                mf.FillBoundary<float>(geom.periodicity());
+                Long nrounded;
+                Long const nbad = check(mf, ref, owner, ngv, nrounded);
+                report(persistent ? "FillBoundary<float> persistent"
+                                  : "FillBoundary<float>", nbad, nrounded);
+            }
+        }
+        FabArrayBase::fb_persistent_comm = persistent_comm;
+
+        // A destination with different boxes, owned by different processes
+        BoxArray dst_ba(domain);
+        dst_ba.maxSize(max_grid_size*2);
+        Vector<int> pmap(dst_ba.size());
+        for (int i = 0; i < dst_ba.size(); ++i) {
+            pmap[i] = (i+1) % ParallelDescriptor::NProcs();
+        }
+        DistributionMapping dst_dm(pmap);
+
+        MultiFab dst_ref(dst_ba, dst_dm, ncomp, 0);
+        dst_ref.ParallelCopy(ref, 0, 0, ncomp);
+
+        MultiFab dst_owner(dst_ba, dst_dm, 1, 0);
+        dst_owner.ParallelCopy(owner, 0, 0, 1);
+
+        MultiFab dst(dst_ba, dst_dm, ncomp, 0);
+        dst.setVal(-1.0);
+        dst.ParallelCopy<float>(ref, 0, 0, ncomp, IntVect(0), IntVect(0));
+        Long nrounded;
+        Long const nbad = check(dst, dst_ref, dst_owner, IntVect(0), nrounded);
+        report("ParallelCopy<float>", nbad, nrounded);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,182 @@
+//
+// Check that the communication metadata built with OpenMP threads by
+// FB::define_fb, FB::define_epo and CPC::define is the same as that built
+// with one thread: the local, send and receive tags must be equal and in
+// the same order.  With more than one thread, the metadata must not be
+// flagged thread safe unless the destination boxes of its tags are
+// disjoint.  Run with OMP_NUM_THREADS > 1; without OpenMP this only checks
+// that the metadata is deterministic.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 64)
+//     max_grid_size : max_grid_size used to chop the domain (default 8)
+//
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <memory>
+
+#ifdef AMREX_USE_OMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+namespace {
+
+void set_num_threads (int nthreads)
+{
+#ifdef AMREX_USE_OMP
+    omp_set_num_threads(nthreads);
+#else
+    amrex::ignore_unused(nthreads);
+#endif
+}
+
+bool same (const FabArrayBase::CopyComTagsContainer& a,
+           const FabArrayBase::CopyComTagsContainer& b)
+{
+    if (a.size() != b.size()) { return false; }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].dbox != b[i].dbox || a[i].sbox != b[i].sbox ||
+            a[i].dstIndex != b[i].dstIndex || a[i].srcIndex != b[i].srcIndex) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same (const FabArrayBase::MapOfCopyComTagContainers& a,
+           const FabArrayBase::MapOfCopyComTagContainers& b)
+{
+    if (a.size() != b.size()) { return false; }
+    for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+        if (ia->first != ib->first || !same(ia->second, ib->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the destination boxes of the tags are disjoint.  The thread safety
+// flags are only computed when there is more than one thread.
+bool disjoint (const FabArrayBase::CopyComTagsContainer& tags, IndexType typ)
+{
+    BoxList bl(typ);
+    for (auto const& tag : tags) { bl.push_back(tag.dbox); }
+    return bl.size() <= 1 || BoxArray(std::move(bl)).isDisjoint();
+}
+
+bool disjoint (const FabArrayBase::MapOfCopyComTagContainers& tags, IndexType typ)
+{
+    BoxList bl(typ);
+    for (auto const& kv : tags) {
+        for (auto const& tag : kv.second) { bl.push_back(tag.dbox); }
+    }
+    return bl.size() <= 1 || BoxArray(std::move(bl)).isDisjoint();
+}
+
+// Aborts unless the metadata built by make with nthreads threads is the
+// same as that built with one thread.
+template <class F>
+void check (F const& make, IndexType typ, int nthreads, const std::string& name)
+{
+    set_num_threads(1);
+    auto const ref_p = make();
+    set_num_threads(nthreads);
+    auto const md_p = make();
+    auto const& ref = *ref_p;
+    auto const& md = *md_p;
+
+    if (!same(*md.m_LocTags, *ref.m_LocTags)) {
+        amrex::Abort("ThreadedCommMetaData: local tags differ for " + name);
+    }
+    if (!same(*md.m_SndTags, *ref.m_SndTags)) {
+        amrex::Abort("ThreadedCommMetaData: send tags differ for " + name);
+    }
+    if (!same(*md.m_RcvTags, *ref.m_RcvTags)) {
+        amrex::Abort("ThreadedCommMetaData: receive tags differ for " + name);
+    }
+    if (nthreads > 1 &&
+        ((md.m_threadsafe_loc && !disjoint(*md.m_LocTags, typ)) ||
+         (md.m_threadsafe_rcv && !disjoint(*md.m_RcvTags, typ)))) {
+        amrex::Abort("ThreadedCommMetaData: overlapping tags flagged thread safe for " + name);
+    }
+
+    Long ntags = md.m_LocTags->size();
+    for (auto const& kv : *md.m_SndTags) { ntags += kv.second.size(); }
+    for (auto const& kv : *md.m_RcvTags) { ntags += kv.second.size(); }
+    ParallelDescriptor::ReduceLongSum(ntags);
+    amrex::Print() << name << ": " << ntags << " tags\n";
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 8;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+#ifdef AMREX_USE_OMP
+        const int nthreads = omp_get_max_threads();
+#else
+        const int nthreads = 1;
+#endif
+        amrex::Print() << "Comparing " << nthreads << " threads with 1 thread\n";
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        Geometry geom(domain, RealBox(AMREX_D_DECL(0.,0.,0.),AMREX_D_DECL(1.,1.,1.)),
+                      CoordSys::cartesian, {AMREX_D_DECL(1,1,1)});
+        const Periodicity& period = geom.periodicity();
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        for (auto const& typ : {IntVect(0), IntVect(1)})
+        {
+            const std::string t = (typ == IntVect(0)) ? " cell" : " node";
+            const IndexType ixtyp(typ);
+            MultiFab mf(amrex::convert(ba,typ), dm, 1, 2);
+
+            check([&] () {
+                return std::make_unique<FabArrayBase::FB>(mf, IntVect(2), false, period, false); },
+                ixtyp, nthreads, "FB" + t);
+            check([&] () {
+                return std::make_unique<FabArrayBase::FB>(mf, IntVect(1), true, period, false); },
+                ixtyp, nthreads, "FB cross" + t);
+            check([&] () {
+                return std::make_unique<FabArrayBase::FB>(mf, IntVect(2), false, period, false, true); },
+                ixtyp, nthreads, "FB multi ghost" + t);
+            check([&] () {
+                return std::make_unique<FabArrayBase::FB>(mf, IntVect(2), false, period, true); },
+                ixtyp, nthreads, "FB enforce periodicity only" + t);
+
+            BoxArray src_ba(amrex::convert(domain,typ));
+            src_ba.maxSize(max_grid_size*2);
+            Vector<int> pmap(src_ba.size());
+            for (int i = 0; i < src_ba.size(); ++i) {
+                pmap[i] = (i+1) % ParallelDescriptor::NProcs();
+            }
+            MultiFab src(src_ba, DistributionMapping(std::move(pmap)), 1, 1);
+
+            check([&] () {
+                return std::make_unique<FabArrayBase::CPC>(mf, IntVect(2), src, IntVect(1), period); },
+                ixtyp, nthreads, "CPC" + t);
+            check([&] () {
+                return std::make_unique<FabArrayBase::CPC>(mf, IntVect(2), src, IntVect(0), period, true); },
+                ixtyp, nthreads, "CPC to ghost cells only" + t);
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,117 @@
+//
+// Check that a MultiFab written with VisMF::Header::Compressed_v1 is read
+// back bitwise identical, for data that compresses well (constant and
+// smooth), data that does not (random bits) and special values (signed
+// zeros, denormals and the extreme finite values).  The data include the
+// ghost cells, and single components are also read with VisMF::readFAB.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 16)
+//     nfiles        : number of files written (default 2)
+//     vismf.compressionchunksize : number of values per compressed chunk
+//
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+
+using namespace amrex;
+
+namespace {
+
+// Component 0 is constant with special values sprinkled in, component 1 is
+// smooth and component 2 has random mantissas and exponents.
+void init (MultiFab& mf)
+{
+    const Real special[] = {Real(-0.0), std::numeric_limits<Real>::denorm_min(),
+                            std::numeric_limits<Real>::max(), std::numeric_limits<Real>::lowest(),
+                            std::numeric_limits<Real>::min(), std::numeric_limits<Real>::epsilon()};
+    const int nspecial = sizeof(special)/sizeof(special[0]);
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        FArrayBox& fab = mf[mfi];
+        std::mt19937_64 gen(mfi.index());
+        Real* p = fab.dataPtr();
+        const Long npts = fab.box().numPts();
+        for (Long i = 0; i < npts; ++i) {
+            p[i] = (i % 97 == 0) ? special[(i/97) % nspecial] : Real(3.0);
+            p[npts+i] = std::sin(Real(0.01)*Real(i + mfi.index()*npts));
+            Real r;
+            do {
+                auto bits = static_cast<std::uint64_t>(gen());
+                if (sizeof(Real) == 4) { bits >>= 32; }
+                std::memcpy(&r, &bits, sizeof(Real));
+            } while (!std::isfinite(r));
+            p[2*npts+i] = r;
+        }
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        int nfiles = 2;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nfiles", nfiles);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        MultiFab mf(ba, dm, ncomp, 1);
+        init(mf);
+
+        VisMF::SetNOutFiles(nfiles);
+        VisMF::SetHeaderVersion(VisMF::Header::Compressed_v1);
+        const std::string name = "vismf_compressed";
+        VisMF::Write(mf, name);
+
+        MultiFab mf2(ba, dm, ncomp, 1);
+        mf2.setVal(0.0);
+        VisMF::Read(mf2, name);
+
+        int nbad = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if (std::memcmp(mf[mfi].dataPtr(), mf2[mfi].dataPtr(), mf[mfi].nBytes()) != 0) {
+                ++nbad;
+            }
+        }
+
+        // One component of one FAB at a time
+        VisMF vismf(name);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            for (int n = 0; n < ncomp; ++n) {
+                std::unique_ptr<FArrayBox> fab(vismf.readFAB(mfi.index(), n));
+                if (fab->box() != mf[mfi].box() ||
+                    std::memcmp(fab->dataPtr(), mf[mfi].dataPtr(n), fab->nBytes()) != 0) {
+                    ++nbad;
+                }
+            }
+        }
+
+        ParallelDescriptor::ReduceIntSum(nbad);
+        amrex::Print() << "Compressed_v1 round trip: " << nbad << " mismatches\n";
+        if (nbad > 0) {
+            amrex::Abort("VisMFCompressed: the data read back differ from the data written");
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,219 @@
+//
+// Check the delta writes of VisMF::WriteDelta with the directory layout of
+// checkpoints, chk<step>/Level_0/SD, written to a temporary directory that
+// is renamed afterwards like Amr::checkPoint does:
+//   - unchanged FABs refer to the files of an earlier checkpoint with
+//     ../../chk<step>/Level_0/SD_D_<n> paths,
+//   - chains of deltas are collapsed, i.e., a FAB always refers to the
+//     checkpoint that holds its data, not to one that refers to it again,
+//   - every checkpoint reads back bitwise identical to what was written, and
+//   - if the earlier checkpoint, or an older one it refers to, is gone, all
+//     FABs are written again.
+//
+// Runtime parameters:
+//     n_cell        : number of cells in each direction of the domain (default 32)
+//     max_grid_size : max_grid_size used to chop the domain (default 16)
+//     vismf.headerversion : the VisMF header version
+//
+#include <AMReX.H>
+#include <AMReX_FileSystem.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace amrex;
+
+namespace {
+
+std::string chk_name (int step) { return amrex::Concatenate("delta_chk", step, 2); }
+
+std::string mf_name (const std::string& chk) { return chk + "/Level_0/SD"; }
+
+// Writes mf as checkpoint step, like Amr::checkPoint, into a temporary
+// directory that is renamed to the final name.
+void write_chk (const MultiFab& mf, int step, VisMF::DeltaState& state)
+{
+    const std::string chk = chk_name(step);
+    const std::string tmp = chk + ".temp";
+    if (ParallelDescriptor::IOProcessor()) {
+        FileSystem::RemoveAll(chk);
+        FileSystem::RemoveAll(tmp);
+        if (!FileSystem::CreateDirectories(tmp + "/Level_0", 0755)) {
+            amrex::CreateDirectoryFailed(tmp + "/Level_0");
+        }
+    }
+    ParallelDescriptor::Barrier();
+    VisMF::WriteDelta(mf, mf_name(tmp), state, mf_name(chk));
+    ParallelDescriptor::Barrier();
+    if (ParallelDescriptor::IOProcessor()) {
+        std::rename(tmp.c_str(), chk.c_str());
+    }
+    ParallelDescriptor::Barrier();
+}
+
+// The data file of each FAB in the header of checkpoint step.
+Vector<std::string> fab_files (int step)
+{
+    Vector<std::string> files;
+    std::ifstream ifs(mf_name(chk_name(step)) + "_H");
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream is(line);
+        std::string prefix, name;
+        is >> prefix >> name;
+        if (prefix == "FabOnDisk:") {
+            files.push_back(name);
+        }
+    }
+    return files;
+}
+
+// Aborts unless FAB i of checkpoint step is stored in checkpoint
+// stored_in[i], which is step itself for the FABs written by it.
+void check_refs (int step, const Vector<int>& stored_in)
+{
+    Vector<std::string> files = fab_files(step);
+    if (files.size() != stored_in.size()) {
+        amrex::Abort("VisMFDelta: wrong number of FABs in the header of " + chk_name(step));
+    }
+    for (int i = 0, N = files.size(); i < N; ++i) {
+        const std::string prefix = (stored_in[i] == step) ? std::string("SD_D_")
+            : "../../" + chk_name(stored_in[i]) + "/Level_0/SD_D_";
+        if (files[i].compare(0, prefix.size(), prefix) != 0 ||
+            files[i].find('/', prefix.size()) != std::string::npos) {
+            amrex::Abort("VisMFDelta: FAB " + std::to_string(i) + " of " + chk_name(step)
+                         + " is " + files[i] + ", expected " + prefix + "*");
+        }
+    }
+}
+
+// Aborts unless checkpoint step reads back bitwise identical to mf.
+void check_read (const MultiFab& mf, int step)
+{
+    MultiFab mf2(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrowVect());
+    mf2.setVal(0.0);
+    VisMF::Read(mf2, mf_name(chk_name(step)));
+    int nbad = 0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        if (std::memcmp(mf[mfi].dataPtr(), mf2[mfi].dataPtr(), mf[mfi].nBytes()) != 0) {
+            ++nbad;
+        }
+    }
+    ParallelDescriptor::ReduceIntSum(nbad);
+    if (nbad > 0) {
+        amrex::Abort("VisMFDelta: " + chk_name(step) + " does not read back what was written");
+    }
+}
+
+// Changes FAB i of mf.
+void change_fab (MultiFab& mf, int i)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        if (mfi.index() == i) {
+            mf[mfi].plus<RunOn::Host>(1.0);
+        }
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        const int nboxes = ba.size();
+        AMREX_ALWAYS_ASSERT(nboxes >= 3);
+
+        MultiFab mf(ba, dm, 2, 1);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            mf[mfi].setVal<RunOn::Host>(Real(mfi.index()));
+        }
+
+        VisMF::SetNOutFiles(2);
+        VisMF::DeltaState state;
+
+        // The first checkpoint writes every FAB.
+        Vector<int> stored_in(nboxes, 0);
+        write_chk(mf, 0, state);
+        check_refs(0, stored_in);
+        check_read(mf, 0);
+
+        // Only FAB 0 changes.
+        change_fab(mf, 0);
+        write_chk(mf, 1, state);
+        stored_in[0] = 1;
+        check_refs(1, stored_in);
+        check_read(mf, 1);
+
+        // Only FAB 1 changes.  FAB 0 refers to checkpoint 1 and the others
+        // still refer to checkpoint 0, not to checkpoint 1.
+        change_fab(mf, 1);
+        write_chk(mf, 2, state);
+        stored_in[1] = 2;
+        check_refs(2, stored_in);
+        check_read(mf, 2);
+
+        // Nothing changes.
+        write_chk(mf, 3, state);
+        check_refs(3, stored_in);
+        check_read(mf, 3);
+
+        // The earlier checkpoints are all still needed.
+        check_read(mf, 2);
+
+        // The last checkpoint is renamed, so the next one cannot refer to it
+        // and writes every FAB again.
+        ParallelDescriptor::Barrier();
+        if (ParallelDescriptor::IOProcessor()) {
+            FileSystem::RemoveAll(chk_name(3) + ".moved");
+            std::rename(chk_name(3).c_str(), (chk_name(3) + ".moved").c_str());
+        }
+        ParallelDescriptor::Barrier();
+        change_fab(mf, 2);
+        write_chk(mf, 4, state);
+        check_refs(4, Vector<int>(nboxes, 4));
+        check_read(mf, 4);
+
+        // Only FAB 0 changes, so checkpoint 5 refers to checkpoint 4.
+        change_fab(mf, 0);
+        write_chk(mf, 5, state);
+        stored_in.assign(nboxes, 4);
+        stored_in[0] = 5;
+        check_refs(5, stored_in);
+        check_read(mf, 5);
+
+        // Checkpoint 4 is removed, but the header of checkpoint 5 is still
+        // there.  The next one cannot refer to the files of checkpoint 4 and
+        // writes every FAB again.
+        ParallelDescriptor::Barrier();
+        if (ParallelDescriptor::IOProcessor()) {
+            FileSystem::RemoveAll(chk_name(4));
+        }
+        ParallelDescriptor::Barrier();
+        change_fab(mf, 1);
+        write_chk(mf, 6, state);
+        check_refs(6, Vector<int>(nboxes, 6));
+        check_read(mf, 6);
+
+        amrex::Print() << "VisMFDelta: all checks passed\n";
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,119 @@
+//
+// Compare the write throughput of VisMF::Write in the regular NFiles mode
+// with the two-phase aggregated mode (vismf.usetwophasewrite), e.g.,
+//
+//     mpiexec -n 16 main3d.gnu.TPROF.MPI.ex inputs nfiles=4 stripe_size=4194304
+//
+// Runtime parameters:
+//     ncells        : number of cells in each direction of the domain
+//     max_grid_size : max_grid_size used to chop the domain
+//     ncomp         : number of components
+//     nwrites       : number of timed writes for each mode (default 3)
+//     nfiles        : number of files written (default 4)
+//     stripe_size   : size in bytes of the aggregators' writes (default 1048576)
+//     check         : if true, read back both outputs and compare them (default 1)
+//     directory     : where the files are written (default .)
+//
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+#include <AMReX_VisMF.H>
+
+using namespace amrex;
+
+namespace {
+
+double timeWrites (const MultiFab& mf, const std::string& name, int nwrites, bool twophase)
+{
+    VisMF::SetUseTwoPhaseWrite(twophase);
+    double tmin = std::numeric_limits<double>::max();
+    for (int i = 0; i < nwrites; ++i) {
+        ParallelDescriptor::Barrier();
+        double t0 = amrex::second();
+        VisMF::Write(mf, name);
+        ParallelDescriptor::Barrier();
+        double t = amrex::second() - t0;
+        ParallelDescriptor::ReduceRealMax(t);
+        tmin = std::min(tmin, t);
+    }
+    return tmin;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int ncells = 128;
+        int max_grid_size = 32;
+        int ncomp = 4;
+        int nwrites = 3;
+        int nfiles = 4;
+        Long stripe_size = 1048576;
+        int check = 1;
+        std::string directory = ".";
+        {
+            ParmParse pp;
+            pp.query("ncells", ncells);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ncomp", ncomp);
+            pp.query("nwrites", nwrites);
+            pp.query("nfiles", nfiles);
+            pp.query("stripe_size", stripe_size);
+            pp.query("check", check);
+            pp.query("directory", directory);
+        }
+
+        Box domain(IntVect(0), IntVect(ncells-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, ncomp, 0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            auto const& a = mf.array(mfi);
+            amrex::ParallelFor(mfi.validbox(), ncomp,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+            {
+                a(i,j,k,n) = static_cast<Real>(i + 2*j + 3*k + 4*n) * 0.001_rt;
+            });
+        }
+
+        VisMF::SetNOutFiles(nfiles);
+        VisMF::SetStripeSize(stripe_size);
+
+        const std::string nfiles_name = directory + "/vismf_nfiles";
+        const std::string twophase_name = directory + "/vismf_twophase";
+
+        const double t_nfiles = timeWrites(mf, nfiles_name, nwrites, false);
+        const double t_twophase = timeWrites(mf, twophase_name, nwrites, true);
+
+        const double gb = static_cast<double>(mf.boxArray().numPts()) * ncomp
+            * FArrayBox::getDataDescriptor()->numBytes() / (1024.*1024.*1024.);
+
+        amrex::Print() << "\nWrote " << gb << " GB to " << VisMF::GetNOutFiles()
+                       << " files from " << ParallelDescriptor::NProcs() << " ranks\n"
+                       << "    NFiles    : " << t_nfiles << " s, "
+                       << gb/t_nfiles << " GB/s\n"
+                       << "    two-phase : " << t_twophase << " s, "
+                       << gb/t_twophase << " GB/s\n";
+
+        if (check) {
+            MultiFab mf_nfiles(ba, dm, ncomp, 0);
+            MultiFab mf_twophase(ba, dm, ncomp, 0);
+            VisMF::Read(mf_nfiles, nfiles_name);
+            VisMF::Read(mf_twophase, twophase_name);
+            // Both modes write the same bytes, also for lossy formats
+            MultiFab::Subtract(mf_twophase, mf_nfiles, 0, 0, ncomp, 0);
+            const Real err = mf_twophase.norminf(0, ncomp, IntVect(0));
+            amrex::Print() << "    max difference after reading back: " << err << "\n";
+            if (err != 0.0_rt) {
+                amrex::Abort("VisMFTwoPhaseWrite: data read back do not match");
+            }
+        }
+    }
+    amrex::Finalize();
+}